@@ -79,13 +79,13 @@ atomic_sub_uint64(uint64_t *p, uint64_t x)
 ATOMIC_INLINE uint64_t
 atomic_add_uint64(uint64_t *p, uint64_t x)
 {
-	return (InterlockedExchangeAdd64(p, x));
+	return (InterlockedExchangeAdd64((int64_t *)p, (int64_t)x));
 }
 
 ATOMIC_INLINE uint64_t
 atomic_sub_uint64(uint64_t *p, uint64_t x)
 {
-	return (InterlockedExchangeAdd64(p, -((int64_t)x)));
+	return (InterlockedExchangeAdd64((int64_t *)p, -((int64_t)x)));
 }
 #elif (defined(__APPLE__))
 ATOMIC_INLINE uint64_t
@@ -177,13 +177,13 @@ atomic_sub_uint32(uint32_t *p, uint32_t x)
 ATOMIC_INLINE uint32_t
 atomic_add_uint32(uint32_t *p, uint32_t x)
 {
-	return (InterlockedExchangeAdd(p, x));
+	return (InterlockedExchangeAdd((long *)p, (long)x));
 }
 
 ATOMIC_INLINE uint32_t
 atomic_sub_uint32(uint32_t *p, uint32_t x)
 {
-	return (InterlockedExchangeAdd(p, -((int32_t)x)));
+	return (InterlockedExchangeAdd((long *)p, -((long)x)));
 }
 #elif (defined(__APPLE__))
 ATOMIC_INLINE uint32_t
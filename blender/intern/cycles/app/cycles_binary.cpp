@@ -0,0 +1,512 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "attribute.h"
+#include "mesh.h"
+#include "object.h"
+#include "shader.h"
+#include "scene.h"
+
+#include "util_foreach.h"
+#include "util_string.h"
+#include "util_transform.h"
+#include "util_vector.h"
+
+#include "cycles_binary.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Memory Mapped File */
+
+class BinaryFile {
+public:
+	BinaryFile()
+	{
+		data = NULL;
+		size = 0;
+#ifdef _WIN32
+		file = INVALID_HANDLE_VALUE;
+		mapping = NULL;
+#endif
+	}
+
+	~BinaryFile()
+	{
+		close();
+	}
+
+	bool open(const char *filepath)
+	{
+#ifdef _WIN32
+		file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+		if(file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER file_size;
+
+		if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+			return false;
+
+		mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if(!mapping)
+			return false;
+
+		data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		size = (size_t)file_size.QuadPart;
+#else
+		int fd = ::open(filepath, O_RDONLY);
+
+		if(fd == -1)
+			return false;
+
+		struct stat st;
+
+		if(fstat(fd, &st) != 0 || st.st_size == 0) {
+			::close(fd);
+			return false;
+		}
+
+		void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		/* mapping stays valid after closing the file */
+		::close(fd);
+
+		if(mem == MAP_FAILED)
+			return false;
+
+		/* arrays are read front to back */
+		madvise(mem, st.st_size, MADV_SEQUENTIAL);
+
+		data = (const char*)mem;
+		size = st.st_size;
+#endif
+
+		return (data != NULL);
+	}
+
+	void close()
+	{
+#ifdef _WIN32
+		if(data)
+			UnmapViewOfFile(data);
+		if(mapping)
+			CloseHandle(mapping);
+		if(file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+
+		file = INVALID_HANDLE_VALUE;
+		mapping = NULL;
+#else
+		if(data)
+			munmap((void*)data, size);
+#endif
+
+		data = NULL;
+		size = 0;
+	}
+
+	const char *data;
+	size_t size;
+
+protected:
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+};
+
+/* Binary reading state */
+
+struct BinaryReadState {
+	Scene *scene;			/* scene pointer */
+	Transform tfm;			/* transform of file */
+	int default_shader;		/* shader file was included with */
+	int shader;				/* current shader */
+	size_t remaining;		/* file size after the current chunk */
+	bool smooth;			/* smooth normal state */
+	Mesh::DisplacementMethod displacement_method;
+
+	vector<Mesh*> meshes;	/* meshes in file order */
+	Mesh *mesh;				/* current mesh */
+};
+
+/* Chunks */
+
+static bool binary_chunk_size_check(const BinaryChunk *chunk, size_t elem_size, size_t num)
+{
+	if(chunk->count != num || chunk->size != elem_size*num) {
+		fprintf(stderr, "Binary chunk of type %u has invalid size.\n", chunk->type);
+		return false;
+	}
+
+	return true;
+}
+
+static bool binary_read_shader(BinaryReadState& state, const BinaryChunk *chunk, const char *data)
+{
+	string name(data, chunk->size);
+	int i = 0;
+
+	if(name.empty()) {
+		state.shader = state.default_shader;
+		return true;
+	}
+
+	foreach(Shader *shader, state.scene->shaders) {
+		if(shader->name == name) {
+			state.shader = i;
+			return true;
+		}
+
+		i++;
+	}
+
+	fprintf(stderr, "Unknown shader \"%s\".\n", name.c_str());
+	return true;
+}
+
+static bool binary_read_state(BinaryReadState& state, const BinaryChunk *chunk, const char *data)
+{
+	if(!binary_chunk_size_check(chunk, sizeof(BinaryState), 1))
+		return false;
+
+	const BinaryState *bstate = (const BinaryState*)data;
+
+	if(bstate->displacement_method > Mesh::DISPLACE_BOTH) {
+		fprintf(stderr, "Unknown displacement method %u.\n", bstate->displacement_method);
+		return false;
+	}
+
+	state.smooth = (bstate->smooth != 0);
+	state.displacement_method = (Mesh::DisplacementMethod)bstate->displacement_method;
+
+	return true;
+}
+
+static bool binary_read_mesh(BinaryReadState& state, const BinaryChunk *chunk, const char *data)
+{
+	if(!binary_chunk_size_check(chunk, sizeof(BinaryMesh), 1))
+		return false;
+
+	const BinaryMesh *bmesh = (const BinaryMesh*)data;
+
+	/* array chunks follow, so their data must fit in the rest of the file */
+	uint64_t mesh_size = (uint64_t)bmesh->num_verts*sizeof(float4) +
+	                     (uint64_t)bmesh->num_triangles*sizeof(int)*3 +
+	                     (uint64_t)bmesh->num_curve_keys*sizeof(float4) +
+	                     (uint64_t)bmesh->num_curves*sizeof(int)*2;
+
+	if(mesh_size > state.remaining) {
+		fprintf(stderr, "Binary mesh is larger than file.\n");
+		return false;
+	}
+
+	Mesh *mesh = new Mesh();
+	state.scene->meshes.push_back(mesh);
+	state.meshes.push_back(mesh);
+	state.mesh = mesh;
+
+	mesh->used_shaders.push_back(state.shader);
+	mesh->displacement_method = state.displacement_method;
+
+	/* allocate all arrays once, chunks are copied into them */
+	mesh->reserve(bmesh->num_verts, bmesh->num_triangles, bmesh->num_curves, bmesh->num_curve_keys);
+
+	std::fill(mesh->shader.begin(), mesh->shader.end(), state.shader);
+	std::fill(mesh->smooth.begin(), mesh->smooth.end(), state.smooth);
+
+	for(size_t i = 0; i < mesh->curves.size(); i++)
+		mesh->curves[i].shader = state.shader;
+
+	return true;
+}
+
+static bool binary_read_verts(BinaryReadState& state, const BinaryChunk *chunk, const char *data)
+{
+	Mesh *mesh = state.mesh;
+
+	/* float3 has the same layout as float4 */
+	if(!binary_chunk_size_check(chunk, sizeof(float4), mesh->verts.size()))
+		return false;
+
+	if(mesh->verts.size())
+		memcpy(&mesh->verts[0], data, chunk->size);
+
+	return true;
+}
+
+static bool binary_read_triangles(BinaryReadState& state, const BinaryChunk *chunk, const char *data)
+{
+	Mesh *mesh = state.mesh;
+	size_t num_verts = mesh->verts.size();
+
+	if(!binary_chunk_size_check(chunk, sizeof(int)*3, mesh->triangles.size()))
+		return false;
+
+	const int *index = (const int*)data;
+
+	for(size_t i = 0; i < chunk->count*3; i++) {
+		if(index[i] < 0 || (size_t)index[i] >= num_verts) {
+			fprintf(stderr, "Binary mesh triangle has invalid vertex index.\n");
+			return false;
+		}
+	}
+
+	if(mesh->triangles.size())
+		memcpy(&mesh->triangles[0], data, chunk->size);
+
+	return true;
+}
+
+static bool binary_read_curve_keys(BinaryReadState& state, const BinaryChunk *chunk, const char *data)
+{
+	Mesh *mesh = state.mesh;
+
+	if(!binary_chunk_size_check(chunk, sizeof(float4), mesh->curve_keys.size()))
+		return false;
+
+	const float4 *key = (const float4*)data;
+
+	for(size_t i = 0; i < chunk->count; i++) {
+		mesh->curve_keys[i].co = make_float3(key[i].x, key[i].y, key[i].z);
+		mesh->curve_keys[i].radius = key[i].w;
+	}
+
+	return true;
+}
+
+static bool binary_read_curves(BinaryReadState& state, const BinaryChunk *chunk, const char *data)
+{
+	Mesh *mesh = state.mesh;
+	size_t num_keys = mesh->curve_keys.size();
+
+	if(!binary_chunk_size_check(chunk, sizeof(int)*2, mesh->curves.size()))
+		return false;
+
+	const int *curve = (const int*)data;
+
+	for(size_t i = 0; i < chunk->count; i++) {
+		int first_key = curve[i*2 + 0];
+		int num_curve_keys = curve[i*2 + 1];
+
+		if(first_key < 0 || num_curve_keys < 2 || (size_t)(first_key + num_curve_keys) > num_keys) {
+			fprintf(stderr, "Binary mesh curve has invalid keys.\n");
+			return false;
+		}
+
+		mesh->curves[i].first_key = first_key;
+		mesh->curves[i].num_keys = num_curve_keys;
+	}
+
+	return true;
+}
+
+static bool binary_read_attribute(BinaryReadState& state, const BinaryChunk *chunk, const char *data)
+{
+	Mesh *mesh = state.mesh;
+
+	if(chunk->size < sizeof(BinaryAttribute))
+		return binary_chunk_size_check(chunk, sizeof(BinaryAttribute), 1);
+
+	const BinaryAttribute *battr = (const BinaryAttribute*)data;
+	string name(battr->name, strnlen(battr->name, BINARY_NAME_SIZE));
+
+	bool curve = (battr->element == ATTR_ELEMENT_CURVE || battr->element == ATTR_ELEMENT_CURVE_KEY);
+	AttributeSet& attributes = (curve)? mesh->curve_attributes: mesh->attributes;
+	Attribute *attr = NULL;
+
+	if(battr->standard) {
+		/* standard attributes are stored by name, to not depend on enum values */
+		for(int std = ATTR_STD_NONE + 1; std < ATTR_STD_NUM; std++) {
+			if(name == Attribute::standard_name((AttributeStandard)std)) {
+				attr = attributes.add((AttributeStandard)std);
+				break;
+			}
+		}
+	}
+	else if(battr->element > ATTR_ELEMENT_NONE && battr->element <= ATTR_ELEMENT_CURVE_KEY) {
+		TypeDesc type;
+
+		switch(battr->type) {
+			case BINARY_ATTR_FLOAT: type = TypeDesc::TypeFloat; break;
+			case BINARY_ATTR_COLOR: type = TypeDesc::TypeColor; break;
+			case BINARY_ATTR_VECTOR: type = TypeDesc::TypeVector; break;
+			case BINARY_ATTR_NORMAL: type = TypeDesc::TypeNormal; break;
+			default: type = TypeDesc::TypePoint; break;
+		}
+
+		attr = attributes.add(ustring(name), type, (AttributeElement)battr->element);
+	}
+
+	if(!attr) {
+		fprintf(stderr, "Unknown binary mesh attribute \"%s\".\n", name.c_str());
+		return true;
+	}
+
+	/* size of data must match storage of attribute */
+	size_t elem_size = attr->data_sizeof();
+	size_t num = attr->buffer.size()/elem_size;
+
+	if(chunk->count != num || chunk->size != sizeof(BinaryAttribute) + elem_size*num) {
+		fprintf(stderr, "Binary mesh attribute \"%s\" has invalid size.\n", name.c_str());
+		return false;
+	}
+
+	if(attr->buffer.size())
+		memcpy(attr->data(), data + sizeof(BinaryAttribute), attr->buffer.size());
+
+	return true;
+}
+
+static bool binary_read_objects(BinaryReadState& state, const BinaryChunk *chunk, const char *data)
+{
+	if(!binary_chunk_size_check(chunk, sizeof(BinaryObject), chunk->count))
+		return false;
+
+	const BinaryObject *bobject = (const BinaryObject*)data;
+
+	for(size_t i = 0; i < chunk->count; i++) {
+		if(bobject[i].mesh >= state.meshes.size()) {
+			fprintf(stderr, "Binary object has invalid mesh index.\n");
+			return false;
+		}
+
+		Transform tfm;
+		memcpy(&tfm, bobject[i].tfm, sizeof(tfm));
+
+		Object *object = new Object();
+		object->mesh = state.meshes[bobject[i].mesh];
+		object->tfm = state.tfm * tfm;
+		state.scene->objects.push_back(object);
+	}
+
+	return true;
+}
+
+static bool binary_read_chunk(BinaryReadState& state, const BinaryChunk *chunk, const char *data)
+{
+	switch(chunk->type) {
+		case BINARY_CHUNK_SHADER:
+			return binary_read_shader(state, chunk, data);
+		case BINARY_CHUNK_STATE:
+			return binary_read_state(state, chunk, data);
+		case BINARY_CHUNK_MESH:
+			return binary_read_mesh(state, chunk, data);
+		case BINARY_CHUNK_OBJECTS:
+			return binary_read_objects(state, chunk, data);
+		default:
+			break;
+	}
+
+	if(!state.mesh) {
+		fprintf(stderr, "Binary chunk of type %u without mesh.\n", chunk->type);
+		return false;
+	}
+
+	switch(chunk->type) {
+		case BINARY_CHUNK_VERTS:
+			return binary_read_verts(state, chunk, data);
+		case BINARY_CHUNK_TRIANGLES:
+			return binary_read_triangles(state, chunk, data);
+		case BINARY_CHUNK_CURVE_KEYS:
+			return binary_read_curve_keys(state, chunk, data);
+		case BINARY_CHUNK_CURVES:
+			return binary_read_curves(state, chunk, data);
+		case BINARY_CHUNK_ATTRIBUTE:
+			return binary_read_attribute(state, chunk, data);
+		default:
+			/* skip unknown chunks, for forward compatibility */
+			return true;
+	}
+}
+
+/* File */
+
+bool binary_read_file(Scene *scene, const char *filepath, const Transform& tfm, int shader)
+{
+	BinaryFile file;
+
+	if(!file.open(filepath)) {
+		fprintf(stderr, "%s read error: could not map file\n", filepath);
+		return false;
+	}
+
+	const BinaryHeader *header = (const BinaryHeader*)file.data;
+
+	if(file.size < sizeof(BinaryHeader) || memcmp(header->magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+		fprintf(stderr, "%s read error: not a binary scene file\n", filepath);
+		return false;
+	}
+
+	if(header->version != BINARY_VERSION) {
+		fprintf(stderr, "%s read error: unsupported version %u\n", filepath, header->version);
+		return false;
+	}
+
+	BinaryReadState state;
+
+	state.scene = scene;
+	state.tfm = tfm;
+	state.default_shader = shader;
+	state.shader = shader;
+	state.remaining = 0;
+	state.smooth = false;
+	state.displacement_method = Mesh::DISPLACE_BUMP;
+	state.mesh = NULL;
+
+	size_t offset = sizeof(BinaryHeader);
+
+	while(offset + sizeof(BinaryChunk) <= file.size) {
+		const BinaryChunk *chunk = (const BinaryChunk*)(file.data + offset);
+		offset += sizeof(BinaryChunk);
+
+		if(chunk->size > file.size - offset) {
+			fprintf(stderr, "%s read error: truncated file\n", filepath);
+			return false;
+		}
+
+		state.remaining = file.size - offset - chunk->size;
+
+		if(!binary_read_chunk(state, chunk, file.data + offset)) {
+			fprintf(stderr, "%s read error: invalid chunk\n", filepath);
+			return false;
+		}
+
+		offset += chunk->size;
+		offset = (offset + BINARY_ALIGN - 1) & ~(size_t)(BINARY_ALIGN - 1);
+	}
+
+	return true;
+}
+
+CCL_NAMESPACE_END
+
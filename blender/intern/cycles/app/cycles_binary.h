@@ -0,0 +1,111 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#ifndef __CYCLES_BINARY__
+#define __CYCLES_BINARY__
+
+#include "util_transform.h"
+#include "util_types.h"
+
+CCL_NAMESPACE_BEGIN
+
+class Scene;
+
+/* Binary Scene File
+ *
+ * Geometry for large scenes, memory mapped and copied into meshes and objects
+ * without parsing. Shaders, camera and other settings are still read from XML,
+ * which can include a binary file like any other file.
+ *
+ * The file starts with a BinaryHeader, followed by chunks. Each chunk is a
+ * BinaryChunk header followed by size bytes of data, padded to 16 bytes so
+ * all arrays are aligned. Data chunks apply to the last mesh chunk. An empty
+ * shader name selects the shader the file was included with.
+ *
+ * Files with the .cyb extension can be passed to the standalone application
+ * directly or through an XML include, and are written by the exporter in
+ * io_export_cycles_binary.py. */
+
+#define BINARY_FILE_EXTENSION ".cyb"
+#define BINARY_MAGIC "CYCLESB"
+#define BINARY_VERSION 1
+#define BINARY_ALIGN 16
+#define BINARY_NAME_SIZE 64
+
+enum BinaryChunkType {
+	BINARY_CHUNK_SHADER = 1,		/* shader name for next meshes, empty for default */
+	BINARY_CHUNK_STATE,				/* BinaryState for next meshes */
+	BINARY_CHUNK_MESH,				/* BinaryMesh, starts a new mesh */
+	BINARY_CHUNK_VERTS,				/* float4 xyz per vertex */
+	BINARY_CHUNK_TRIANGLES,			/* int3 vertex indices per triangle */
+	BINARY_CHUNK_CURVE_KEYS,		/* float4 xyz and radius per curve key */
+	BINARY_CHUNK_CURVES,			/* int2 first key and number of keys per curve */
+	BINARY_CHUNK_ATTRIBUTE,			/* BinaryAttribute followed by data */
+	BINARY_CHUNK_OBJECTS			/* BinaryObject per object */
+};
+
+enum BinaryAttributeType {
+	BINARY_ATTR_FLOAT = 0,			/* float per element */
+	BINARY_ATTR_COLOR,				/* float4 per element, for all others */
+	BINARY_ATTR_VECTOR,
+	BINARY_ATTR_NORMAL,
+	BINARY_ATTR_POINT
+};
+
+struct BinaryHeader {
+	char magic[8];
+	uint version;
+	uint pad;
+};
+
+struct BinaryChunk {
+	uint type;
+	uint count;
+	uint64_t size;
+};
+
+struct BinaryState {
+	uint smooth;
+	uint displacement_method;
+};
+
+struct BinaryMesh {
+	uint num_verts;
+	uint num_triangles;
+	uint num_curve_keys;
+	uint num_curves;
+};
+
+struct BinaryAttribute {
+	char name[BINARY_NAME_SIZE];	/* standard attribute name if standard is set */
+	uint standard;
+	uint type;						/* BinaryAttributeType */
+	uint element;					/* AttributeElement */
+	uint pad;
+};
+
+struct BinaryObject {
+	float tfm[16];					/* row major */
+	uint mesh;						/* index of mesh in file */
+	uint pad[3];
+};
+
+bool binary_read_file(Scene *scene, const char *filepath, const Transform& tfm, int shader);
+
+CCL_NAMESPACE_END
+
+#endif /* __CYCLES_BINARY__ */
+
@@ -28,6 +28,7 @@
 #include "util_path.h"
 #include "util_progress.h"
 #include "util_string.h"
+#include "util_system.h"
 #include "util_time.h"
 
 #ifdef WITH_CYCLES_STANDALONE_GUI
@@ -236,7 +237,7 @@ static void options_parse(int argc, const char **argv)
 	ArgParse ap;
 	bool help = false;
 
-	ap.options ("Usage: cycles [options] file.xml",
+	ap.options ("Usage: cycles [options] file.xml|file.cyb",
 		"%*", files_parse, "",
 		"--device %s", &devicename, ("Devices to use: " + device_names).c_str(),
 		"--shadingsys %s", &ssname, "Shading system to use: svm, osl",
@@ -245,6 +246,7 @@ static void options_parse(int argc, const char **argv)
 		"--samples %d", &options.session_params.samples, "Number of samples to render",
 		"--output %s", &options.session_params.output_path, "File path to write output image",
 		"--threads %d", &options.session_params.threads, "CPU Rendering Threads",
+		"--stats %s", &options.session_params.stats_path, "File path to write render statistics as JSON, if built with WITH_CYCLES_STATS",
 		"--width  %d", &options.width, "Window width in pixel",
 		"--height %d", &options.height, "Window height in pixel",
 		"--list-devices", &list, "List information about all available devices",
@@ -327,6 +329,9 @@ static void options_parse(int argc, const char **argv)
 		exit(EXIT_FAILURE);
 	}
 
+	/* QBVH traversal is only implemented in the CPU kernels */
+	options.scene_params.use_qbvh = (options.session_params.device.type == DEVICE_CPU) && system_cpu_support_sse2();
+
 	/* load scene */
 	scene_init(options.width, options.height);
 }
@@ -41,6 +41,7 @@
 #include "util_transform.h"
 #include "util_xml.h"
 
+#include "cycles_binary.h"
 #include "cycles_xml.h"
 
 CCL_NAMESPACE_BEGIN
@@ -942,13 +943,28 @@ static void xml_read_scene(const XMLReadState& state, pugi::xml_node scene_node)
 
 /* Include */
 
+static bool xml_is_binary_file(const string& path)
+{
+	const string ext = BINARY_FILE_EXTENSION;
+
+	return (path.size() > ext.size() &&
+	        string_iequals(path.substr(path.size() - ext.size()), ext));
+}
+
 static void xml_read_include(const XMLReadState& state, const string& src)
 {
+	string path = path_join(state.base, src);
+
+	/* binary geometry file, read with current transform and shader */
+	if(xml_is_binary_file(path)) {
+		binary_read_file(state.scene, path.c_str(), state.tfm, state.shader);
+		return;
+	}
+
 	/* open XML document */
 	pugi::xml_document doc;
 	pugi::xml_parse_result parse_result;
 
-	string path = path_join(state.base, src);
 	parse_result = doc.load_file(path.c_str());
 
 	if(parse_result) {
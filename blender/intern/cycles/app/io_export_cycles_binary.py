@@ -0,0 +1,158 @@
+#
+# Copyright 2011-2013 Blender Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License
+#
+
+# Binary geometry exporter for rendering large scenes with the standalone
+# application, see cycles_binary.h for the file layout. Not intended for end
+# users, shaders are matched by material name to shaders defined in XML.
+
+import struct
+from array import array
+
+import bpy
+from bpy_extras.io_utils import ExportHelper
+
+BINARY_MAGIC = b"CYCLESB"
+BINARY_VERSION = 1
+BINARY_ALIGN = 16
+BINARY_NAME_SIZE = 64
+
+BINARY_CHUNK_SHADER = 1
+BINARY_CHUNK_STATE = 2
+BINARY_CHUNK_MESH = 3
+BINARY_CHUNK_VERTS = 4
+BINARY_CHUNK_TRIANGLES = 5
+BINARY_CHUNK_CURVE_KEYS = 6
+BINARY_CHUNK_CURVES = 7
+BINARY_CHUNK_ATTRIBUTE = 8
+BINARY_CHUNK_OBJECTS = 9
+
+ATTR_ELEMENT_CORNER = 4
+
+
+class BinaryWriter:
+    def __init__(self, fname):
+        self.f = open(fname, "wb")
+        self.f.write(struct.pack("<8sII", BINARY_MAGIC, BINARY_VERSION, 0))
+
+    def chunk(self, type, count, data):
+        self.f.write(struct.pack("<IIQ", type, count, len(data)))
+        self.f.write(data)
+
+        padding = -len(data) % BINARY_ALIGN
+        self.f.write(b"\0" * padding)
+
+    def close(self):
+        self.f.close()
+
+
+def write_mesh(writer, mesh):
+    # shader and smooth state, always written so meshes without material do
+    # not use the shader of the previous mesh, empty name is default shader
+    if len(mesh.materials) and mesh.materials[0]:
+        writer.chunk(BINARY_CHUNK_SHADER, 1, mesh.materials[0].name.encode())
+    else:
+        writer.chunk(BINARY_CHUNK_SHADER, 1, b"")
+
+    smooth = any(p.use_smooth for p in mesh.polygons)
+    writer.chunk(BINARY_CHUNK_STATE, 1, struct.pack("<II", smooth, 0))
+
+    # triangulate polygons as fans, same as the XML reader
+    triangles = array("i")
+    loops = []
+
+    for p in mesh.polygons:
+        vs = p.vertices
+        ls = p.loop_indices
+
+        for j in range(len(vs) - 2):
+            triangles.extend((vs[0], vs[j + 1], vs[j + 2]))
+            loops.extend((ls[0], ls[j + 1], ls[j + 2]))
+
+    num_triangles = len(triangles) // 3
+
+    verts = array("f")
+    for v in mesh.vertices:
+        verts.extend((v.co[0], v.co[1], v.co[2], 0.0))
+
+    writer.chunk(BINARY_CHUNK_MESH, 1, struct.pack("<IIII", len(mesh.vertices), num_triangles, 0, 0))
+    writer.chunk(BINARY_CHUNK_VERTS, len(mesh.vertices), verts.tobytes())
+    writer.chunk(BINARY_CHUNK_TRIANGLES, num_triangles, triangles.tobytes())
+
+    # active UV map as standard attribute
+    uv_layer = mesh.uv_layers.active
+
+    if uv_layer:
+        uv = array("f")
+        for l in loops:
+            co = uv_layer.data[l].uv
+            uv.extend((co[0], co[1], 0.0, 0.0))
+
+        header = struct.pack("<64sIIII", b"uv", 1, 0, ATTR_ELEMENT_CORNER, 0)
+        writer.chunk(BINARY_CHUNK_ATTRIBUTE, len(loops), header + uv.tobytes())
+
+
+def write_scene(scene, fname):
+    writer = BinaryWriter(fname)
+    mesh_index = {}
+    objects = []
+
+    for ob in scene.objects:
+        if ob.type != 'MESH' or ob.hide_render:
+            continue
+
+        # objects without modifiers share mesh data, written once
+        key = ob.data.name if not ob.modifiers else None
+
+        if key is None or key not in mesh_index:
+            mesh = ob.to_mesh(scene, True, 'RENDER')
+
+            index = len(mesh_index)
+            write_mesh(writer, mesh)
+            bpy.data.meshes.remove(mesh)
+
+            mesh_index[key if key is not None else (None, ob.name)] = index
+        else:
+            index = mesh_index[key]
+
+        tfm = [ob.matrix_world[i][j] for i in range(4) for j in range(4)]
+        objects.append(struct.pack("<16fIIII", *(tfm + [index, 0, 0, 0])))
+
+    writer.chunk(BINARY_CHUNK_OBJECTS, len(objects), b"".join(objects))
+    writer.close()
+
+
+# Export Operator
+class ExportCyclesBinary(bpy.types.Operator, ExportHelper):
+    bl_idname = "export_scene.cycles_binary"
+    bl_label = "Export Cycles Binary"
+
+    filename_ext = ".cyb"
+
+    def execute(self, context):
+        filepath = bpy.path.ensure_ext(self.filepath, ".cyb")
+        write_scene(context.scene, filepath)
+
+        return {'FINISHED'}
+
+def register():
+    bpy.utils.register_module(__name__)
+
+def unregister():
+    bpy.utils.unregister_module(__name__)
+
+if __name__ == "__main__":
+    register()
+
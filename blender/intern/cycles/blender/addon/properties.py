@@ -21,7 +21,8 @@ from bpy.props import (BoolProperty,
                        EnumProperty,
                        FloatProperty,
                        IntProperty,
-                       PointerProperty)
+                       PointerProperty,
+                       StringProperty)
 
 # enums
 
@@ -153,6 +154,21 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=0, max=2147483647,
                 default=10,
                 )
+        cls.adaptive_threshold = FloatProperty(
+                name="Adaptive Threshold",
+                description="Stop sampling a tile when its estimated noise level falls below this value, "
+                            "disabled if zero (only for final renders without progressive refine)",
+                min=0.0, max=1.0,
+                default=0.0,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Adaptive Min Samples",
+                description="Minimum number of samples to render in a tile before checking for convergence, "
+                            "also used as interval between convergence checks",
+                min=1, max=4096,
+                default=16,
+                )
         cls.preview_pause = BoolProperty(
                 name="Pause Preview",
                 description="Pause all viewport preview renders",
@@ -382,11 +398,23 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 description="Use BVH spatial splits: longer builder time, faster render",
                 default=False,
                 )
+        cls.debug_use_qbvh = BoolProperty(
+                name="Use QBVH",
+                description="Use BVH with four children per node, traversed with SIMD instructions: faster CPU render",
+                default=True,
+                )
         cls.use_cache = BoolProperty(
                 name="Cache BVH",
                 description="Cache last built BVH to disk for faster re-render if no geometry changed",
                 default=False,
                 )
+        cls.texture_cache_size = IntProperty(
+                name="Texture Cache",
+                description="Read image textures from disk on demand into a cache of this size in MB, "
+                            "instead of loading them fully into memory, 0 to disable (CPU only)",
+                min=0, max=1048576,
+                default=0,
+                )
         cls.tile_order = EnumProperty(
                 name="Tile Order",
                 description="Tile order for rendering",
@@ -394,6 +422,19 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default='CENTER',
                 options=set(),  # Not animatable!
                 )
+        cls.checkpoint_directory = StringProperty(
+                name="Checkpoint Directory",
+                description="Directory to store tiles of final renders in while rendering, "
+                            "an interrupted render continues from the stored tiles when started again",
+                subtype='DIR_PATH',
+                default="",
+                )
+        cls.checkpoint_interval = FloatProperty(
+                name="Checkpoint Interval",
+                description="Seconds between storing partially rendered tiles",
+                min=1.0, max=86400.0,
+                default=300.0,
+                )
         cls.use_progressive_refine = BoolProperty(
                 name="Progressive Refine",
                 description="Instead of rendering each tile until it is finished, "
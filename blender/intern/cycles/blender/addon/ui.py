@@ -143,6 +143,11 @@ class CyclesRender_PT_sampling(CyclesButtonsPanel, Panel):
         if cscene.feature_set == 'EXPERIMENTAL' and (device_type == 'NONE' or cscene.device == 'CPU'):
             layout.row().prop(cscene, "sampling_pattern", text="Pattern")
 
+        row = layout.row(align=True)
+        row.active = not cscene.use_progressive_refine
+        row.prop(cscene, "adaptive_threshold", text="Adaptive Threshold")
+        row.prop(cscene, "adaptive_min_samples", text="Min Samples")
+
         for rl in scene.render.layers:
             if rl.samples > 0:
                 layout.separator()
@@ -270,6 +275,11 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
         subsub.enabled = not rd.use_border
         subsub.prop(rd, "use_save_buffers")
 
+        subsub = sub.column(align=True)
+        subsub.active = not cscene.use_progressive_refine
+        subsub.prop(cscene, "checkpoint_directory", text="")
+        subsub.prop(cscene, "checkpoint_interval", text="Interval")
+
         col = split.column(align=True)
 
         col.label(text="Viewport:")
@@ -287,6 +297,12 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
 
         col.label(text="Acceleration structure:")
         col.prop(cscene, "debug_use_spatial_splits")
+        col.prop(cscene, "debug_use_qbvh")
+
+        col.separator()
+
+        col.label(text="Textures:")
+        col.prop(cscene, "texture_cache_size")
 
 
 class CyclesRender_PT_opengl(CyclesButtonsPanel, Panel):
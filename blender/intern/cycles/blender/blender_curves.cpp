@@ -821,171 +821,214 @@ void BlenderSync::sync_curve_settings()
 
 void BlenderSync::sync_curves(Mesh *mesh, BL::Mesh b_mesh, BL::Object b_ob, int motion)
 {
-	if(!motion) {
-		/* Clear stored curve data */
-		mesh->curve_keys.clear();
-		mesh->curves.clear();
-		mesh->curve_attributes.clear();
-	}
+	CurveSyncData data;
+
+	sync_curves_fetch(&data, mesh, b_mesh, b_ob, motion);
+	sync_curves_export(&data, mesh, motion);
+}
 
+void BlenderSync::sync_curves_fetch(CurveSyncData *data, Mesh *mesh, BL::Mesh b_mesh, BL::Object b_ob, int motion)
+{
 	/* obtain general settings */
 	bool use_curves = scene->curve_system_manager->use_curves;
 
-	if(!(use_curves && b_ob.mode() == b_ob.mode_OBJECT)) {
-		if(!motion)
-			mesh->compute_bounds();
-		return;
-	}
+	data->use_curves = (use_curves && b_ob.mode() == b_ob.mode_OBJECT);
 
-	int primitive = scene->curve_system_manager->primitive;
-	int triangle_method = scene->curve_system_manager->triangle_method;
-	int resolution = scene->curve_system_manager->resolution;
-	size_t vert_num = mesh->verts.size();
-	size_t tri_num = mesh->triangles.size();
-	int used_res = 1;
+	if(!data->use_curves)
+		return;
 
 	/* extract particle hair data - should be combined with connecting to mesh later*/
-
-	ParticleCurveData CData;
+	ParticleCurveData *CData = &data->CData;
 
 	if(!preview)
 		set_resolution(mesh, &b_mesh, &b_ob, &b_scene, true);
 
-	ObtainCacheParticleData(mesh, &b_mesh, &b_ob, &CData, !preview);
+	ObtainCacheParticleData(mesh, &b_mesh, &b_ob, CData, !preview);
 
 	/* obtain camera parameters */
 	BL::Object b_CamOb = b_scene.camera();
-	float3 RotCam = make_float3(0.0f, 0.0f, 0.0f);
+	data->RotCam = make_float3(0.0f, 0.0f, 0.0f);
 	if(b_CamOb) {
 		Transform ctfm = get_transform(b_CamOb.matrix_world());
 		Transform tfm = get_transform(b_ob.matrix_world());
 		Transform itfm = transform_quick_inverse(tfm);
-		RotCam = transform_point(&itfm, make_float3(ctfm.x.w, ctfm.y.w, ctfm.z.w));
+		data->RotCam = transform_point(&itfm, make_float3(ctfm.x.w, ctfm.y.w, ctfm.z.w));
 	}
 
+	if(!motion) {
+		/* texture space for generated coordinates */
+		data->need_generated = mesh->need_attribute(scene, ATTR_STD_GENERATED);
+
+		if(data->need_generated)
+			mesh_texture_space(b_mesh, data->texspace_loc, data->texspace_size);
+
+		/* vertex colors */
+		BL::Mesh::tessface_vertex_colors_iterator l;
+		int vcol_num = 0;
+
+		for(b_mesh.tessface_vertex_colors.begin(l); l != b_mesh.tessface_vertex_colors.end(); ++l, vcol_num++) {
+			ustring name = ustring(l->name().c_str());
+
+			if(!mesh->need_attribute(scene, name))
+				continue;
+
+			ObtainCacheParticleVcol(mesh, &b_mesh, &b_ob, CData, !preview, vcol_num);
+
+			CurveSyncLayer layer;
+			layer.name = name;
+			layer.std = ATTR_STD_NONE;
+			layer.data = CData->curve_vcol;
+			data->vcol_layers.push_back(layer);
+		}
+
+		/* UV maps */
+		BL::Mesh::tessface_uv_textures_iterator u;
+		int uv_num = 0;
+
+		for(b_mesh.tessface_uv_textures.begin(u); u != b_mesh.tessface_uv_textures.end(); ++u, uv_num++) {
+			bool active_render = u->active_render();
+			AttributeStandard std = (active_render)? ATTR_STD_UV: ATTR_STD_NONE;
+			ustring name = ustring(u->name().c_str());
+
+			if(!(mesh->need_attribute(scene, name) || mesh->need_attribute(scene, std)))
+				continue;
+
+			ObtainCacheParticleUV(mesh, &b_mesh, &b_ob, CData, !preview, uv_num);
+
+			CurveSyncLayer layer;
+			layer.name = name;
+			layer.std = std;
+			layer.data = CData->curve_uv;
+			data->uv_layers.push_back(layer);
+		}
+	}
+
+	if(!preview)
+		set_resolution(mesh, &b_mesh, &b_ob, &b_scene, false);
+}
+
+void BlenderSync::sync_curves_export(CurveSyncData *data, Mesh *mesh, int motion)
+{
+	/* no blender data access here, this may run in a thread */
+	if(!motion) {
+		/* Clear stored curve data */
+		mesh->curve_keys.clear();
+		mesh->curves.clear();
+		mesh->curve_attributes.clear();
+	}
+
+	if(!data->use_curves) {
+		if(!motion)
+			mesh->compute_bounds();
+		return;
+	}
+
+	int primitive = scene->curve_system_manager->primitive;
+	int triangle_method = scene->curve_system_manager->triangle_method;
+	int resolution = scene->curve_system_manager->resolution;
+	size_t vert_num = mesh->verts.size();
+	size_t tri_num = mesh->triangles.size();
+	int used_res = 1;
+
+	ParticleCurveData *CData = &data->CData;
+
 	/* add hair geometry to mesh */
 	if(primitive == CURVE_TRIANGLES) {
 		if(triangle_method == CURVE_CAMERA_TRIANGLES)
-			ExportCurveTrianglePlanes(mesh, &CData, RotCam);
+			ExportCurveTrianglePlanes(mesh, CData, data->RotCam);
 		else {
-			ExportCurveTriangleGeometry(mesh, &CData, resolution);
+			ExportCurveTriangleGeometry(mesh, CData, resolution);
 			used_res = resolution;
 		}
 	}
 	else {
 		if(motion)
-			ExportCurveSegmentsMotion(scene, mesh, &CData, motion);
+			ExportCurveSegmentsMotion(scene, mesh, CData, motion);
 		else
-			ExportCurveSegments(scene, mesh, &CData);
+			ExportCurveSegments(scene, mesh, CData);
 	}
 
 	/* generated coordinates from first key. we should ideally get this from
 	 * blender to handle deforming objects */
-	if(!motion) {
-		if(mesh->need_attribute(scene, ATTR_STD_GENERATED)) {
-			float3 loc, size;
-			mesh_texture_space(b_mesh, loc, size);
+	if(!motion && data->need_generated) {
+		float3 loc = data->texspace_loc;
+		float3 size = data->texspace_size;
 
-			if(primitive == CURVE_TRIANGLES) {
-				Attribute *attr_generated = mesh->attributes.add(ATTR_STD_GENERATED);
-				float3 *generated = attr_generated->data_float3();
+		if(primitive == CURVE_TRIANGLES) {
+			Attribute *attr_generated = mesh->attributes.add(ATTR_STD_GENERATED);
+			float3 *generated = attr_generated->data_float3();
 
-				for(size_t i = vert_num; i < mesh->verts.size(); i++)
-					generated[i] = mesh->verts[i]*size - loc;
-			}
-			else {
-				Attribute *attr_generated = mesh->curve_attributes.add(ATTR_STD_GENERATED);
-				float3 *generated = attr_generated->data_float3();
-				size_t i = 0;
-
-				foreach(Mesh::Curve& curve, mesh->curves) {
-					float3 co = mesh->curve_keys[curve.first_key].co;
-					generated[i++] = co*size - loc;
-				}
+			for(size_t i = vert_num; i < mesh->verts.size(); i++)
+				generated[i] = mesh->verts[i]*size - loc;
+		}
+		else {
+			Attribute *attr_generated = mesh->curve_attributes.add(ATTR_STD_GENERATED);
+			float3 *generated = attr_generated->data_float3();
+			size_t i = 0;
+
+			foreach(Mesh::Curve& curve, mesh->curves) {
+				float3 co = mesh->curve_keys[curve.first_key].co;
+				generated[i++] = co*size - loc;
 			}
 		}
 	}
 
 	/* create vertex color attributes */
-	if(!motion) {
-		BL::Mesh::tessface_vertex_colors_iterator l;
-		int vcol_num = 0;
+	foreach(CurveSyncLayer& layer, data->vcol_layers) {
+		CData->curve_vcol.swap(layer.data);
 
-		for(b_mesh.tessface_vertex_colors.begin(l); l != b_mesh.tessface_vertex_colors.end(); ++l, vcol_num++) {
-			if(!mesh->need_attribute(scene, ustring(l->name().c_str())))
-				continue;
-
-			ObtainCacheParticleVcol(mesh, &b_mesh, &b_ob, &CData, !preview, vcol_num);
-
-			if(primitive == CURVE_TRIANGLES) {
+		if(primitive == CURVE_TRIANGLES) {
+			Attribute *attr_vcol = mesh->attributes.add(
+				layer.name, TypeDesc::TypeColor, ATTR_ELEMENT_CORNER);
 
-				Attribute *attr_vcol = mesh->attributes.add(
-					ustring(l->name().c_str()), TypeDesc::TypeColor, ATTR_ELEMENT_CORNER);
+			float3 *fdata = attr_vcol->data_float3();
 
-				float3 *fdata = attr_vcol->data_float3();
-
-				ExportCurveTriangleVcol(mesh, &CData, tri_num * 3, used_res, fdata);
-			}
-			else {
-				Attribute *attr_vcol = mesh->curve_attributes.add(
-					ustring(l->name().c_str()), TypeDesc::TypeColor, ATTR_ELEMENT_CURVE);
+			ExportCurveTriangleVcol(mesh, CData, tri_num * 3, used_res, fdata);
+		}
+		else {
+			Attribute *attr_vcol = mesh->curve_attributes.add(
+				layer.name, TypeDesc::TypeColor, ATTR_ELEMENT_CURVE);
 
-				float3 *fdata = attr_vcol->data_float3();
+			float3 *fdata = attr_vcol->data_float3();
 
-				if(fdata) {
-					for(size_t curve = 0; curve < CData.curve_vcol.size() ;curve++)
-						fdata[curve] = color_srgb_to_scene_linear(CData.curve_vcol[curve]);
-				}
+			if(fdata) {
+				for(size_t curve = 0; curve < CData->curve_vcol.size() ;curve++)
+					fdata[curve] = color_srgb_to_scene_linear(CData->curve_vcol[curve]);
 			}
 		}
 	}
 
 	/* create UV attributes */
-	if(!motion) {
-		BL::Mesh::tessface_uv_textures_iterator l;
-		int uv_num = 0;
-
-		for(b_mesh.tessface_uv_textures.begin(l); l != b_mesh.tessface_uv_textures.end(); ++l, uv_num++) {
-			bool active_render = l->active_render();
-			AttributeStandard std = (active_render)? ATTR_STD_UV: ATTR_STD_NONE;
-			ustring name = ustring(l->name().c_str());
-
-			/* UV map */
-			if(mesh->need_attribute(scene, name) || mesh->need_attribute(scene, std)) {
-				Attribute *attr_uv;
+	foreach(CurveSyncLayer& layer, data->uv_layers) {
+		Attribute *attr_uv;
 
-				ObtainCacheParticleUV(mesh, &b_mesh, &b_ob, &CData, !preview, uv_num);
+		CData->curve_uv.swap(layer.data);
 
-				if(primitive == CURVE_TRIANGLES) {
-					if(active_render)
-						attr_uv = mesh->attributes.add(std, name);
-					else
-						attr_uv = mesh->attributes.add(name, TypeDesc::TypePoint, ATTR_ELEMENT_CORNER);
+		if(primitive == CURVE_TRIANGLES) {
+			if(layer.std != ATTR_STD_NONE)
+				attr_uv = mesh->attributes.add(layer.std, layer.name);
+			else
+				attr_uv = mesh->attributes.add(layer.name, TypeDesc::TypePoint, ATTR_ELEMENT_CORNER);
 
-					float3 *uv = attr_uv->data_float3();
+			float3 *uv = attr_uv->data_float3();
 
-					ExportCurveTriangleUV(mesh, &CData, tri_num * 3, used_res, uv);
-				}
-				else {
-					if(active_render)
-						attr_uv = mesh->curve_attributes.add(std, name);
-					else
-						attr_uv = mesh->curve_attributes.add(name, TypeDesc::TypePoint,  ATTR_ELEMENT_CURVE);
+			ExportCurveTriangleUV(mesh, CData, tri_num * 3, used_res, uv);
+		}
+		else {
+			if(layer.std != ATTR_STD_NONE)
+				attr_uv = mesh->curve_attributes.add(layer.std, layer.name);
+			else
+				attr_uv = mesh->curve_attributes.add(layer.name, TypeDesc::TypePoint,  ATTR_ELEMENT_CURVE);
 
-					float3 *uv = attr_uv->data_float3();
+			float3 *uv = attr_uv->data_float3();
 
-					if(uv) {
-						for(size_t curve = 0; curve < CData.curve_uv.size(); curve++)
-							uv[curve] = CData.curve_uv[curve];
-					}
-				}
+			if(uv) {
+				for(size_t curve = 0; curve < CData->curve_uv.size(); curve++)
+					uv[curve] = CData->curve_uv[curve];
 			}
 		}
 	}
 
-	if(!preview)
-		set_resolution(mesh, &b_mesh, &b_ob, &b_scene, false);
-
 	mesh->compute_bounds();
 }
 
@@ -206,6 +206,32 @@ static void mikk_compute_tangents(BL::Mesh b_mesh, BL::MeshTextureFaceLayer b_la
 	}
 }
 
+/* Mesh Sync Job
+ *
+ * Conversion of a single derived mesh, with everything that needs blender
+ * data access other than reading the derived mesh already done. */
+
+struct BlenderSync::MeshSyncJob {
+	Mesh *mesh;
+	BL::Mesh b_mesh;
+	vector<uint> used_shaders;
+
+	bool use_surfaces;
+	bool use_subdivision;
+	float dicing_rate;
+
+	bool use_hair;
+	CurveSyncData curves;
+
+	vector<Mesh::Triangle> oldtriangle;
+	vector<Mesh::CurveKey> oldcurve_keys;
+	bool rebuild;
+
+	MeshSyncJob()
+	: b_mesh(PointerRNA_NULL), use_surfaces(false), use_subdivision(false),
+	  dicing_rate(1.0f), use_hair(false), rebuild(false) {}
+};
+
 /* Create Mesh */
 
 static void create_mesh(Scene *scene, Mesh *mesh, BL::Mesh b_mesh, const vector<uint>& used_shaders)
@@ -365,7 +391,7 @@ static void create_mesh(Scene *scene, Mesh *mesh, BL::Mesh b_mesh, const vector<
 	}
 }
 
-static void create_subd_mesh(Mesh *mesh, BL::Mesh b_mesh, PointerRNA *cmesh, const vector<uint>& used_shaders)
+static void create_subd_mesh(Mesh *mesh, BL::Mesh b_mesh, float dicing_rate, const vector<uint>& used_shaders)
 {
 	/* create subd mesh */
 	SubdMesh sdmesh;
@@ -398,7 +424,7 @@ static void create_subd_mesh(Mesh *mesh, BL::Mesh b_mesh, PointerRNA *cmesh, con
 	/* subdivide */
 	DiagSplit dsplit;
 	dsplit.camera = NULL;
-	dsplit.dicing_rate = RNA_float_get(cmesh, "dicing_rate");
+	dsplit.dicing_rate = dicing_rate;
 
 	sdmesh.tessellate(&dsplit, false, mesh, used_shaders[0], true);
 }
@@ -459,14 +485,25 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated, bool hide_tri
 	
 	mesh_synced.insert(mesh);
 
+	/* every job keeps its derived mesh alive until it is waited for, so bound
+	 * the number of jobs in flight to limit peak memory usage. this waits for a
+	 * whole batch, trading some idle threads at the end of each batch for not
+	 * holding all derived meshes of the scene in memory at once */
+	if((int)mesh_sync_jobs.size() >= max(2*TaskScheduler::num_threads(), 1))
+		sync_mesh_wait();
+
 	/* create derived mesh */
 	PointerRNA cmesh = RNA_pointer_get(&b_ob_data.ptr, "cycles");
 
-	vector<Mesh::Triangle> oldtriangle = mesh->triangles;
+	MeshSyncJob *job = new MeshSyncJob();
+	job->mesh = mesh;
+	job->used_shaders = used_shaders;
+
+	job->oldtriangle = mesh->triangles;
 	
 	/* compares curve_keys rather than strands in order to handle quick hair
 	 * adjustsments in dynamic BVH - other methods could probably do this better*/
-	vector<Mesh::CurveKey> oldcurve_keys = mesh->curve_keys;
+	job->oldcurve_keys = mesh->curve_keys;
 
 	mesh->clear();
 	mesh->used_shaders = used_shaders;
@@ -480,18 +517,22 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated, bool hide_tri
 		BL::Mesh b_mesh = object_to_mesh(b_data, b_ob, b_scene, true, !preview, need_undeformed);
 
 		if(b_mesh) {
+			job->b_mesh = b_mesh;
+
 			if(render_layer.use_surfaces && !hide_tris) {
-				if(cmesh.data && experimental && RNA_boolean_get(&cmesh, "use_subdivision"))
-					create_subd_mesh(mesh, b_mesh, &cmesh, used_shaders);
-				else
-					create_mesh(scene, mesh, b_mesh, used_shaders);
-			}
+				job->use_surfaces = true;
+				job->use_subdivision = (cmesh.data && experimental && RNA_boolean_get(&cmesh, "use_subdivision"));
 
-			if(render_layer.use_hair)
-				sync_curves(mesh, b_mesh, b_ob, 0);
+				if(job->use_subdivision)
+					job->dicing_rate = RNA_float_get(&cmesh, "dicing_rate");
+			}
 
-			/* free derived mesh */
-			b_data.meshes.remove(b_mesh);
+			/* hair data is read from blender here, and only exported to the
+			 * mesh in the job */
+			if(render_layer.use_hair) {
+				job->use_hair = true;
+				sync_curves_fetch(&job->curves, mesh, b_mesh, b_ob, 0);
+			}
 		}
 	}
 
@@ -507,26 +548,68 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated, bool hide_tri
 			mesh->displacement_method = Mesh::DISPLACE_BOTH;
 	}
 
-	/* tag update */
-	bool rebuild = false;
+	/* tag update now so objects using this mesh see it, whether the BVH needs
+	 * to be rebuilt is only known once the job is done */
+	mesh->tag_update(scene, false);
+
+	mesh_sync_jobs.push_back(job);
+	mesh_sync_pool.push(function_bind(&BlenderSync::run_mesh_sync_job, this, job));
+
+	return mesh;
+}
+
+void BlenderSync::run_mesh_sync_job(MeshSyncJob *job)
+{
+	/* runs in a thread, may only read the derived mesh which is not touched by
+	 * the main thread until all jobs are done, and write to the cycles mesh */
+	Mesh *mesh = job->mesh;
+
+	if(job->use_surfaces) {
+		if(job->use_subdivision)
+			create_subd_mesh(mesh, job->b_mesh, job->dicing_rate, job->used_shaders);
+		else
+			create_mesh(scene, mesh, job->b_mesh, job->used_shaders);
+	}
+
+	if(job->use_hair)
+		sync_curves_export(&job->curves, mesh, 0);
+
+	/* test if BVH needs to be rebuilt */
+	vector<Mesh::Triangle>& oldtriangle = job->oldtriangle;
+	vector<Mesh::CurveKey>& oldcurve_keys = job->oldcurve_keys;
+
+	job->rebuild = false;
 
 	if(oldtriangle.size() != mesh->triangles.size())
-		rebuild = true;
+		job->rebuild = true;
 	else if(oldtriangle.size()) {
 		if(memcmp(&oldtriangle[0], &mesh->triangles[0], sizeof(Mesh::Triangle)*oldtriangle.size()) != 0)
-			rebuild = true;
+			job->rebuild = true;
 	}
 
 	if(oldcurve_keys.size() != mesh->curve_keys.size())
-		rebuild = true;
+		job->rebuild = true;
 	else if(oldcurve_keys.size()) {
 		if(memcmp(&oldcurve_keys[0], &mesh->curve_keys[0], sizeof(Mesh::CurveKey)*oldcurve_keys.size()) != 0)
-			rebuild = true;
+			job->rebuild = true;
 	}
-	
-	mesh->tag_update(scene, rebuild);
+}
 
-	return mesh;
+void BlenderSync::sync_mesh_wait()
+{
+	mesh_sync_pool.wait_work();
+
+	/* free derived meshes and tag updates on the main thread */
+	foreach(MeshSyncJob *job, mesh_sync_jobs) {
+		if(job->b_mesh)
+			b_data.meshes.remove(job->b_mesh);
+
+		job->mesh->tag_update(scene, job->rebuild);
+
+		delete job;
+	}
+
+	mesh_sync_jobs.clear();
 }
 
 void BlenderSync::sync_mesh_motion(BL::Object b_ob, Mesh *mesh, int motion)
@@ -479,6 +479,12 @@ void BlenderSync::sync_objects(BL::SpaceView3D b_v3d, int motion)
 		}
 	}
 
+	/* wait for mesh conversion, also when cancelled so derived meshes are freed */
+	if(!motion) {
+		progress.set_sync_status("Converting meshes");
+		sync_mesh_wait();
+	}
+
 	progress.set_sync_status("");
 
 	if(!cancel && !motion) {
@@ -25,9 +25,11 @@
 #include "session.h"
 #include "shader.h"
 
+#include "util_cache.h"
 #include "util_color.h"
 #include "util_foreach.h"
 #include "util_function.h"
+#include "util_path.h"
 #include "util_progress.h"
 #include "util_time.h"
 
@@ -79,8 +81,9 @@ BlenderSession::~BlenderSession()
 
 void BlenderSession::create_session()
 {
-	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background);
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
+	bool is_cpu = session_params.device.type == DEVICE_CPU;
+	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background, is_cpu);
 
 	/* reset status/progress */
 	last_status = "";
@@ -131,8 +134,9 @@ void BlenderSession::reset_session(BL::BlendData b_data_, BL::Scene b_scene_)
 	b_render = b_engine.render();
 	b_scene = b_scene_;
 
-	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background);
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
+	bool is_cpu = session_params.device.type == DEVICE_CPU;
+	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background, is_cpu);
 
 	width = render_resolution_x(b_render);
 	height = render_resolution_y(b_render);
@@ -379,6 +383,10 @@ void BlenderSession::render()
 			}
 		}
 
+		/* variance pass for adaptive sampling convergence estimation */
+		if(session_params.adaptive_threshold > 0.0f && !session_params.progressive_refine)
+			Pass::add(PASS_VARIANCE, passes);
+
 		buffer_params.passes = passes;
 		scene->film->tag_passes_update(scene, passes);
 		scene->film->tag_update(scene);
@@ -404,6 +412,17 @@ void BlenderSession::render()
 			else
 				session->reset(buffer_params, session_params.samples);
 
+			/* checkpoint file for this frame, layer and view */
+			if(session_params.checkpoint_path != "") {
+				string checkpoint_dir = blender_absolute_path(b_data, b_scene, session_params.checkpoint_path);
+				/* scene and layer names may contain path separators */
+				string checkpoint_name = string_printf("%s_%s_%d_%04d.ckpt",
+					path_sanitize_filename(b_scene.name()).c_str(),
+					path_sanitize_filename(b_rlay_name).c_str(), b_rview_id, b_scene.frame_current());
+
+				session->params.checkpoint_path = path_join(checkpoint_dir, checkpoint_name);
+			}
+
 			/* render */
 			session->start();
 			session->wait();
@@ -486,8 +505,9 @@ void BlenderSession::synchronize()
 		return;
 
 	/* on session/scene parameter changes, we recreate session entirely */
-	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background);
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
+	bool is_cpu = session_params.device.type == DEVICE_CPU;
+	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background, is_cpu);
 
 	if(session->params.modified(session_params) ||
 	   scene->params.modified(scene_params))
@@ -644,6 +664,13 @@ void BlenderSession::update_status_progress()
 
 	timestatus = string_printf("Mem:%.2fM, Peak:%.2fM", mem_used, mem_peak);
 
+	/* BVH disk cache */
+	int cache_hits, cache_misses;
+	Cache::global.get_stats(cache_hits, cache_misses);
+
+	if(cache_hits || cache_misses)
+		timestatus += string_printf(", BVH Cache:%d hits, %d misses", cache_hits, cache_misses);
+
 	if(background) {
 		timestatus += " | " + b_scene.name();
 		if(b_rlay_name != "")
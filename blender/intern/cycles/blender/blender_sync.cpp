@@ -35,6 +35,7 @@
 #include "util_debug.h"
 #include "util_foreach.h"
 #include "util_opengl.h"
+#include "util_system.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -333,7 +334,7 @@ void BlenderSync::sync_render_layers(BL::SpaceView3D b_v3d, const char *layer)
 
 /* Scene Parameters */
 
-SceneParams BlenderSync::get_scene_params(BL::Scene b_scene, bool background)
+SceneParams BlenderSync::get_scene_params(BL::Scene b_scene, bool background, bool is_cpu)
 {
 	BL::RenderSettings r = b_scene.render();
 	SceneParams params;
@@ -351,8 +352,21 @@ SceneParams BlenderSync::get_scene_params(BL::Scene b_scene, bool background)
 		params.bvh_type = (SceneParams::BVHType)RNA_enum_get(&cscene, "debug_bvh_type");
 
 	params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
+
+	/* QBVH traversal is only implemented in the CPU kernels, and vectorized with SSE2 */
+	if(is_cpu)
+		params.use_qbvh = RNA_boolean_get(&cscene, "debug_use_qbvh") && system_cpu_support_sse2();
+	else
+		params.use_qbvh = false;
+
 	params.use_bvh_cache = (background)? RNA_boolean_get(&cscene, "use_cache"): false;
 
+	/* out of core image textures are only supported by the CPU kernels */
+	if(is_cpu)
+		params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
+	else
+		params.texture_cache_size = 0;
+
 	if(background && params.shadingsystem != SceneParams::OSL)
 		params.persistent_data = r.use_persistent_data();
 	else
@@ -482,6 +496,15 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine b_engine, BL::Use
 			params.progressive = false;
 
 		params.start_resolution = INT_MAX;
+
+		/* adaptive sampling */
+		params.adaptive_threshold = get_float(cscene, "adaptive_threshold");
+		params.adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
+
+		/* checkpoint directory, the file for each render layer is chosen
+		 * by the blender session */
+		params.checkpoint_path = get_string(cscene, "checkpoint_directory");
+		params.checkpoint_interval = get_float(cscene, "checkpoint_interval");
 	}
 	else
 		params.progressive = true;
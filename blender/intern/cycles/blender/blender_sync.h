@@ -24,11 +24,13 @@
 
 #include "blender_util.h"
 
+#include "curves.h"
 #include "scene.h"
 #include "session.h"
 
 #include "util_map.h"
 #include "util_set.h"
+#include "util_task.h"
 #include "util_transform.h"
 #include "util_vector.h"
 
@@ -46,6 +48,32 @@ class Shader;
 class ShaderGraph;
 class ShaderNode;
 
+/* Hair Sync Data
+ *
+ * Particle hair fetched from blender on the main thread, so that it can be
+ * exported to the mesh from a task without touching blender data. */
+
+struct CurveSyncLayer {
+	ustring name;
+	AttributeStandard std;
+	vector<float3> data;
+};
+
+struct CurveSyncData {
+	CurveSyncData() : use_curves(false), need_generated(false) {}
+
+	bool use_curves;
+	ParticleCurveData CData;
+	float3 RotCam;
+
+	bool need_generated;
+	float3 texspace_loc;
+	float3 texspace_size;
+
+	vector<CurveSyncLayer> vcol_layers;
+	vector<CurveSyncLayer> uv_layers;
+};
+
 class BlenderSync {
 public:
 	BlenderSync(BL::RenderEngine b_engine_, BL::BlendData b_data, BL::Scene b_scene, Scene *scene_, bool preview_, Progress &progress_, bool is_cpu_);
@@ -62,7 +90,7 @@ public:
 	int get_layer_bound_samples() { return render_layer.bound_samples; }
 
 	/* get parameters */
-	static SceneParams get_scene_params(BL::Scene b_scene, bool background);
+	static SceneParams get_scene_params(BL::Scene b_scene, bool background, bool is_cpu);
 	static SessionParams get_session_params(BL::RenderEngine b_engine, BL::UserPreferences b_userpref, BL::Scene b_scene, bool background);
 	static bool get_session_pause(BL::Scene b_scene, bool background);
 	static BufferParams get_buffer_params(BL::RenderSettings b_render, BL::Scene b_scene, BL::SpaceView3D b_v3d, BL::RegionView3D b_rv3d, Camera *cam, int width, int height);
@@ -81,7 +109,10 @@ private:
 
 	void sync_nodes(Shader *shader, BL::ShaderNodeTree b_ntree);
 	Mesh *sync_mesh(BL::Object b_ob, bool object_updated, bool hide_tris);
+	void sync_mesh_wait();
 	void sync_curves(Mesh *mesh, BL::Mesh b_mesh, BL::Object b_ob, int motion);
+	void sync_curves_fetch(CurveSyncData *data, Mesh *mesh, BL::Mesh b_mesh, BL::Object b_ob, int motion);
+	void sync_curves_export(CurveSyncData *data, Mesh *mesh, int motion);
 	Object *sync_object(BL::Object b_parent, int persistent_id[OBJECT_PERSISTENT_ID_SIZE], BL::DupliObject b_dupli_object, Transform& tfm, uint layer_flag, int motion, bool hide_tris);
 	void sync_light(BL::Object b_parent, int persistent_id[OBJECT_PERSISTENT_ID_SIZE], BL::Object b_ob, Transform& tfm);
 	void sync_background_light();
@@ -109,6 +140,16 @@ private:
 	id_map<ParticleSystemKey, ParticleSystem> particle_system_map;
 	set<Mesh*> mesh_synced;
 	set<Mesh*> mesh_motion_synced;
+
+	/* meshes are converted in a task pool, only blender data access and
+	 * derived mesh creation happens on the main thread. derived meshes are
+	 * freed in batches, see sync_mesh */
+	struct MeshSyncJob;
+	void run_mesh_sync_job(MeshSyncJob *job);
+
+	TaskPool mesh_sync_pool;
+	vector<MeshSyncJob*> mesh_sync_jobs;
+
 	void *world_map;
 	bool world_recalc;
 
@@ -59,6 +59,13 @@ struct BVHStackEntry
 BVH::BVH(const BVHParams& params_, const vector<Object*>& objects_)
 : params(params_), objects(objects_)
 {
+	refit_cost = 0.0f;
+	cache_data = NULL;
+}
+
+BVH::~BVH()
+{
+	delete cache_data;
 }
 
 BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
@@ -86,26 +93,52 @@ bool BVH::cache_read(CacheData& key)
 		key.add(&ob->mesh->transform_applied, sizeof(bool));
 	}
 
-	CacheData value;
+	CacheData *value = new CacheData();
+
+	if(Cache::global.lookup(key, *value)) {
+		bool ok = true;
 
-	if(Cache::global.lookup(key, value)) {
-		cache_filename = key.get_filename();
+		ok = ok && value->read(pack.root_index);
+		ok = ok && value->read(pack.num_top_prims);
+		ok = ok && value->read(pack.SAH);
 
-		value.read(pack.root_index);
-		value.read(pack.SAH);
+		/* arrays reference the mapped file without copying */
+		ok = ok && value->read(pack.nodes);
+		ok = ok && value->read(pack.object_node);
+		ok = ok && value->read(pack.tri_woop);
+		ok = ok && value->read(pack.prim_segment);
+		ok = ok && value->read(pack.prim_visibility);
+		ok = ok && value->read(pack.prim_index);
+		ok = ok && value->read(pack.prim_object);
+		ok = ok && value->read(pack.is_leaf);
 
-		value.read(pack.nodes);
-		value.read(pack.object_node);
-		value.read(pack.tri_woop);
-		value.read(pack.prim_segment);
-		value.read(pack.prim_visibility);
-		value.read(pack.prim_index);
-		value.read(pack.prim_object);
-		value.read(pack.is_leaf);
+		if(ok) {
+			cache_filename = key.get_filename();
 
-		return true;
+			/* keep mapped for as long as the BVH exists */
+			delete cache_data;
+			cache_data = value;
+
+			return true;
+		}
+
+		/* don't keep references to the file, the BVH is built instead */
+		fprintf(stderr, "Invalid BVH cache file %s, building BVH.\n", key.get_filename().c_str());
+		pack.nodes.clear();
+		pack.object_node.clear();
+		pack.tri_woop.clear();
+		pack.prim_segment.clear();
+		pack.prim_visibility.clear();
+		pack.prim_index.clear();
+		pack.prim_object.clear();
+		pack.is_leaf.clear();
+		pack.root_index = 0;
+		pack.num_top_prims = 0;
+		pack.SAH = 0.0f;
 	}
 
+	delete value;
+
 	return false;
 }
 
@@ -114,6 +147,7 @@ void BVH::cache_write(CacheData& key)
 	CacheData value;
 
 	value.add(pack.root_index);
+	value.add(pack.num_top_prims);
 	value.add(pack.SAH);
 
 	value.add(pack.nodes);
@@ -138,7 +172,7 @@ void BVH::clear_cache_except()
 		except.insert(cache_filename);
 
 	foreach(Object *ob, objects) {
-		Mesh *mesh = ob->mesh;
+		Mesh *mesh = ob->mesh->get_shared_mesh();
 		BVH *bvh = mesh->bvh;
 
 		if(bvh && !bvh->cache_filename.empty())
@@ -183,8 +217,7 @@ void BVH::build(Progress& progress)
 	pack.prim_object = prim_object;
 
 	/* compute SAH */
-	if(!params.top_level)
-		pack.SAH = root->computeSubtreeSAHCost(params);
+	pack.SAH = root->computeSubtreeSAHCost(params);
 
 	if(progress.get_cancel()) {
 		root->deleteSubtree();
@@ -225,11 +258,28 @@ void BVH::build(Progress& progress)
 
 void BVH::refit(Progress& progress)
 {
+	if(params.top_level) {
+		/* remove the merged instance BVH's, they are merged in again after
+		 * packing as they may have been refitted themselves. the top level
+		 * is only refitted when it contains instances only, so primitive
+		 * indexes need no adjustment. */
+		pack.prim_index.resize(pack.num_top_prims);
+		pack.prim_segment.resize(pack.num_top_prims);
+		pack.prim_object.resize(pack.num_top_prims);
+	}
+
 	progress.set_substatus("Packing BVH primitives");
 	pack_primitives();
 
 	if(progress.get_cancel()) return;
 
+	if(params.top_level) {
+		progress.set_substatus("Packing instance BVH's");
+
+		size_t nsize = (params.use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
+		pack_instances(pack.is_leaf.size()*nsize);
+	}
+
 	progress.set_substatus("Refitting BVH nodes");
 	refit_nodes();
 }
@@ -355,6 +405,8 @@ void BVH::pack_instances(size_t nodes_size)
 	bool use_qbvh = params.use_qbvh;
 	size_t nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
 
+	pack.num_top_prims = pack.prim_index.size();
+
 	/* adjust primitive index to point to the triangle in the global array, for
 	 * meshes with transform applied and already in the top level BVH */
 	for(size_t i = 0; i < pack.prim_index.size(); i++)
@@ -384,7 +436,7 @@ void BVH::pack_instances(size_t nodes_size)
 	map<Mesh*, int> mesh_map;
 
 	foreach(Object *ob, objects) {
-		Mesh *mesh = ob->mesh;
+		Mesh *mesh = ob->mesh->get_shared_mesh();
 		BVH *bvh = mesh->bvh;
 
 		if(!mesh->transform_applied) {
@@ -415,9 +467,9 @@ void BVH::pack_instances(size_t nodes_size)
 	float4 *pack_tri_woop = (pack.tri_woop.size())? &pack.tri_woop[0]: NULL;
 	int4 *pack_nodes = (pack.nodes.size())? &pack.nodes[0]: NULL;
 
-	/* merge */
+	/* merge, meshes sharing data with another mesh use its BVH */
 	foreach(Object *ob, objects) {
-		Mesh *mesh = ob->mesh;
+		Mesh *mesh = ob->mesh->get_shared_mesh();
 
 		/* if mesh transform is applied, that means it's already in the top
 		 * level BVH, and we don't need to merge it in */
@@ -518,6 +570,61 @@ void BVH::pack_instances(size_t nodes_size)
 	}
 }
 
+/* Refit */
+
+void BVH::refit_primitives(int start, int end, BoundBox& bbox, uint& visibility)
+{
+	for(int prim = start; prim < end; prim++) {
+		int pidx = pack.prim_index[prim];
+		int tob = pack.prim_object[prim];
+		Object *ob = objects[tob];
+
+		if(pidx == -1) {
+			/* object instance */
+			bbox.grow(ob->bounds);
+		}
+		else {
+			/* primitives */
+			const Mesh *mesh = ob->mesh;
+
+			if(pack.prim_segment[prim] != ~0) {
+				/* curves */
+				int str_offset = (params.top_level)? mesh->curve_offset: 0;
+				int k0 = mesh->curves[pidx - str_offset].first_key + pack.prim_segment[prim]; // XXX!
+				int k1 = k0 + 1;
+
+				float3 p[4];
+				p[0] = mesh->curve_keys[max(k0 - 1,mesh->curves[pidx - str_offset].first_key)].co;
+				p[1] = mesh->curve_keys[k0].co;
+				p[2] = mesh->curve_keys[k1].co;
+				p[3] = mesh->curve_keys[min(k1 + 1,mesh->curves[pidx - str_offset].first_key + mesh->curves[pidx - str_offset].num_keys - 1)].co;
+				float3 lower;
+				float3 upper;
+				curvebounds(&lower.x, &upper.x, p, 0);
+				curvebounds(&lower.y, &upper.y, p, 1);
+				curvebounds(&lower.z, &upper.z, p, 2);
+				float mr = max(mesh->curve_keys[k0].radius,mesh->curve_keys[k1].radius);
+				bbox.grow(lower, mr);
+				bbox.grow(upper, mr);
+
+				visibility |= PATH_RAY_CURVE;
+			}
+			else {
+				/* triangles */
+				int tri_offset = (params.top_level)? mesh->tri_offset: 0;
+				const int *vidx = mesh->triangles[pidx - tri_offset].v;
+				const float3 *vpos = &mesh->verts[0];
+
+				bbox.grow(vpos[vidx[0]]);
+				bbox.grow(vpos[vidx[1]]);
+				bbox.grow(vpos[vidx[2]]);
+			}
+		}
+
+		visibility |= ob->visibility;
+	}
+}
+
 /* Regular BVH */
 
 RegularBVH::RegularBVH(const BVHParams& params_, const vector<Object*>& objects_)
@@ -600,11 +707,14 @@ void RegularBVH::pack_nodes(const array<int>& prims, const BVHNode *root)
 
 void RegularBVH::refit_nodes()
 {
-	assert(!params.top_level);
-
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
+
+	refit_cost = 0.0f;
 	refit_node(0, (pack.is_leaf[0])? true: false, bbox, visibility);
+
+	/* SAH cost relative to the root, same as BVHNode::computeSubtreeSAHCost */
+	pack.SAH = (bbox.safe_area() > 0.0f)? refit_cost/bbox.safe_area(): 0.0f;
 }
 
 void RegularBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
@@ -615,56 +725,12 @@ void RegularBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility
 	int c1 = data[3].y;
 
 	if(leaf) {
-		/* refit leaf node */
-		for(int prim = c0; prim < c1; prim++) {
-			int pidx = pack.prim_index[prim];
-			int tob = pack.prim_object[prim];
-			Object *ob = objects[tob];
-
-			if(pidx == -1) {
-				/* object instance */
-				bbox.grow(ob->bounds);
-			}
-			else {
-				/* primitives */
-				const Mesh *mesh = ob->mesh;
-
-				if(pack.prim_segment[prim] != ~0) {
-					/* curves */
-					int str_offset = (params.top_level)? mesh->curve_offset: 0;
-					int k0 = mesh->curves[pidx - str_offset].first_key + pack.prim_segment[prim]; // XXX!
-					int k1 = k0 + 1;
-
-					float3 p[4];
-					p[0] = mesh->curve_keys[max(k0 - 1,mesh->curves[pidx - str_offset].first_key)].co;
-					p[1] = mesh->curve_keys[k0].co;
-					p[2] = mesh->curve_keys[k1].co;
-					p[3] = mesh->curve_keys[min(k1 + 1,mesh->curves[pidx - str_offset].first_key + mesh->curves[pidx - str_offset].num_keys - 1)].co;
-					float3 lower;
-					float3 upper;
-					curvebounds(&lower.x, &upper.x, p, 0);
-					curvebounds(&lower.y, &upper.y, p, 1);
-					curvebounds(&lower.z, &upper.z, p, 2);
-					float mr = max(mesh->curve_keys[k0].radius,mesh->curve_keys[k1].radius);
-					bbox.grow(lower, mr);
-					bbox.grow(upper, mr);
-
-					visibility |= PATH_RAY_CURVE;
-				}
-				else {
-					/* triangles */
-					int tri_offset = (params.top_level)? mesh->tri_offset: 0;
-					const int *vidx = mesh->triangles[pidx - tri_offset].v;
-					const float3 *vpos = &mesh->verts[0];
-
-					bbox.grow(vpos[vidx[0]]);
-					bbox.grow(vpos[vidx[1]]);
-					bbox.grow(vpos[vidx[2]]);
-				}
-			}
+		/* refit leaf node, object instances are stored as ~index */
+		int start = (c0 < 0)? ~c0: c0;
+		int end = (c0 < 0)? start + 1: c1;
 
-			visibility |= ob->visibility;
-		}
+		refit_primitives(start, end, bbox, visibility);
+		refit_cost += params.triangle_cost(end - start)*bbox.safe_area();
 
 		pack_node(idx, bbox, bbox, c0, c1, visibility, visibility);
 	}
@@ -681,6 +747,8 @@ void RegularBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility
 		bbox.grow(bbox0);
 		bbox.grow(bbox1);
 		visibility = visibility0|visibility1;
+
+		refit_cost += params.node_cost(2)*bbox.safe_area();
 	}
 }
 
@@ -690,8 +758,6 @@ QBVH::QBVH(const BVHParams& params_, const vector<Object*>& objects_)
 : BVH(params_, objects_)
 {
 	params.use_qbvh = true;
-
-	/* todo: use visibility */
 }
 
 void QBVH::pack_leaf(const BVHStackEntry& e, const LeafNode *leaf)
@@ -715,38 +781,50 @@ void QBVH::pack_leaf(const BVHStackEntry& e, const LeafNode *leaf)
 }
 
 void QBVH::pack_inner(const BVHStackEntry& e, const BVHStackEntry *en, int num)
+{
+	BoundBox bounds[4];
+	int child[4];
+	uint visibility[4];
+
+	for(int i = 0; i < num; i++) {
+		bounds[i] = en[i].node->m_bounds;
+		child[i] = en[i].encodeIdx();
+		visibility[i] = en[i].node->m_visibility;
+	}
+
+	pack_node(e.idx, bounds, child, visibility, num);
+}
+
+void QBVH::pack_node(int idx, const BoundBox *bounds, const int *child, const uint *visibility, int num)
 {
 	float4 data[BVH_QNODE_SIZE];
 
 	for(int i = 0; i < num; i++) {
-		float3 bb_min = en[i].node->m_bounds.min;
-		float3 bb_max = en[i].node->m_bounds.max;
-
-		data[0][i] = bb_min.x;
-		data[1][i] = bb_max.x;
-		data[2][i] = bb_min.y;
-		data[3][i] = bb_max.y;
-		data[4][i] = bb_min.z;
-		data[5][i] = bb_max.z;
-
-		data[6][i] = __int_as_float(en[i].encodeIdx());
-		data[7][i] = 0.0f;
+		data[0][i] = bounds[i].min.x;
+		data[1][i] = bounds[i].max.x;
+		data[2][i] = bounds[i].min.y;
+		data[3][i] = bounds[i].max.y;
+		data[4][i] = bounds[i].min.z;
+		data[5][i] = bounds[i].max.z;
+
+		data[6][i] = __int_as_float(child[i]);
+		data[7][i] = __uint_as_float(visibility[i]);
 	}
 
 	for(int i = num; i < 4; i++) {
-		data[0][i] = 0.0f;
-		data[1][i] = 0.0f;
-		data[2][i] = 0.0f;
-
-		data[3][i] = 0.0f;
-		data[4][i] = 0.0f;
-		data[5][i] = 0.0f;
+		/* empty child, inverted bounds so the ray never hits it */
+		data[0][i] = FLT_MAX;
+		data[1][i] = -FLT_MAX;
+		data[2][i] = FLT_MAX;
+		data[3][i] = -FLT_MAX;
+		data[4][i] = FLT_MAX;
+		data[5][i] = -FLT_MAX;
 
 		data[6][i] = __int_as_float(0);
-		data[7][i] = 0.0f;
+		data[7][i] = __uint_as_float(0);
 	}
 
-	memcpy(&pack.nodes[e.idx * BVH_QNODE_SIZE], data, sizeof(float4)*BVH_QNODE_SIZE);
+	memcpy(&pack.nodes[idx * BVH_QNODE_SIZE], data, sizeof(float4)*BVH_QNODE_SIZE);
 }
 
 /* Quad SIMD Nodes */
@@ -824,7 +902,60 @@ void QBVH::pack_nodes(const array<int>& prims, const BVHNode *root)
 
 void QBVH::refit_nodes()
 {
-	assert(0); /* todo */
+	BoundBox bbox = BoundBox::empty;
+	uint visibility = 0;
+
+	refit_cost = 0.0f;
+	refit_node(0, (pack.is_leaf[0])? true: false, bbox, visibility);
+
+	/* SAH cost relative to the root, same as BVHNode::computeSubtreeSAHCost */
+	pack.SAH = (bbox.safe_area() > 0.0f)? refit_cost/bbox.safe_area(): 0.0f;
+}
+
+void QBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
+{
+	float4 *data = (float4*)&pack.nodes[idx*BVH_QNODE_SIZE];
+
+	if(leaf) {
+		/* refit leaf node, object instances are stored as ~index */
+		int c0 = __float_as_int(data[6].x);
+		int c1 = __float_as_int(data[6].y);
+		int start = (c0 < 0)? ~c0: c0;
+		int end = (c0 < 0)? start + 1: c1;
+
+		refit_primitives(start, end, bbox, visibility);
+		refit_cost += params.triangle_cost(end - start)*bbox.safe_area();
+	}
+	else {
+		/* refit inner node, set bbox from children */
+		BoundBox child_bbox[4];
+		int child[4];
+		uint child_visibility[4];
+		int num = 0;
+
+		for(int i = 0; i < 4; i++) {
+			int c = __float_as_int(data[6][i]);
+
+			/* index 0 is the root, so it only occurs for empty children,
+			 * which are always packed after the used ones */
+			if(c == 0)
+				break;
+
+			child_bbox[num] = BoundBox::empty;
+			child_visibility[num] = 0;
+			child[num] = c;
+
+			refit_node((c < 0)? -c-1: c, (c < 0), child_bbox[num], child_visibility[num]);
+
+			bbox.grow(child_bbox[num]);
+			visibility |= child_visibility[num];
+			num++;
+		}
+
+		pack_node(idx, child_bbox, child, child_visibility, num);
+
+		refit_cost += params.node_cost(num)*bbox.safe_area();
+	}
 }
 
 CCL_NAMESPACE_END
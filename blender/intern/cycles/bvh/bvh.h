@@ -68,12 +68,18 @@ struct PackedBVH {
 	/* index of the root node. */
 	int root_index;
 
-	/* surface area heuristic, for building top level BVH */
+	/* number of primitives in the top level BVH itself, before the instance
+	 * BVH's are merged in */
+	int num_top_prims;
+
+	/* surface area heuristic, for building top level BVH, and to check the
+	 * quality of the BVH after refitting */
 	float SAH;
 
 	PackedBVH()
 	{
 		root_index = 0;
+		num_top_prims = 0;
 		SAH = 0.0f;
 	}
 };
@@ -89,7 +95,7 @@ public:
 	string cache_filename;
 
 	static BVH *create(const BVHParams& params, const vector<Object*>& objects);
-	virtual ~BVH() {}
+	virtual ~BVH();
 
 	void build(Progress& progress);
 	void refit(Progress& progress);
@@ -111,6 +117,16 @@ protected:
 	/* merge instance BVH's */
 	void pack_instances(size_t nodes_size);
 
+	/* refit bounds of a range of primitives */
+	void refit_primitives(int start, int end, BoundBox& bbox, uint& visibility);
+
+	/* SAH cost accumulated while refitting nodes */
+	float refit_cost;
+
+	/* memory mapped cache file, referenced by the packed arrays when the BVH
+	 * was read from the cache */
+	CacheData *cache_data;
+
 	/* for subclasses to implement */
 	virtual void pack_nodes(const array<int>& prims, const BVHNode *root) = 0;
 	virtual void refit_nodes() = 0;
@@ -151,9 +167,11 @@ protected:
 	void pack_nodes(const array<int>& prims, const BVHNode *root);
 	void pack_leaf(const BVHStackEntry& e, const LeafNode *leaf);
 	void pack_inner(const BVHStackEntry& e, const BVHStackEntry *en, int num);
+	void pack_node(int idx, const BoundBox *bounds, const int *child, const uint *visibility, int num);
 
 	/* refit */
 	void refit_nodes();
+	void refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility);
 };
 
 CCL_NAMESPACE_END
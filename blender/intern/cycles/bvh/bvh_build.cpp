@@ -46,6 +46,20 @@ public:
 	BVHObjectBinning range;
 };
 
+/* BVH Spatial Split Build Task */
+
+class BVHSpatialSplitBuildTask : public Task {
+public:
+	BVHSpatialSplitBuildTask(BVHBuild *build, InnerNode *node, int child, const BVHRange& range_,
+	                         vector<BVHReference> *references, int level)
+	: range(range_)
+	{
+		run = function_bind(&BVHBuild::thread_build_spatial_split_node, build, node, child, &range, references, level);
+	}
+
+	BVHRange range;
+};
+
 /* Constructor / Destructor */
 
 BVHBuild::BVHBuild(const vector<Object*>& objects_,
@@ -64,6 +78,10 @@ BVHBuild::BVHBuild(const vector<Object*>& objects_,
 
 BVHBuild::~BVHBuild()
 {
+	map<BVHNode*, vector<BVHReference>*>::iterator it;
+
+	for(it = spatial_references.begin(); it != spatial_references.end(); it++)
+		delete it->second;
 }
 
 /* Adding References */
@@ -198,8 +216,6 @@ BVHNode* BVHBuild::run()
 		params.use_spatial_split = false;
 
 	spatial_min_overlap = root.bounds().safe_area() * params.spatial_split_alpha;
-	spatial_right_bounds.clear();
-	spatial_right_bounds.resize(max(root.size(), (int)BVHParams::NUM_SPATIAL_BINS) - 1);
 
 	/* init progress updates */
 	progress_start_time = time_dt();
@@ -207,18 +223,33 @@ BVHNode* BVHBuild::run()
 	progress_total = references.size();
 	progress_original_total = progress_total;
 
-	prim_segment.resize(references.size());
-	prim_index.resize(references.size());
-	prim_object.resize(references.size());
-
 	/* build recursively */
 	BVHNode *rootnode;
 
 	if(params.use_spatial_split) {
-		/* singlethreaded spatial split build */
-		rootnode = build_node(root, 0);
+		/* multithreaded spatial split build, primitives are assigned to leaves
+		 * afterwards in depth first order, so that the result does not depend
+		 * on the order in which threads finish */
+		prim_segment.clear();
+		prim_index.clear();
+		prim_object.clear();
+
+		prim_segment.reserve(references.size());
+		prim_index.reserve(references.size());
+		prim_object.reserve(references.size());
+
+		BVHSpatialStorage storage;
+		rootnode = build_node(root, &references, &storage, 0);
+		task_pool.wait_work();
+
+		if(rootnode && !progress.get_cancel())
+			spatial_assign_primitives(rootnode, &references);
 	}
 	else {
+		prim_segment.resize(references.size());
+		prim_index.resize(references.size());
+		prim_object.resize(references.size());
+
 		/* multithreaded binning build */
 		BVHObjectBinning rootbin(root, (references.size())? &references[0]: NULL);
 		rootnode = build_node(rootbin, 0);
@@ -231,7 +262,7 @@ BVHNode* BVHBuild::run()
 			rootnode->deleteSubtree();
 			rootnode = NULL;
 		}
-		else if(!params.use_spatial_split) {
+		else {
 			/*rotate(rootnode, 4, 5);*/
 			rootnode->update_visibility();
 		}
@@ -317,48 +348,140 @@ BVHNode* BVHBuild::build_node(const BVHObjectBinning& range, int level)
 	return inner;
 }
 
-/* single threaded spatial split builder */
-BVHNode* BVHBuild::build_node(const BVHRange& range, int level)
+void BVHBuild::thread_build_spatial_split_node(InnerNode *inner, int child, BVHRange *range, vector<BVHReference> *references, int level)
+{
+	if(progress.get_cancel()) {
+		delete references;
+		return;
+	}
+
+	/* build nodes */
+	BVHSpatialStorage storage;
+	BVHNode *node = build_node(*range, references, &storage, level);
+
+	/* set child in inner node */
+	inner->children[child] = node;
+
+	if(!node) {
+		delete references;
+		return;
+	}
+
+	/* remember which references the leaves of this subtree point into */
+	thread_scoped_lock lock(build_mutex);
+	spatial_references[node] = references;
+}
+
+void BVHBuild::spatial_progress_update(size_t num_done, size_t num_duplicates)
 {
-	/* progress update */
+	thread_scoped_lock lock(build_mutex);
+
+	progress_count += num_done;
+	progress_total += num_duplicates;
 	progress_update();
+}
+
+/* multithreaded spatial split builder */
+BVHNode* BVHBuild::build_node(const BVHRange& range, vector<BVHReference> *references, BVHSpatialStorage *storage, int level)
+{
+	/* subtrees below the task size are built in one go and spatial splits make
+	 * them slow, so check for cancel and update progress for every node */
 	if(progress.get_cancel())
 		return NULL;
 
 	/* small enough or too deep => create leaf. */
 	if(!(range.size() > 0 && params.top_level && level == 0)) {
 		if(params.small_enough_for_leaf(range.size(), level)) {
-			progress_count += range.size();
-			return create_leaf_node(range);
+			spatial_progress_update(range.size(), 0);
+			return create_spatial_leaf_node(range, *references);
 		}
 	}
 
 	/* splitting test */
-	BVHMixedSplit split(this, range, level);
+	BVHMixedSplit split(this, storage, *references, range, level);
 
 	if(!(range.size() > 0 && params.top_level && level == 0)) {
 		if(split.no_split) {
-			progress_count += range.size();
-			return create_leaf_node(range);
+			spatial_progress_update(range.size(), 0);
+			return create_spatial_leaf_node(range, *references);
 		}
 	}
 	
 	/* do split */
 	BVHRange left, right;
-	split.split(this, left, right, range);
+	split.split(this, *references, left, right, range);
 
-	progress_total += left.size() + right.size() - range.size();
-	size_t total = progress_total;
+	size_t num_duplicates = left.size() + right.size() - range.size();
 
-	/* leaft node */
-	BVHNode *leftnode = build_node(left, level + 1);
+	if(num_duplicates)
+		spatial_progress_update(0, num_duplicates);
 
-	/* right node (modify start for splits) */
-	right.set_start(right.start() + progress_total - total);
-	BVHNode *rightnode = build_node(right, level + 1);
+	if(range.size() < THREAD_TASK_SIZE) {
+		/* local build */
+		size_t num_references = references->size();
+
+		/* left node */
+		BVHNode *leftnode = build_node(left, references, storage, level + 1);
+
+		/* right node (modify start for duplicates inserted by left splits) */
+		right.set_start(right.start() + references->size() - num_references);
+		BVHNode *rightnode = build_node(right, references, storage, level + 1);
+
+		/* inner node */
+		return new InnerNode(range.bounds(), leftnode, rightnode);
+	}
+
+	/* threaded build, children get their own references. sizes only shrink
+	 * further down the tree, so a range this large always covers all of
+	 * the references it was handed, which can be freed now */
+	assert(range.start() == 0 && range.size() == references->size());
+
+	vector<BVHReference> *left_references = new vector<BVHReference>(
+		references->begin() + left.start(), references->begin() + left.end());
+	vector<BVHReference> *right_references = new vector<BVHReference>(
+		references->begin() + right.start(), references->begin() + right.end());
+
+	vector<BVHReference>().swap(*references);
+
+	InnerNode *inner = new InnerNode(range.bounds());
+
+	task_pool.push(new BVHSpatialSplitBuildTask(this, inner, 0,
+		BVHRange(left.bounds(), 0, left.size()), left_references, level + 1), true);
+	task_pool.push(new BVHSpatialSplitBuildTask(this, inner, 1,
+		BVHRange(right.bounds(), 0, right.size()), right_references, level + 1), true);
+
+	return inner;
+}
+
+void BVHBuild::spatial_assign_primitives(BVHNode *node, const vector<BVHReference> *references)
+{
+	/* subtrees built in threads index into their own references */
+	map<BVHNode*, vector<BVHReference>*>::iterator it = spatial_references.find(node);
+
+	if(it != spatial_references.end())
+		references = it->second;
 
-	/* inner node */
-	return new InnerNode(range.bounds(), leftnode, rightnode);
+	if(node->is_leaf()) {
+		LeafNode *leaf = (LeafNode*)node;
+		int start = prim_index.size();
+
+		for(int i = leaf->m_lo; i < leaf->m_hi; i++) {
+			const BVHReference& ref = (*references)[i];
+
+			prim_segment.push_back(ref.prim_segment());
+			prim_index.push_back(ref.prim_index());
+			prim_object.push_back(ref.prim_object());
+		}
+
+		leaf->m_lo = start;
+		leaf->m_hi = prim_index.size();
+	}
+	else {
+		InnerNode *inner = (InnerNode*)node;
+
+		spatial_assign_primitives(inner->children[0], references);
+		spatial_assign_primitives(inner->children[1], references);
+	}
 }
 
 /* Create Nodes */
@@ -399,6 +522,23 @@ BVHNode *BVHBuild::create_object_leaf_nodes(const BVHReference *ref, int start,
 	}
 }
 
+BVHNode* BVHBuild::create_spatial_leaf_node(const BVHRange& range, const vector<BVHReference>& references)
+{
+	/* spatial splits are not used for the top level, so there are no object
+	 * references here. primitives are assigned once the tree is complete. */
+	BoundBox bounds = BoundBox::empty;
+	uint visibility = 0;
+
+	for(int i = range.start(); i < range.end(); i++) {
+		const BVHReference& ref = references[i];
+
+		bounds.grow(ref.bounds());
+		visibility |= objects[ref.prim_object()]->visibility;
+	}
+
+	return new LeafNode(bounds, visibility, range.start(), range.end());
+}
+
 BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
 {
 	vector<int>& p_segment = prim_segment;
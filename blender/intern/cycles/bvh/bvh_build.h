@@ -24,6 +24,7 @@
 #include "bvh_binning.h"
 
 #include "util_boundbox.h"
+#include "util_map.h"
 #include "util_task.h"
 #include "util_vector.h"
 
@@ -58,6 +59,7 @@ protected:
 	friend class BVHObjectSplit;
 	friend class BVHSpatialSplit;
 	friend class BVHBuildTask;
+	friend class BVHSpatialSplitBuildTask;
 
 	/* adding references */
 	void add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh, int i);
@@ -65,18 +67,24 @@ protected:
 	void add_references(BVHRange& root);
 
 	/* building */
-	BVHNode *build_node(const BVHRange& range, int level);
+	BVHNode *build_node(const BVHRange& range, vector<BVHReference> *references, BVHSpatialStorage *storage, int level);
 	BVHNode *build_node(const BVHObjectBinning& range, int level);
 	BVHNode *create_leaf_node(const BVHRange& range);
+	BVHNode *create_spatial_leaf_node(const BVHRange& range, const vector<BVHReference>& references);
 	BVHNode *create_object_leaf_nodes(const BVHReference *ref, int start, int num);
 
 	/* threads */
 	enum { THREAD_TASK_SIZE = 4096 };
 	void thread_build_node(InnerNode *node, int child, BVHObjectBinning *range, int level);
+	void thread_build_spatial_split_node(InnerNode *node, int child, BVHRange *range, vector<BVHReference> *references, int level);
 	thread_mutex build_mutex;
 
+	/* spatial split primitive output */
+	void spatial_assign_primitives(BVHNode *node, const vector<BVHReference> *references);
+
 	/* progress */
 	void progress_update();
+	void spatial_progress_update(size_t num_done, size_t num_duplicates);
 
 	/* tree rotations */
 	void rotate(BVHNode *node, int max_depth);
@@ -102,10 +110,10 @@ protected:
 	size_t progress_total;
 	size_t progress_original_total;
 
-	/* spatial splitting */
+	/* spatial splitting, subtrees built in threads get their own copy of the
+	 * references, since splits insert duplicates */
 	float spatial_min_overlap;
-	vector<BoundBox> spatial_right_bounds;
-	BVHSpatialBin spatial_bins[3][BVHParams::NUM_SPATIAL_BINS];
+	map<BVHNode*, vector<BVHReference>*> spatial_references;
 
 	/* threads */
 	TaskPool task_pool;
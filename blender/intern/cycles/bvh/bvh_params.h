@@ -19,6 +19,7 @@
 #define __BVH_PARAMS_H__
 
 #include "util_boundbox.h"
+#include "util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -171,6 +172,17 @@ struct BVHSpatialBin
 	}
 };
 
+/* BVH Spatial Storage
+ *
+ * Scratch memory used while evaluating spatial splits. Each build thread has
+ * its own, so that subtrees can be built in parallel. */
+
+struct BVHSpatialStorage
+{
+	vector<BoundBox> right_bounds;
+	BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS];
+};
+
 CCL_NAMESPACE_END
 
 #endif /* __BVH_PARAMS_H__ */
@@ -37,9 +37,10 @@ public:
 	BoundBox right_bounds;
 
 	BVHObjectSplit() {}
-	BVHObjectSplit(BVHBuild *builder, const BVHRange& range, float nodeSAH);
+	BVHObjectSplit(BVHBuild *builder, BVHSpatialStorage *storage, vector<BVHReference>& references,
+	               const BVHRange& range, float nodeSAH);
 
-	void split(BVHBuild *builder, BVHRange& left, BVHRange& right, const BVHRange& range);
+	void split(BVHBuild *builder, vector<BVHReference>& references, BVHRange& left, BVHRange& right, const BVHRange& range);
 };
 
 /* Spatial Split */
@@ -52,9 +53,10 @@ public:
 	float pos;
 
 	BVHSpatialSplit() : sah(FLT_MAX), dim(0), pos(0.0f) {}
-	BVHSpatialSplit(BVHBuild *builder, const BVHRange& range, float nodeSAH);
+	BVHSpatialSplit(BVHBuild *builder, BVHSpatialStorage *storage, vector<BVHReference>& references,
+	                const BVHRange& range, float nodeSAH);
 
-	void split(BVHBuild *builder, BVHRange& left, BVHRange& right, const BVHRange& range);
+	void split(BVHBuild *builder, vector<BVHReference>& references, BVHRange& left, BVHRange& right, const BVHRange& range);
 	void split_reference(BVHBuild *builder, BVHReference& left, BVHReference& right, const BVHReference& ref, int dim, float pos);
 };
 
@@ -72,7 +74,8 @@ public:
 
 	bool no_split;
 
-	__forceinline BVHMixedSplit(BVHBuild *builder, const BVHRange& range, int level)
+	__forceinline BVHMixedSplit(BVHBuild *builder, BVHSpatialStorage *storage, vector<BVHReference>& references,
+	                            const BVHRange& range, int level)
 	{
 		/* find split candidates. */
 		float area = range.bounds().safe_area();
@@ -80,14 +83,14 @@ public:
 		leafSAH = area * builder->params.triangle_cost(range.size());
 		nodeSAH = area * builder->params.node_cost(2);
 
-		object = BVHObjectSplit(builder, range, nodeSAH);
+		object = BVHObjectSplit(builder, storage, references, range, nodeSAH);
 
 		if(builder->params.use_spatial_split && level < BVHParams::MAX_SPATIAL_DEPTH) {
 			BoundBox overlap = object.left_bounds;
 			overlap.intersect(object.right_bounds);
 
 			if(overlap.safe_area() >= builder->spatial_min_overlap)
-				spatial = BVHSpatialSplit(builder, range, nodeSAH);
+				spatial = BVHSpatialSplit(builder, storage, references, range, nodeSAH);
 		}
 
 		/* leaf SAH is the lowest => create leaf. */
@@ -95,12 +98,12 @@ public:
 		no_split = (minSAH == leafSAH && range.size() <= builder->params.max_leaf_size);
 	}
 
-	__forceinline void split(BVHBuild *builder, BVHRange& left, BVHRange& right, const BVHRange& range)
+	__forceinline void split(BVHBuild *builder, vector<BVHReference>& references, BVHRange& left, BVHRange& right, const BVHRange& range)
 	{
 		if(builder->params.use_spatial_split && minSAH == spatial.sah)
-			spatial.split(builder, left, right, range);
+			spatial.split(builder, references, left, right, range);
 		if(!left.size() || !right.size())
-			object.split(builder, left, right, range);
+			object.split(builder, references, left, right, range);
 	}
 };
 
@@ -33,6 +33,7 @@ CCL_NAMESPACE_BEGIN
 
 class Progress;
 class RenderTile;
+struct KernelStats;
 
 /* Device Types */
 
@@ -54,6 +55,7 @@ public:
 	bool display_device;
 	bool advanced_shading;
 	bool pack_images;
+	bool compact_images;
 	vector<DeviceInfo> multi_devices;
 
 	DeviceInfo()
@@ -64,6 +66,7 @@ public:
 		display_device = false;
 		advanced_shading = true;
 		pack_images = false;
+		compact_images = false;
 	}
 };
 
@@ -111,6 +114,10 @@ public:
 	/* open shading language, only for CPU device */
 	virtual void *osl_memory() { return NULL; }
 
+	/* render statistics, only for CPU device built with WITH_CYCLES_STATS.
+	 * adds statistics since the last reset, returns false if not supported */
+	virtual bool kernel_stats(KernelStats *kstats, bool reset) { return false; }
+
 	/* load/compile kernels, must be called before adding tasks */ 
 	virtual bool load_kernels(bool experimental) { return true; }
 
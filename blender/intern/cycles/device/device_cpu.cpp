@@ -40,6 +40,54 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Kernel Functions
+ *
+ * kernels compiled for each instruction set, the best one the CPU supports
+ * is selected once when creating the device */
+
+struct CPUKernelFunctions {
+	void (*path_trace)(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
+		int sample, int x, int y, int offset, int stride);
+	void (*convert_to_byte)(KernelGlobals *kg, uchar4 *rgba, float *buffer,
+		float sample_scale, int x, int y, int offset, int stride);
+	void (*convert_to_half_float)(KernelGlobals *kg, uchar4 *rgba, float *buffer,
+		float sample_scale, int x, int y, int offset, int stride);
+	void (*shader)(KernelGlobals *kg, uint4 *input, float4 *output,
+		int type, int i);
+};
+
+#define CPU_KERNEL_FUNCTIONS(prefix) \
+	{prefix##_path_trace, prefix##_convert_to_byte, prefix##_convert_to_half_float, prefix##_shader}
+
+static CPUKernelFunctions cpu_kernel_functions()
+{
+#ifdef WITH_OPTIMIZED_KERNEL
+#ifdef WITH_KERNEL_AVX2
+	if(system_cpu_support_avx2()) {
+		CPUKernelFunctions functions = CPU_KERNEL_FUNCTIONS(kernel_cpu_avx2);
+		return functions;
+	}
+#endif
+#ifdef WITH_KERNEL_AVX
+	if(system_cpu_support_avx()) {
+		CPUKernelFunctions functions = CPU_KERNEL_FUNCTIONS(kernel_cpu_avx);
+		return functions;
+	}
+#endif
+	if(system_cpu_support_sse3()) {
+		CPUKernelFunctions functions = CPU_KERNEL_FUNCTIONS(kernel_cpu_sse3);
+		return functions;
+	}
+	if(system_cpu_support_sse2()) {
+		CPUKernelFunctions functions = CPU_KERNEL_FUNCTIONS(kernel_cpu_sse2);
+		return functions;
+	}
+#endif
+
+	CPUKernelFunctions functions = CPU_KERNEL_FUNCTIONS(kernel_cpu);
+	return functions;
+}
+
 class CPUDevice : public Device
 {
 public:
@@ -48,16 +96,27 @@ public:
 #ifdef WITH_OSL
 	OSLGlobals osl_globals;
 #endif
+#ifdef __KERNEL_STATS__
+	KernelStats stats_sum;
+	thread_mutex stats_mutex;
+#endif
+	CPUKernelFunctions kernel_functions;
 	
 	CPUDevice(Stats &stats) : Device(stats)
 	{
+		kernel_globals.texture_cache = NULL;
+
+#ifdef __KERNEL_STATS__
+		memset(&kernel_globals.stats, 0, sizeof(kernel_globals.stats));
+		memset(&stats_sum, 0, sizeof(stats_sum));
+#endif
+
 #ifdef WITH_OSL
 		kernel_globals.osl = &osl_globals;
 #endif
 
 		/* do now to avoid thread issues */
-		system_cpu_support_sse2();
-		system_cpu_support_sse3();
+		kernel_functions = cpu_kernel_functions();
 	}
 
 	~CPUDevice()
@@ -101,7 +160,8 @@ public:
 
 	void tex_alloc(const char *name, device_memory& mem, bool interpolation, bool periodic)
 	{
-		kernel_tex_copy(&kernel_globals, name, mem.data_pointer, mem.data_width, mem.data_height);
+		kernel_tex_copy(&kernel_globals, name, mem.data_pointer, mem.data_width, mem.data_height,
+			mem.data_elements, datatype_size(mem.data_type));
 		mem.device_pointer = mem.data_pointer;
 
 		stats.mem_alloc(mem.memory_size());
@@ -123,6 +183,44 @@ public:
 #endif
 	}
 
+	bool kernel_stats(KernelStats *kstats, bool reset)
+	{
+#ifdef __KERNEL_STATS__
+		thread_scoped_lock lock(stats_mutex);
+
+		kernel_stats_add(kstats, &stats_sum);
+
+		if(reset)
+			memset(&stats_sum, 0, sizeof(stats_sum));
+
+		return true;
+#else
+		return false;
+#endif
+	}
+
+#ifdef __KERNEL_STATS__
+	static void kernel_stats_add(KernelStats *a, const KernelStats *b)
+	{
+		a->samples += b->samples;
+		a->bvh_nodes += b->bvh_nodes;
+
+		for(int i = 0; i < STATS_RAY_NUM; i++)
+			a->rays[i] += b->rays[i];
+		for(int i = 0; i < STATS_SHADER_NUM; i++)
+			a->shader_evals[i] += b->shader_evals[i];
+		for(int i = 0; i < STATS_PHASE_NUM; i++)
+			a->phase_time[i] += b->phase_time[i];
+	}
+
+	/* add statistics of thread, counted without locking in its own globals */
+	void thread_stats_add(KernelGlobals *kg)
+	{
+		thread_scoped_lock lock(stats_mutex);
+		kernel_stats_add(&stats_sum, &kg->stats);
+	}
+#endif
+
 	void thread_run(DeviceTask *task)
 	{
 		if(task->type == DeviceTask::PATH_TRACE)
@@ -163,65 +261,22 @@ public:
 			int start_sample = tile.start_sample;
 			int end_sample = tile.start_sample + tile.num_samples;
 
-#ifdef WITH_OPTIMIZED_KERNEL
-			if(system_cpu_support_sse3()) {
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
-
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_sse3_path_trace(&kg, render_buffer, rng_state,
-								sample, x, y, tile.offset, tile.stride);
-						}
-					}
-
-					tile.sample = sample + 1;
-
-					task.update_progress(tile);
+			for(int sample = start_sample; sample < end_sample; sample++) {
+				if (task.get_cancel() || task_pool.canceled()) {
+					if(task.need_finish_queue == false)
+						break;
 				}
-			}
-			else if(system_cpu_support_sse2()) {
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
 
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_sse2_path_trace(&kg, render_buffer, rng_state,
-								sample, x, y, tile.offset, tile.stride);
-						}
+				for(int y = tile.y; y < tile.y + tile.h; y++) {
+					for(int x = tile.x; x < tile.x + tile.w; x++) {
+						kernel_functions.path_trace(&kg, render_buffer, rng_state,
+							sample, x, y, tile.offset, tile.stride);
 					}
-
-					tile.sample = sample + 1;
-
-					task.update_progress(tile);
 				}
-			}
-			else
-#endif
-			{
-				for(int sample = start_sample; sample < end_sample; sample++) {
-					if (task.get_cancel() || task_pool.canceled()) {
-						if(task.need_finish_queue == false)
-							break;
-					}
-
-					for(int y = tile.y; y < tile.y + tile.h; y++) {
-						for(int x = tile.x; x < tile.x + tile.w; x++) {
-							kernel_cpu_path_trace(&kg, render_buffer, rng_state,
-								sample, x, y, tile.offset, tile.stride);
-						}
-					}
 
-					tile.sample = sample + 1;
+				tile.sample = sample + 1;
 
-					task.update_progress(tile);
-				}
+				task.update_progress(tile);
 			}
 
 			task.release_tile(tile);
@@ -232,6 +287,10 @@ public:
 			}
 		}
 
+#ifdef __KERNEL_STATS__
+		thread_stats_add(&kg);
+#endif
+
 #ifdef WITH_OSL
 		OSLShader::thread_free(&kg);
 #endif
@@ -242,50 +301,16 @@ public:
 		float sample_scale = 1.0f/(task.sample + 1);
 
 		if(task.rgba_half) {
-#ifdef WITH_OPTIMIZED_KERNEL
-			if(system_cpu_support_sse3()) {
-				for(int y = task.y; y < task.y + task.h; y++)
-					for(int x = task.x; x < task.x + task.w; x++)
-						kernel_cpu_sse3_convert_to_half_float(&kernel_globals, (uchar4*)task.rgba_half, (float*)task.buffer,
-							sample_scale, x, y, task.offset, task.stride);
-			}
-			else if(system_cpu_support_sse2()) {
-				for(int y = task.y; y < task.y + task.h; y++)
-					for(int x = task.x; x < task.x + task.w; x++)
-						kernel_cpu_sse2_convert_to_half_float(&kernel_globals, (uchar4*)task.rgba_half, (float*)task.buffer,
-							sample_scale, x, y, task.offset, task.stride);
-			}
-			else
-#endif
-			{
-				for(int y = task.y; y < task.y + task.h; y++)
-					for(int x = task.x; x < task.x + task.w; x++)
-						kernel_cpu_convert_to_half_float(&kernel_globals, (uchar4*)task.rgba_half, (float*)task.buffer,
-							sample_scale, x, y, task.offset, task.stride);
-			}
+			for(int y = task.y; y < task.y + task.h; y++)
+				for(int x = task.x; x < task.x + task.w; x++)
+					kernel_functions.convert_to_half_float(&kernel_globals, (uchar4*)task.rgba_half, (float*)task.buffer,
+						sample_scale, x, y, task.offset, task.stride);
 		}
 		else {
-#ifdef WITH_OPTIMIZED_KERNEL
-			if(system_cpu_support_sse3()) {
-				for(int y = task.y; y < task.y + task.h; y++)
-					for(int x = task.x; x < task.x + task.w; x++)
-						kernel_cpu_sse3_convert_to_byte(&kernel_globals, (uchar4*)task.rgba_byte, (float*)task.buffer,
-							sample_scale, x, y, task.offset, task.stride);
-			}
-			else if(system_cpu_support_sse2()) {
-				for(int y = task.y; y < task.y + task.h; y++)
-					for(int x = task.x; x < task.x + task.w; x++)
-						kernel_cpu_sse2_convert_to_byte(&kernel_globals, (uchar4*)task.rgba_byte, (float*)task.buffer,
-							sample_scale, x, y, task.offset, task.stride);
-			}
-			else
-#endif
-			{
-				for(int y = task.y; y < task.y + task.h; y++)
-					for(int x = task.x; x < task.x + task.w; x++)
-						kernel_cpu_convert_to_byte(&kernel_globals, (uchar4*)task.rgba_byte, (float*)task.buffer,
-							sample_scale, x, y, task.offset, task.stride);
-			}
+			for(int y = task.y; y < task.y + task.h; y++)
+				for(int x = task.x; x < task.x + task.w; x++)
+					kernel_functions.convert_to_byte(&kernel_globals, (uchar4*)task.rgba_byte, (float*)task.buffer,
+						sample_scale, x, y, task.offset, task.stride);
 		}
 	}
 
@@ -297,33 +322,16 @@ public:
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
 
-#ifdef WITH_OPTIMIZED_KERNEL
-		if(system_cpu_support_sse3()) {
-			for(int x = task.shader_x; x < task.shader_x + task.shader_w; x++) {
-				kernel_cpu_sse3_shader(&kg, (uint4*)task.shader_input, (float4*)task.shader_output, task.shader_eval_type, x);
+		for(int x = task.shader_x; x < task.shader_x + task.shader_w; x++) {
+			kernel_functions.shader(&kg, (uint4*)task.shader_input, (float4*)task.shader_output, task.shader_eval_type, x);
 
-				if(task_pool.canceled())
-					break;
-			}
+			if(task_pool.canceled())
+				break;
 		}
-		else if(system_cpu_support_sse2()) {
-			for(int x = task.shader_x; x < task.shader_x + task.shader_w; x++) {
-				kernel_cpu_sse2_shader(&kg, (uint4*)task.shader_input, (float4*)task.shader_output, task.shader_eval_type, x);
 
-				if(task_pool.canceled())
-					break;
-			}
-		}
-		else
+#ifdef __KERNEL_STATS__
+		thread_stats_add(&kg);
 #endif
-		{
-			for(int x = task.shader_x; x < task.shader_x + task.shader_w; x++) {
-				kernel_cpu_shader(&kg, (uint4*)task.shader_input, (float4*)task.shader_output, task.shader_eval_type, x);
-
-				if(task_pool.canceled())
-					break;
-			}
-		}
 
 #ifdef WITH_OSL
 		OSLShader::thread_free(&kg);
@@ -366,6 +374,7 @@ void device_cpu_info(vector<DeviceInfo>& devices)
 	info.num = 0;
 	info.advanced_shading = true;
 	info.pack_images = false;
+	info.compact_images = true;
 
 	devices.insert(devices.begin(), info);
 }
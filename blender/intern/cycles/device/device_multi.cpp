@@ -278,6 +278,17 @@ public:
 		return -1;
 	}
 
+	bool kernel_stats(KernelStats *kstats, bool reset)
+	{
+		bool supported = false;
+
+		foreach(SubDevice& sub, devices)
+			if(sub.device->kernel_stats(kstats, reset))
+				supported = true;
+
+		return supported;
+	}
+
 	void task_add(DeviceTask& task)
 	{
 		list<DeviceTask> tasks;
@@ -328,6 +339,7 @@ static bool device_multi_add(vector<DeviceInfo>& devices, DeviceType type, bool
 
 	info.advanced_shading = with_advanced_shading;
 	info.pack_images = false;
+	info.compact_images = true;
 
 	foreach(DeviceInfo& subinfo, devices) {
 		if(subinfo.type == type) {
@@ -351,6 +363,7 @@ static bool device_multi_add(vector<DeviceInfo>& devices, DeviceType type, bool
 			if(subinfo.display_device)
 				info.display_device = true;
 			info.pack_images = info.pack_images || subinfo.pack_images;
+			info.compact_images = info.compact_images && subinfo.compact_images;
 			num_added++;
 		}
 	}
@@ -53,6 +53,8 @@ public:
 		if(error)
 			throw boost::system::system_error(error);
 
+		network_compression_init();
+
 		mem_counter = 0;
 	}
 
@@ -93,8 +95,12 @@ public:
 		snd.add(elem);
 		snd.write();
 
+		/* only the requested rows are sent back */
+		size_t offset = (size_t)elem*y*w;
+		size_t size = (size_t)elem*w*h;
+
 		RPCReceive rcv(socket);
-		rcv.read_buffer((void*)mem.data_pointer, mem.memory_size());
+		rcv.read_buffer((uint8_t*)mem.data_pointer + offset, size);
 	}
 
 	void mem_zero(device_memory& mem)
@@ -197,6 +203,7 @@ public:
 
 				for(list<RenderTile>::iterator it = the_tiles.begin(); it != the_tiles.end(); it++) {
 					if(tile.x == it->x && tile.y == it->y && tile.start_sample == it->start_sample) {
+						tile.tile_index = it->tile_index;
 						tile.buffers = it->buffers;
 						the_tiles.erase(it);
 						break;
@@ -246,6 +253,8 @@ public:
 	DeviceServer(Device *device_, tcp::socket& socket_)
 	: device(device_), socket(socket_)
 	{
+		num_tile_requests = 0;
+		no_more_tiles = false;
 	}
 
 	void listen()
@@ -320,9 +329,12 @@ protected:
 
 			device->mem_copy_from(mem, y, w, h, elem);
 
+			size_t offset = (size_t)elem*y*w;
+			size_t size = (size_t)elem*w*h;
+
 			RPCSend snd(socket);
 			snd.write();
-			snd.write_buffer((uint8_t*)mem.data_pointer, mem.memory_size());
+			snd.write_buffer((uint8_t*)mem.data_pointer + offset, size);
 		}
 		else if(rcv.name == "mem_zero") {
 			network_device_memory mem;
@@ -419,6 +431,10 @@ protected:
 			task.update_tile_sample = function_bind(&DeviceServer::task_update_tile_sample, this, _1);
 			task.get_cancel = function_bind(&DeviceServer::task_get_cancel, this);
 
+			acquired_tiles.clear();
+			num_tile_requests = 0;
+			no_more_tiles = false;
+
 			device->task_add(task);
 		}
 		else if(rcv.name == "task_wait") {
@@ -430,36 +446,58 @@ protected:
 		else if(rcv.name == "task_cancel") {
 			device->task_cancel();
 		}
+		else if(rcv.name == "acquire_tile") {
+			/* reply to tile request */
+			RenderTile tile;
+
+			rcv.read(tile);
+
+			if(tile.buffer) tile.buffer = ptr_map[tile.buffer];
+			if(tile.rng_state) tile.rng_state = ptr_map[tile.rng_state];
+
+			acquired_tiles.push_back(tile);
+			num_tile_requests--;
+		}
+		else if(rcv.name == "acquire_tile_none") {
+			num_tile_requests--;
+			no_more_tiles = true;
+		}
+	}
+
+	void request_tile()
+	{
+		RPCSend snd(socket, "acquire_tile");
+		snd.write();
+
+		num_tile_requests++;
 	}
 
 	bool task_acquire_tile(Device *device, RenderTile& tile)
 	{
 		thread_scoped_lock acquire_lock(acquire_mutex);
 
-		bool result = false;
+		/* request tile if none was requested ahead */
+		if(acquired_tiles.empty() && num_tile_requests == 0 && !no_more_tiles)
+			request_tile();
 
-		RPCSend snd(socket, "acquire_tile");
-		snd.write();
-
-		while(1) {
+		/* wait for requested tile, replies are handled in process() */
+		while(acquired_tiles.empty() && num_tile_requests > 0) {
 			RPCReceive rcv(socket);
+			process(rcv);
+		}
 
-			if(rcv.name == "acquire_tile") {
-				rcv.read(tile);
+		if(acquired_tiles.empty())
+			return false;
 
-				if(tile.buffer) tile.buffer = ptr_map[tile.buffer];
-				if(tile.rng_state) tile.rng_state = ptr_map[tile.rng_state];
+		tile = acquired_tiles.front();
+		acquired_tiles.pop_front();
 
-				result = true;
-				break;
-			}
-			else if(rcv.name == "acquire_tile_none")
-				break;
-			else
-				process(rcv);
-		}
+		/* request the next tile already, so it arrives while this one renders
+		 * instead of waiting for a network round trip when it is needed */
+		if(acquired_tiles.empty() && num_tile_requests == 0 && !no_more_tiles)
+			request_tile();
 
-		return result;
+		return true;
 	}
 
 	void task_update_progress_sample()
@@ -509,6 +547,11 @@ protected:
 
 	thread_mutex acquire_mutex;
 
+	/* tiles requested ahead of time */
+	list<RenderTile> acquired_tiles;
+	int num_tile_requests;
+	bool no_more_tiles;
+
 	/* todo: free memory and device (osl) on network error */
 };
 
@@ -518,6 +561,8 @@ void Device::server_run()
 		/* starts thread that responds to discovery requests */
 		ServerDiscovery discovery;
 
+		network_compression_init();
+
 		for(;;) {
 			/* accept connection */
 			boost::asio::io_service io_service;
@@ -29,6 +29,10 @@
 
 #include <iostream>
 
+#ifdef WITH_LZO
+#include "minilzo.h"
+#endif
+
 #include "buffers.h"
 
 #include "util_foreach.h"
@@ -51,6 +55,21 @@ static const int DISCOVER_PORT = 5121;
 static const string DISCOVER_REQUEST_MSG = "REQUEST_RENDER_SERVER_IP";
 static const string DISCOVER_REPLY_MSG = "REPLY_RENDER_SERVER_IP";
 
+/* Buffers are sent in chunks of this size, each compressed separately so
+ * large buffers are streamed without compressing them fully in memory first.
+ * Chunks that do not get smaller, or all of them when built without LZO, are
+ * sent uncompressed. */
+static const size_t NETWORK_CHUNK_SIZE = 1024*1024;
+
+static inline bool network_compression_init()
+{
+#ifdef WITH_LZO
+	return (lzo_init() == LZO_E_OK);
+#else
+	return false;
+#endif
+}
+
 /* Serialization of device memory */
 
 class network_device_memory : public device_memory
@@ -104,6 +123,7 @@ public:
 	{
 		archive & tile.x & tile.y & tile.w & tile.h;
 		archive & tile.start_sample & tile.num_samples & tile.sample;
+		archive & tile.tile_index;
 		archive & tile.offset & tile.stride;
 		archive & tile.buffer & tile.rng_state;
 	}
@@ -140,14 +160,44 @@ public:
 
 	void write_buffer(void *buffer, size_t size)
 	{
-		boost::system::error_code error;
+		uint8_t *data = (uint8_t*)buffer;
 
-		boost::asio::write(socket,
-			boost::asio::buffer(buffer, size),
-			boost::asio::transfer_all(), error);
-		
-		if(error.value())
-			cout << "Network send error: " << error.message() << "\n";
+		for(size_t offset = 0; offset < size; offset += NETWORK_CHUNK_SIZE) {
+			size_t chunk_size = (size - offset < NETWORK_CHUNK_SIZE)? size - offset: NETWORK_CHUNK_SIZE;
+			uint8_t *chunk = data + offset;
+			size_t stored_size = chunk_size;
+
+#ifdef WITH_LZO
+			/* worst case size of incompressible data */
+			compressed.resize(NETWORK_CHUNK_SIZE + NETWORK_CHUNK_SIZE/16 + 64 + 3);
+			work_memory.resize(LZO1X_1_MEM_COMPRESS);
+
+			lzo_uint compressed_size;
+
+			if(lzo1x_1_compress(chunk, chunk_size, &compressed[0], &compressed_size, &work_memory[0]) == LZO_E_OK &&
+			   compressed_size < chunk_size)
+			{
+				chunk = &compressed[0];
+				stored_size = compressed_size;
+			}
+#endif
+
+			/* header with original and stored size, followed by data */
+			uint32_t header[2] = {(uint32_t)chunk_size, (uint32_t)stored_size};
+
+			boost::array<boost::asio::const_buffer, 2> buffers = {{
+				boost::asio::buffer(header, sizeof(header)),
+				boost::asio::buffer(chunk, stored_size)}};
+
+			boost::system::error_code error;
+
+			boost::asio::write(socket, buffers, boost::asio::transfer_all(), error);
+
+			if(error.value()) {
+				cout << "Network send error: " << error.message() << "\n";
+				break;
+			}
+		}
 	}
 
 protected:
@@ -156,6 +206,10 @@ protected:
 	ostringstream archive_stream;
 	boost::archive::text_oarchive archive;
 	bool sent;
+
+	/* compression buffers */
+	vector<uint8_t> compressed;
+	vector<uint8_t> work_memory;
 };
 
 /* Remote procedure call Receive */
@@ -223,10 +277,62 @@ public:
 
 	void read_buffer(void *buffer, size_t size)
 	{
-		size_t len = boost::asio::read(socket, boost::asio::buffer(buffer, size));
+		uint8_t *data = (uint8_t*)buffer;
+		size_t offset = 0;
+
+		while(offset < size) {
+			/* header with original and stored size of chunk */
+			uint32_t header[2];
+			size_t len = boost::asio::read(socket, boost::asio::buffer(header, sizeof(header)));
+
+			if(len != sizeof(header)) {
+				cout << "Network receive error: invalid chunk header size\n";
+				return;
+			}
+
+			size_t chunk_size = header[0];
+			size_t stored_size = header[1];
+
+			if(chunk_size == 0 || offset + chunk_size > size || stored_size > chunk_size) {
+				cout << "Network receive error: buffer size doesn't match expected size\n";
+				return;
+			}
+
+			if(stored_size == chunk_size) {
+				/* uncompressed */
+				len = boost::asio::read(socket, boost::asio::buffer(data + offset, chunk_size));
+
+				if(len != chunk_size) {
+					cout << "Network receive error: buffer size doesn't match expected size\n";
+					return;
+				}
+			}
+			else {
+				compressed.resize(stored_size);
+				len = boost::asio::read(socket, boost::asio::buffer(&compressed[0], stored_size));
+
+				if(len != stored_size) {
+					cout << "Network receive error: buffer size doesn't match expected size\n";
+					return;
+				}
+
+#ifdef WITH_LZO
+				lzo_uint decompressed_size = chunk_size;
 
-		if(len != size)
-			cout << "Network receive error: buffer size doesn't match expected size\n";
+				if(lzo1x_decompress_safe(&compressed[0], stored_size, data + offset, &decompressed_size, NULL) != LZO_E_OK ||
+				   decompressed_size != chunk_size)
+				{
+					cout << "Network receive error: failed to decompress buffer\n";
+					return;
+				}
+#else
+				cout << "Network receive error: compressed buffer received, but built without LZO\n";
+				return;
+#endif
+			}
+
+			offset += chunk_size;
+		}
 	}
 
 	void read(DeviceTask& task)
@@ -235,7 +341,7 @@ public:
 
 		*archive & type & task.x & task.y & task.w & task.h;
 		*archive & task.rgba_byte & task.rgba_half & task.buffer & task.sample & task.num_samples;
-		*archive & task.resolution & task.offset & task.stride;
+		*archive & task.offset & task.stride;
 		*archive & task.shader_input & task.shader_output & task.shader_eval_type;
 		*archive & task.shader_x & task.shader_w;
 
@@ -246,8 +352,9 @@ public:
 	{
 		*archive & tile.x & tile.y & tile.w & tile.h;
 		*archive & tile.start_sample & tile.num_samples & tile.sample;
-		*archive & tile.resolution & tile.offset & tile.stride;
-		*archive & tile.buffer & tile.rng_state & tile.rgba_byte & tile.rgba_half;
+		*archive & tile.tile_index;
+		*archive & tile.offset & tile.stride;
+		*archive & tile.buffer & tile.rng_state;
 
 		tile.buffers = NULL;
 	}
@@ -259,6 +366,9 @@ protected:
 	string archive_str;
 	istringstream *archive_stream;
 	boost::archive::text_iarchive *archive;
+
+	/* compression buffer */
+	vector<uint8_t> compressed;
 };
 
 /* Server auto discovery */
@@ -33,11 +33,14 @@ void kernel_const_copy(KernelGlobals *kg, const char *name, void *host, size_t s
 {
 	if(strcmp(name, "__data") == 0)
 		memcpy(&kg->__data, host, size);
+	else if(strcmp(name, "__texture_cache") == 0)
+		memcpy(&kg->texture_cache, host, size);
 	else
 		assert(0);
 }
 
-void kernel_tex_copy(KernelGlobals *kg, const char *name, device_ptr mem, size_t width, size_t height)
+void kernel_tex_copy(KernelGlobals *kg, const char *name, device_ptr mem, size_t width, size_t height,
+	int channels, int channel_size)
 {
 	if(0) {
 	}
@@ -51,7 +54,7 @@ void kernel_tex_copy(KernelGlobals *kg, const char *name, device_ptr mem, size_t
 #include "kernel_textures.h"
 
 	else if(strstr(name, "__tex_image_float")) {
-		texture_image_float4 *tex = NULL;
+		texture_image_any *tex = NULL;
 		int id = atoi(name + strlen("__tex_image_float_"));
 		int array_index = id;
 
@@ -60,13 +63,15 @@ void kernel_tex_copy(KernelGlobals *kg, const char *name, device_ptr mem, size_t
 		}
 
 		if(tex) {
-			tex->data = (float4*)mem;
+			tex->data = (void*)mem;
 			tex->width = width;
 			tex->height = height;
+			tex->channels = channels;
+			tex->channel_size = channel_size;
 		}
 	}
 	else if(strstr(name, "__tex_image")) {
-		texture_image_uchar4 *tex = NULL;
+		texture_image_any *tex = NULL;
 		int id = atoi(name + strlen("__tex_image_"));
 		int array_index = id - MAX_FLOAT_IMAGES;
 
@@ -75,9 +80,11 @@ void kernel_tex_copy(KernelGlobals *kg, const char *name, device_ptr mem, size_t
 		}
 
 		if(tex) {
-			tex->data = (uchar4*)mem;
+			tex->data = (void*)mem;
 			tex->width = width;
 			tex->height = height;
+			tex->channels = channels;
+			tex->channel_size = channel_size;
 		}
 	}
 	else
@@ -90,6 +90,8 @@ __device uint BVH_FUNCTION_NAME(KernelGlobals *kg, const Ray *ray, Intersection
 			while(nodeAddr >= 0 && nodeAddr != ENTRYPOINT_SENTINEL)
 			{
 				bool traverseChild0, traverseChild1;
+
+				STATS_BVH_NODE(kg);
 				int nodeAddrChild1;
 
 #if !defined(__KERNEL_SSE2__)
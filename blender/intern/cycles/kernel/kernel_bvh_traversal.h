@@ -99,6 +99,8 @@ __device bool BVH_FUNCTION_NAME
 			while(nodeAddr >= 0 && nodeAddr != ENTRYPOINT_SENTINEL)
 			{
 				bool traverseChild0, traverseChild1;
+
+				STATS_BVH_NODE(kg);
 				int nodeAddrChild1;
 
 #if !defined(__KERNEL_SSE2__) || FEATURE(BVH_HAIR_MINIMUM_WIDTH)
@@ -21,6 +21,7 @@
 
 #include "util_debug.h"
 #include "util_math.h"
+#include "util_texture_cache.h"
 #include "util_types.h"
 
 CCL_NAMESPACE_BEGIN
@@ -71,6 +72,29 @@ template<typename T> struct texture_image  {
 		return make_float4(r.x*f, r.y*f, r.z*f, r.w*f);
 	}
 
+	float4 read(half4 r)
+	{
+		return make_float4(half_to_float(r.x), half_to_float(r.y), half_to_float(r.z), half_to_float(r.w));
+	}
+
+	/* single channel images are grey with alpha 1 */
+	float4 read(float r)
+	{
+		return make_float4(r, r, r, 1.0f);
+	}
+
+	float4 read(uchar r)
+	{
+		float f = r*(1.0f/255.0f);
+		return make_float4(f, f, f, 1.0f);
+	}
+
+	float4 read(half r)
+	{
+		float f = half_to_float(r);
+		return make_float4(f, f, f, 1.0f);
+	}
+
 	int wrap_periodic(int x, int width)
 	{
 		x %= width;
@@ -127,6 +151,34 @@ template<typename T> struct texture_image  {
 	int width, height;
 };
 
+/* Image texture with the pixel storage chosen per image on load, either four
+ * channels or a single channel, with byte, half float or float components. */
+
+struct texture_image_any {
+	float4 interp(float x, float y, bool periodic = true)
+	{
+		if(channel_size == 1)
+			return (channels == 1)? interp_type<uchar>(x, y, periodic): interp_type<uchar4>(x, y, periodic);
+		else if(channel_size == 2)
+			return (channels == 1)? interp_type<half>(x, y, periodic): interp_type<half4>(x, y, periodic);
+		else
+			return (channels == 1)? interp_type<float>(x, y, periodic): interp_type<float4>(x, y, periodic);
+	}
+
+	template<typename T> float4 interp_type(float x, float y, bool periodic)
+	{
+		texture_image<T> tex;
+		tex.data = (T*)data;
+		tex.width = width;
+		tex.height = height;
+		return tex.interp(x, y, periodic);
+	}
+
+	void *data;
+	int width, height;
+	int channels, channel_size;
+};
+
 typedef texture<float4> texture_float4;
 typedef texture<float2> texture_float2;
 typedef texture<float> texture_float;
@@ -74,6 +74,8 @@ __device_noinline bool direct_emission(KernelGlobals *kg, ShaderData *sd, int li
 	float randt, float rando, float randu, float randv, Ray *ray, BsdfEval *eval,
 	bool *is_lamp, int bounce)
 {
+	STATS_SCOPED_TIMER(kg, STATS_PHASE_LIGHTING);
+
 	LightSample ls;
 
 #ifdef __BRANCHED_PATH__
@@ -173,6 +175,9 @@ __device_noinline float3 indirect_primitive_emission(KernelGlobals *kg, ShaderDa
 		/* multiple importance sampling, get triangle light pdf,
 		 * and compute weight with respect to BSDF pdf */
 		float pdf = triangle_light_pdf(kg, sd->Ng, sd->I, t);
+
+		/* light tree selection probability, from the ray origin */
+		pdf *= light_tree_triangle_pdf_factor(kg, sd->object, sd->prim, sd->P + sd->I*t);
 		float mis_weight = power_heuristic(bsdf_pdf, pdf);
 
 		return L*mis_weight;
@@ -35,8 +35,8 @@ struct OSLShadingSystem;
 #define MAX_FLOAT_IMAGES  5
 
 typedef struct KernelGlobals {
-	texture_image_uchar4 texture_byte_images[MAX_BYTE_IMAGES];
-	texture_image_float4 texture_float_images[MAX_FLOAT_IMAGES];
+	texture_image_any texture_byte_images[MAX_BYTE_IMAGES];
+	texture_image_any texture_float_images[MAX_FLOAT_IMAGES];
 
 #define KERNEL_TEX(type, ttype, name) ttype name;
 #define KERNEL_IMAGE_TEX(type, ttype, name)
@@ -44,6 +44,15 @@ typedef struct KernelGlobals {
 
 	KernelData __data;
 
+	/* Image textures that are read from disk on demand instead of being stored
+	 * in the image arrays above, NULL if not used. */
+	TextureCache *texture_cache;
+
+#ifdef __KERNEL_STATS__
+	/* render statistics of the thread using these globals */
+	KernelStats stats;
+#endif
+
 #ifdef __OSL__
 	/* On the CPU, we also have the OSL globals here. Most data structures are shared
 	 * with SVM, the difference is in the shaders and object/mesh attributes. */
@@ -126,3 +135,5 @@ __device float lookup_table_read_2D(KernelGlobals *kg, float x, float y, int off
 
 CCL_NAMESPACE_END
 
+#include "kernel_stats.h"
+
@@ -515,14 +515,14 @@ __device void curve_segment_light_sample(KernelGlobals *kg, int prim, int object
 
 /* Light Distribution */
 
-__device int light_distribution_sample(KernelGlobals *kg, float randt)
+__device int light_distribution_sample_range(KernelGlobals *kg, float randt, int offset, int num)
 {
 	/* this is basically std::upper_bound as used by pbrt, to find a point light or
 	 * triangle to emit from, proportional to area. a good improvement would be to
 	 * also sample proportional to power, though it's not so well defined with
 	 * OSL shaders. */
-	int first = 0;
-	int len = kernel_data.integrator.num_distribution + 1;
+	int first = offset;
+	int len = num + 1;
 
 	while(len > 0) {
 		int half_len = len >> 1;
@@ -539,7 +539,233 @@ __device int light_distribution_sample(KernelGlobals *kg, float randt)
 
 	/* clamping should not be needed but float rounding errors seem to
 	 * make this fail on rare occasions */
-	return clamp(first-1, 0, kernel_data.integrator.num_distribution-1);
+	return clamp(first-1, offset, offset+num-1);
+}
+
+__device int light_distribution_sample(KernelGlobals *kg, float randt)
+{
+	return light_distribution_sample_range(kg, randt, 0, kernel_data.integrator.num_distribution);
+}
+
+/* Light Tree
+ *
+ * Emissive triangles and lamps with a position each have a binary tree over
+ * their part of the light distribution. Traversal picks a child with
+ * probability proportional to an estimate of its contribution, from its
+ * energy, distance and the orientation of its emitters, and leaves pick an
+ * emitter from the distribution. Selection probabilities are returned as a
+ * factor relative to the probability of the flat distribution.
+ *
+ * Node layout:
+ * 0: bounds min, energy
+ * 1: bounds max, cosine of the angle bounding the normals around the axis
+ * 2: axis
+ * 3: inner node: left child, right child, first emitter of right child, 0
+ *    leaf: first emitter, number of emitters, 0, 1 */
+
+__device float light_tree_node_importance(KernelGlobals *kg, int node, float3 P)
+{
+	float4 data0 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 0);
+	float4 data1 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 1);
+
+	float energy = data0.w;
+
+	if(energy == 0.0f)
+		return 0.0f;
+
+	float3 bmin = make_float3(data0.x, data0.y, data0.z);
+	float3 bmax = make_float3(data1.x, data1.y, data1.z);
+	float3 D = 0.5f*(bmin + bmax) - P;
+	float d2 = len_squared(D);
+	float r2 = 0.25f*len_squared(bmax - bmin);
+
+	/* inside the bounding sphere distance and orientation are not bounded */
+	if(d2 <= r2)
+		return (r2 > 0.0f)? energy/r2: energy;
+
+	float cos_theta_o = data1.w;
+	float cos_term = 1.0f;
+
+	if(cos_theta_o > 0.0f) {
+		/* normals are only bounded up to sign, as emission is two sided. the
+		 * angle between the direction and axis is reduced by the spread of the
+		 * normals and the angle the bounds subtend */
+		float4 data2 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 2);
+		float3 axis = make_float3(data2.x, data2.y, data2.z);
+
+		float theta = safe_acosf(fabsf(dot(axis, D))/sqrtf(d2));
+		float theta_o = safe_acosf(cos_theta_o);
+		float theta_u = safe_asinf(sqrtf(r2/d2));
+		float theta_min = theta - theta_o - theta_u;
+
+		if(theta_min > 0.0f)
+			cos_term = fmaxf(cosf(theta_min), 0.0f);
+	}
+
+	return energy*cos_term/d2;
+}
+
+__device float light_tree_child_probability(KernelGlobals *kg, int left, int right, float3 P)
+{
+	float importance_left = light_tree_node_importance(kg, left, P);
+	float importance_right = light_tree_node_importance(kg, right, P);
+	float importance = importance_left + importance_right;
+
+	if(importance > 0.0f)
+		return importance_left/importance;
+
+	/* fall back to energy, so that children without energy are never picked */
+	float energy_left = kernel_tex_fetch(__light_tree_nodes, left*LIGHT_TREE_NODE_SIZE).w;
+	float energy_right = kernel_tex_fetch(__light_tree_nodes, right*LIGHT_TREE_NODE_SIZE).w;
+	float energy = energy_left + energy_right;
+
+	return (energy > 0.0f)? energy_left/energy: 0.5f;
+}
+
+__device float light_tree_leaf_width(KernelGlobals *kg, float4 leaf)
+{
+	int first = __float_as_int(leaf.x);
+	int num = __float_as_int(leaf.y);
+
+	return kernel_tex_fetch(__light_distribution, first + num).x - kernel_tex_fetch(__light_distribution, first).x;
+}
+
+__device int light_tree_sample(KernelGlobals *kg, int root, float randt, float3 P, float *factor)
+{
+	int node = root;
+	float prob = 1.0f;
+	float4 link = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+
+	while(__float_as_int(link.w) == 0) {
+		int left = __float_as_int(link.x);
+		int right = __float_as_int(link.y);
+		float prob_left = light_tree_child_probability(kg, left, right, P);
+
+		/* pick child, and reuse random number */
+		if(randt < prob_left) {
+			node = left;
+			randt = randt/prob_left;
+			prob *= prob_left;
+		}
+		else {
+			node = right;
+			randt = fminf((randt - prob_left)/(1.0f - prob_left), 1.0f);
+			prob *= 1.0f - prob_left;
+		}
+
+		link = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+	}
+
+	/* pick emitter in leaf proportional to area */
+	int first = __float_as_int(link.x);
+	int num = __float_as_int(link.y);
+	float cdf_first = kernel_tex_fetch(__light_distribution, first).x;
+	float width = light_tree_leaf_width(kg, link);
+
+	*factor = (width > 0.0f)? prob/width: 0.0f;
+
+	return light_distribution_sample_range(kg, cdf_first + randt*width, first, num);
+}
+
+__device float light_tree_pdf_factor(KernelGlobals *kg, int root, int index, float3 P)
+{
+	int node = root;
+	float prob = 1.0f;
+	float4 link = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+
+	while(__float_as_int(link.w) == 0) {
+		int left = __float_as_int(link.x);
+		int right = __float_as_int(link.y);
+		float prob_left = light_tree_child_probability(kg, left, right, P);
+
+		/* follow the child containing the emitter */
+		if(index < __float_as_int(link.z)) {
+			node = left;
+			prob *= prob_left;
+		}
+		else {
+			node = right;
+			prob *= 1.0f - prob_left;
+		}
+
+		link = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+	}
+
+	float width = light_tree_leaf_width(kg, link);
+
+	return (width > 0.0f)? prob/width: 0.0f;
+}
+
+__device int light_tree_distribution_sample(KernelGlobals *kg, float randt, float3 P, float *factor)
+{
+	int num_triangles = kernel_data.integrator.light_tree_num_triangles;
+	int num_lamps = kernel_data.integrator.light_tree_num_lamps;
+
+	*factor = 1.0f;
+
+	/* triangles */
+	if(num_triangles) {
+		float cdf_end = kernel_tex_fetch(__light_distribution, num_triangles).x;
+
+		if(randt < cdf_end) {
+			int index = light_tree_sample(kg, kernel_data.integrator.light_tree_triangle_root, randt/cdf_end, P, factor);
+			*factor *= cdf_end;
+			return index;
+		}
+	}
+
+	/* lamps with a position */
+	if(num_lamps) {
+		float cdf_start = kernel_tex_fetch(__light_distribution, num_triangles).x;
+		float cdf_end = kernel_tex_fetch(__light_distribution, num_triangles + num_lamps).x;
+
+		if(randt >= cdf_start && randt < cdf_end) {
+			float width = cdf_end - cdf_start;
+			int index = light_tree_sample(kg, kernel_data.integrator.light_tree_lamp_root, (randt - cdf_start)/width, P, factor);
+			*factor *= width;
+			return index;
+		}
+	}
+
+	/* distant and background lamps */
+	return light_distribution_sample(kg, randt);
+}
+
+/* Factor for the pdf of an emissive triangle hit by a ray from P, for
+ * multiple importance sampling with the light tree */
+
+__device float light_tree_triangle_pdf_factor(KernelGlobals *kg, int object, int prim, float3 P)
+{
+	int num_triangles = kernel_data.integrator.light_tree_num_triangles;
+
+	if(num_triangles == 0)
+		return 1.0f;
+
+	/* emissive triangle range of the mesh, shared between instances */
+	uint range = kernel_tex_fetch(__light_tree_emitters, object*2 + 0);
+
+	if(range == ~0)
+		return 1.0f;
+
+	uint first = kernel_tex_fetch(__light_tree_emitters, range + 0);
+	uint num = kernel_tex_fetch(__light_tree_emitters, range + 1);
+	uint local = (uint)prim - first;
+
+	if(local >= num)
+		return 1.0f;
+
+	local = kernel_tex_fetch(__light_tree_emitters, range + 2 + local);
+
+	if(local == ~0)
+		return 1.0f;
+
+	/* distribution index of the emitter of this instance */
+	uint offset = kernel_tex_fetch(__light_tree_emitters, object*2 + 1);
+	uint index = kernel_tex_fetch(__light_tree_emitters, offset + local);
+
+	float cdf_end = kernel_tex_fetch(__light_distribution, num_triangles).x;
+
+	return cdf_end*light_tree_pdf_factor(kg, kernel_data.integrator.light_tree_triangle_root, index, P);
 }
 
 /* Generic Light */
@@ -547,7 +773,8 @@ __device int light_distribution_sample(KernelGlobals *kg, float randt)
 __device void light_sample(KernelGlobals *kg, float randt, float randu, float randv, float time, float3 P, LightSample *ls)
 {
 	/* sample index */
-	int index = light_distribution_sample(kg, randt);
+	float factor;
+	int index = light_tree_distribution_sample(kg, randt, P, &factor);
 
 	/* fetch light data */
 	float4 l = kernel_tex_fetch(__light_distribution, index);
@@ -568,12 +795,17 @@ __device void light_sample(KernelGlobals *kg, float randt, float randu, float ra
 
 		/* compute incoming direction, distance and pdf */
 		ls->D = normalize_len(ls->P - P, &ls->t);
-		ls->pdf = triangle_light_pdf(kg, ls->Ng, -ls->D, ls->t);
+		ls->pdf = triangle_light_pdf(kg, ls->Ng, -ls->D, ls->t)*factor;
 		ls->shader |= __float_as_int(l.z) & (~SHADER_MASK);
 	}
 	else {
 		int lamp = -prim-1;
 		lamp_light_sample(kg, lamp, randu, randv, P, ls);
+
+		/* lamp pdfs do not include the selection probability, it is part of
+		 * eval_fac instead */
+		if(factor != 1.0f)
+			ls->eval_fac = (factor > 0.0f)? ls->eval_fac/factor: 0.0f;
 	}
 }
 
@@ -164,5 +164,17 @@ __device_inline void kernel_write_light_passes(KernelGlobals *kg, __global float
 #endif
 }
 
+__device_inline void kernel_write_variance_pass(KernelGlobals *kg, __global float *buffer, int sample, float4 L)
+{
+#ifdef __PASSES__
+	/* sum of squared intensities, together with the combined pass this gives
+	 * the per pixel variance used for adaptive sampling */
+	if(kernel_data.film.pass_flag & PASS_VARIANCE) {
+		float f = average(float4_to_float3(L));
+		kernel_write_pass_float(buffer + kernel_data.film.pass_variance, sample, f*f);
+	}
+#endif
+}
+
 CCL_NAMESPACE_END
 
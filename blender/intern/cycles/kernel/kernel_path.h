@@ -44,6 +44,8 @@ CCL_NAMESPACE_BEGIN
 
 __device_inline bool shadow_blocked(KernelGlobals *kg, PathState *state, Ray *ray, float3 *shadow)
 {
+	STATS_SCOPED_TIMER(kg, STATS_PHASE_LIGHTING);
+
 	*shadow = make_float3(1.0f, 1.0f, 1.0f);
 
 	if(ray->t == 0.0f)
@@ -135,11 +137,13 @@ __device void kernel_path_indirect(KernelGlobals *kg, RNG *rng, int sample, Ray
 		/* intersect scene */
 		Intersection isect;
 		uint visibility = path_state_ray_visibility(kg, &state);
+		STATS_TIMER_BEGIN(kg, STATS_PHASE_INTERSECT);
 #ifdef __HAIR__
 		bool hit = scene_intersect(kg, &ray, visibility, &isect, NULL, 0.0f, 0.0f);
 #else
 		bool hit = scene_intersect(kg, &ray, visibility, &isect);
 #endif
+		STATS_TIMER_END(kg, STATS_PHASE_INTERSECT);
 
 #ifdef __LAMP_MIS__
 		if(kernel_data.integrator.use_lamp_mis && !(state.flag & PATH_RAY_CAMERA)) {
@@ -175,9 +179,11 @@ __device void kernel_path_indirect(KernelGlobals *kg, RNG *rng, int sample, Ray
 
 		/* setup shading */
 		ShaderData sd;
+		STATS_TIMER_BEGIN(kg, STATS_PHASE_SHADING);
 		shader_setup_from_ray(kg, &sd, &isect, &ray, state.bounce);
 		float rbsdf = path_rng_1D(kg, rng, sample, num_total_samples, rng_offset + PRNG_BSDF);
 		shader_eval_surface(kg, &sd, rbsdf, state.flag, SHADER_CONTEXT_INDIRECT);
+		STATS_TIMER_END(kg, STATS_PHASE_SHADING);
 #ifdef __BRANCHED_PATH__
 		shader_merge_closures(kg, &sd);
 #endif
@@ -497,10 +503,13 @@ __device float4 kernel_path_integrate(KernelGlobals *kg, RNG *rng, int sample, R
 			lcg_state = lcg_init(*rng + rng_offset + sample*0x51633e2d);
 		}
 
+		STATS_TIMER_BEGIN(kg, STATS_PHASE_INTERSECT);
 		bool hit = scene_intersect(kg, &ray, visibility, &isect, &lcg_state, difl, extmax);
 #else
+		STATS_TIMER_BEGIN(kg, STATS_PHASE_INTERSECT);
 		bool hit = scene_intersect(kg, &ray, visibility, &isect);
 #endif
+		STATS_TIMER_END(kg, STATS_PHASE_INTERSECT);
 
 #ifdef __LAMP_MIS__
 		if(kernel_data.integrator.use_lamp_mis && !(state.flag & PATH_RAY_CAMERA)) {
@@ -546,9 +555,11 @@ __device float4 kernel_path_integrate(KernelGlobals *kg, RNG *rng, int sample, R
 
 		/* setup shading */
 		ShaderData sd;
+		STATS_TIMER_BEGIN(kg, STATS_PHASE_SHADING);
 		shader_setup_from_ray(kg, &sd, &isect, &ray, state.bounce);
 		float rbsdf = path_rng_1D(kg, rng, sample, num_samples, rng_offset + PRNG_BSDF);
 		shader_eval_surface(kg, &sd, rbsdf, state.flag, SHADER_CONTEXT_MAIN);
+		STATS_TIMER_END(kg, STATS_PHASE_SHADING);
 
 		/* holdout */
 #ifdef __HOLDOUT__
@@ -981,10 +992,15 @@ __device float4 kernel_branched_path_integrate(KernelGlobals *kg, RNG *rng, int
 			lcg_state = lcg_init(*rng + rng_offset + sample*0x51633e2d);
 		}
 
-		if(!scene_intersect(kg, &ray, visibility, &isect, &lcg_state, difl, extmax)) {
+		STATS_TIMER_BEGIN(kg, STATS_PHASE_INTERSECT);
+		bool hit = scene_intersect(kg, &ray, visibility, &isect, &lcg_state, difl, extmax);
 #else
-		if(!scene_intersect(kg, &ray, visibility, &isect)) {
+		STATS_TIMER_BEGIN(kg, STATS_PHASE_INTERSECT);
+		bool hit = scene_intersect(kg, &ray, visibility, &isect);
 #endif
+		STATS_TIMER_END(kg, STATS_PHASE_INTERSECT);
+
+		if(!hit) {
 			/* eval background shader if nothing hit */
 			if(kernel_data.background.transparent) {
 				L_transparent += average(throughput);
@@ -1006,8 +1022,10 @@ __device float4 kernel_branched_path_integrate(KernelGlobals *kg, RNG *rng, int
 
 		/* setup shading */
 		ShaderData sd;
+		STATS_TIMER_BEGIN(kg, STATS_PHASE_SHADING);
 		shader_setup_from_ray(kg, &sd, &isect, &ray, state.bounce);
 		shader_eval_surface(kg, &sd, 0.0f, state.flag, SHADER_CONTEXT_MAIN);
+		STATS_TIMER_END(kg, STATS_PHASE_SHADING);
 		shader_merge_closures(kg, &sd);
 
 		/* holdout */
@@ -1199,6 +1217,9 @@ __device void kernel_path_trace(KernelGlobals *kg,
 	__global float *buffer, __global uint *rng_state,
 	int sample, int x, int y, int offset, int stride)
 {
+	STATS_SAMPLE(kg);
+	STATS_SCOPED_TIMER(kg, STATS_PHASE_TOTAL);
+
 	/* buffer offset */
 	int index = offset + x + y*stride;
 	int pass_stride = kernel_data.film.pass_stride;
@@ -1222,6 +1243,7 @@ __device void kernel_path_trace(KernelGlobals *kg,
 
 	/* accumulate result in output buffer */
 	kernel_write_pass_float4(buffer, sample, L);
+	kernel_write_variance_pass(kg, buffer, sample, L);
 
 	path_rng_end(kg, rng_state, rng);
 }
@@ -1231,6 +1253,9 @@ __device void kernel_branched_path_trace(KernelGlobals *kg,
 	__global float *buffer, __global uint *rng_state,
 	int sample, int x, int y, int offset, int stride)
 {
+	STATS_SAMPLE(kg);
+	STATS_SCOPED_TIMER(kg, STATS_PHASE_TOTAL);
+
 	/* buffer offset */
 	int index = offset + x + y*stride;
 	int pass_stride = kernel_data.film.pass_stride;
@@ -1254,6 +1279,7 @@ __device void kernel_branched_path_trace(KernelGlobals *kg,
 
 	/* accumulate result in output buffer */
 	kernel_write_pass_float4(buffer, sample, L);
+	kernel_write_variance_pass(kg, buffer, sample, L);
 
 	path_rng_end(kg, rng_state, rng);
 }
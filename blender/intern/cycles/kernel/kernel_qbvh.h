@@ -0,0 +1,181 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* QBVH
+ *
+ * Nodes with four children, stored as BVH_QNODE_SIZE float4's: the bounds of
+ * all children in struct-of-arrays layout (min.x, max.x, min.y, max.y, min.z,
+ * max.z), followed by the child indices and the child visibility flags. This
+ * way a single ray is tested against the four child boxes at once with SSE. */
+
+#define BVH_QNODE_SIZE 8
+
+/* 64 object BVH + 64 mesh BVH, with up to 3 entries pushed per node */
+#define BVH_QSTACK_SIZE 384
+
+/* ray data precomputed for node intersection, must be set up again whenever
+ * the ray is transformed into or out of object space */
+typedef struct QBVHRay {
+	float3 P;
+	float3 idir;
+	int near_x, near_y, near_z;
+	int far_x, far_y, far_z;
+#ifdef __KERNEL_SSE2__
+	__m128 Psplat[3];
+	__m128 idirsplat[3];
+#endif
+} QBVHRay;
+
+__device_inline void qbvh_ray_setup(QBVHRay *qray, float3 P, float3 idir)
+{
+	qray->P = P;
+	qray->idir = idir;
+
+	/* select the near and far plane of each slab from the ray direction */
+	qray->near_x = (idir.x >= 0.0f)? 0: 1;
+	qray->near_y = (idir.y >= 0.0f)? 2: 3;
+	qray->near_z = (idir.z >= 0.0f)? 4: 5;
+	qray->far_x = qray->near_x ^ 1;
+	qray->far_y = qray->near_y ^ 1;
+	qray->far_z = qray->near_z ^ 1;
+
+#ifdef __KERNEL_SSE2__
+	qray->Psplat[0] = _mm_set_ps1(P.x);
+	qray->Psplat[1] = _mm_set_ps1(P.y);
+	qray->Psplat[2] = _mm_set_ps1(P.z);
+
+	qray->idirsplat[0] = _mm_set_ps1(idir.x);
+	qray->idirsplat[1] = _mm_set_ps1(idir.y);
+	qray->idirsplat[2] = _mm_set_ps1(idir.z);
+#endif
+}
+
+/* Intersect ray with the four child boxes of a node. Returns a bitmask of
+ * the children to traverse, and the entry distance of each child in dist.
+ * With difl != 0.0f the boxes of children containing curves are enlarged
+ * for minimum width hair. */
+
+__device_inline int qbvh_node_intersect(KernelGlobals *kg, const QBVHRay *qray, int nodeAddr,
+	const float tmax, const uint visibility, const float difl, const float extmax, float dist[4])
+{
+#ifdef __KERNEL_SSE2__
+	const __m128 *node = (__m128*)kg->__bvh_nodes.data + nodeAddr*BVH_QNODE_SIZE;
+
+	const __m128 tnear_x = _mm_mul_ps(_mm_sub_ps(node[qray->near_x], qray->Psplat[0]), qray->idirsplat[0]);
+	const __m128 tnear_y = _mm_mul_ps(_mm_sub_ps(node[qray->near_y], qray->Psplat[1]), qray->idirsplat[1]);
+	const __m128 tnear_z = _mm_mul_ps(_mm_sub_ps(node[qray->near_z], qray->Psplat[2]), qray->idirsplat[2]);
+	const __m128 tfar_x = _mm_mul_ps(_mm_sub_ps(node[qray->far_x], qray->Psplat[0]), qray->idirsplat[0]);
+	const __m128 tfar_y = _mm_mul_ps(_mm_sub_ps(node[qray->far_y], qray->Psplat[1]), qray->idirsplat[1]);
+	const __m128 tfar_z = _mm_mul_ps(_mm_sub_ps(node[qray->far_z], qray->Psplat[2]), qray->idirsplat[2]);
+
+	__m128 tnear = _mm_max_ps(_mm_max_ps(tnear_x, tnear_y), _mm_max_ps(tnear_z, _mm_setzero_ps()));
+	__m128 tfar = _mm_min_ps(_mm_min_ps(tfar_x, tfar_y), _mm_min_ps(tfar_z, _mm_set_ps1(tmax)));
+
+	const __m128i cvisibility = _mm_castps_si128(node[7]);
+
+	if(difl != 0.0f) {
+		/* enlarge boxes of children containing curves */
+		const __m128i curve = _mm_and_si128(cvisibility, _mm_set1_epi32(PATH_RAY_CURVE));
+		const __m128 curve_mask = _mm_castsi128_ps(_mm_xor_si128(_mm_cmpeq_epi32(curve, _mm_setzero_si128()), _mm_set1_epi32(-1)));
+
+		const __m128 tnear_curve = _mm_max_ps(_mm_mul_ps(_mm_set_ps1(1.0f - difl), tnear), _mm_sub_ps(tnear, _mm_set_ps1(extmax)));
+		const __m128 tfar_curve = _mm_min_ps(_mm_mul_ps(_mm_set_ps1(1.0f + difl), tfar), _mm_add_ps(tfar, _mm_set_ps1(extmax)));
+
+		tnear = _mm_or_ps(_mm_and_ps(curve_mask, tnear_curve), _mm_andnot_ps(curve_mask, tnear));
+		tfar = _mm_or_ps(_mm_and_ps(curve_mask, tfar_curve), _mm_andnot_ps(curve_mask, tfar));
+	}
+
+	int mask = _mm_movemask_ps(_mm_cmple_ps(tnear, tfar));
+
+#ifdef __VISIBILITY_FLAG__
+	const __m128i cvisible = _mm_and_si128(cvisibility, _mm_set1_epi32(visibility));
+	mask &= ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(cvisible, _mm_setzero_si128())));
+#endif
+
+	_mm_storeu_ps(dist, tnear);
+
+	return mask;
+#else
+	/* non-SSE version, same math one child at a time */
+	const float3 P = qray->P;
+	const float3 idir = qray->idir;
+
+	float4 near_x = kernel_tex_fetch(__bvh_nodes, nodeAddr*BVH_QNODE_SIZE+qray->near_x);
+	float4 far_x = kernel_tex_fetch(__bvh_nodes, nodeAddr*BVH_QNODE_SIZE+qray->far_x);
+	float4 near_y = kernel_tex_fetch(__bvh_nodes, nodeAddr*BVH_QNODE_SIZE+qray->near_y);
+	float4 far_y = kernel_tex_fetch(__bvh_nodes, nodeAddr*BVH_QNODE_SIZE+qray->far_y);
+	float4 near_z = kernel_tex_fetch(__bvh_nodes, nodeAddr*BVH_QNODE_SIZE+qray->near_z);
+	float4 far_z = kernel_tex_fetch(__bvh_nodes, nodeAddr*BVH_QNODE_SIZE+qray->far_z);
+	float4 cvisibility = kernel_tex_fetch(__bvh_nodes, nodeAddr*BVH_QNODE_SIZE+7);
+
+	int mask = 0;
+
+	for(int i = 0; i < 4; i++) {
+		NO_EXTENDED_PRECISION float tnear = max4((near_x[i] - P.x) * idir.x, (near_y[i] - P.y) * idir.y, (near_z[i] - P.z) * idir.z, 0.0f);
+		NO_EXTENDED_PRECISION float tfar = min4((far_x[i] - P.x) * idir.x, (far_y[i] - P.y) * idir.y, (far_z[i] - P.z) * idir.z, tmax);
+		uint cvis = __float_as_uint(cvisibility[i]);
+
+		if(difl != 0.0f && (cvis & PATH_RAY_CURVE)) {
+			tnear = max((1.0f - difl) * tnear, tnear - extmax);
+			tfar = min((1.0f + difl) * tfar, tfar + extmax);
+		}
+
+#ifdef __VISIBILITY_FLAG__
+		if(tnear <= tfar && (cvis & visibility))
+#else
+		if(tnear <= tfar)
+#endif
+			mask |= (1 << i);
+
+		dist[i] = tnear;
+	}
+
+	return mask;
+#endif
+}
+
+/* Sort the intersected children front to back, push all but the nearest one
+ * on the stack so the nearer ones are popped first, and return the nearest
+ * one to continue traversal with. */
+
+__device_inline int qbvh_push_children(const float4 cnodes, int child_mask, const float dist[4], int *traversalStack, int *stackPtr)
+{
+	int child[4];
+	float child_dist[4];
+	int num_children = 0;
+
+	for(int i = 0; i < 4; i++) {
+		if(child_mask & (1 << i)) {
+			/* insertion sort, at most four entries */
+			int j = num_children++;
+
+			for(; j > 0 && child_dist[j-1] > dist[i]; j--) {
+				child[j] = child[j-1];
+				child_dist[j] = child_dist[j-1];
+			}
+
+			child[j] = __float_as_int(cnodes[i]);
+			child_dist[j] = dist[i];
+		}
+	}
+
+	for(int i = num_children - 1; i > 0; i--) {
+		++(*stackPtr);
+		traversalStack[*stackPtr] = child[i];
+	}
+
+	return child[0];
+}
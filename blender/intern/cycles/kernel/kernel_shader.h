@@ -819,6 +819,8 @@ __device float3 shader_holdout_eval(KernelGlobals *kg, ShaderData *sd)
 __device void shader_eval_surface(KernelGlobals *kg, ShaderData *sd,
 	float randb, int path_flag, ShaderContext ctx)
 {
+	STATS_SHADER_EVAL(kg, STATS_SHADER_SURFACE);
+
 #ifdef __OSL__
 	if (kg->osl)
 		OSLShader::eval_surface(kg, sd, randb, path_flag, ctx);
@@ -839,6 +841,8 @@ __device void shader_eval_surface(KernelGlobals *kg, ShaderData *sd,
 
 __device float3 shader_eval_background(KernelGlobals *kg, ShaderData *sd, int path_flag, ShaderContext ctx)
 {
+	STATS_SHADER_EVAL(kg, STATS_SHADER_BACKGROUND);
+
 #ifdef __OSL__
 	if (kg->osl)
 		return OSLShader::eval_background(kg, sd, path_flag, ctx);
@@ -913,6 +917,8 @@ __device void shader_eval_volume(KernelGlobals *kg, ShaderData *sd,
 
 __device void shader_eval_displacement(KernelGlobals *kg, ShaderData *sd, ShaderContext ctx)
 {
+	STATS_SHADER_EVAL(kg, STATS_SHADER_DISPLACEMENT);
+
 	/* this will modify sd->P */
 #ifdef __SVM__
 #ifdef __OSL__
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#ifndef __KERNEL_STATS_H__
+#define __KERNEL_STATS_H__
+
+/* Render Statistics
+ *
+ * Counters and phase timers for KernelStats, these compile to nothing unless
+ * __KERNEL_STATS__ is defined. Counters are only written by the thread owning
+ * the KernelGlobals, so no atomics are needed. */
+
+#ifdef __KERNEL_STATS__
+
+#include "util_time.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* timer adding the time until the end of the scope to a phase */
+class KernelStatsScopedTimer {
+public:
+	KernelStatsScopedTimer(KernelGlobals *kg_, StatsPhase phase_)
+	: kg(kg_), phase(phase_), start(time_dt())
+	{
+	}
+
+	~KernelStatsScopedTimer()
+	{
+		kg->stats.phase_time[phase] += time_dt() - start;
+	}
+
+protected:
+	KernelGlobals *kg;
+	StatsPhase phase;
+	double start;
+};
+
+__device_inline StatsRayType kernel_stats_ray_type(uint visibility)
+{
+	if(visibility & PATH_RAY_CAMERA)
+		return STATS_RAY_CAMERA;
+	else if(visibility & PATH_RAY_SHADOW)
+		return STATS_RAY_SHADOW;
+	else
+		return STATS_RAY_BOUNCE;
+}
+
+CCL_NAMESPACE_END
+
+#define STATS_SAMPLE(kg) (kg)->stats.samples++
+#define STATS_RAY(kg, type) (kg)->stats.rays[type]++
+#define STATS_RAY_VISIBILITY(kg, visibility) (kg)->stats.rays[kernel_stats_ray_type(visibility)]++
+#define STATS_BVH_NODE(kg) (kg)->stats.bvh_nodes++
+#define STATS_SHADER_EVAL(kg, type) (kg)->stats.shader_evals[type]++
+
+#define STATS_TIMER_BEGIN(kg, phase) double stats_time_##phase = time_dt()
+#define STATS_TIMER_END(kg, phase) (kg)->stats.phase_time[phase] += time_dt() - stats_time_##phase
+#define STATS_SCOPED_TIMER(kg, phase) KernelStatsScopedTimer stats_timer_##phase(kg, phase)
+
+#else
+
+#define STATS_SAMPLE(kg)
+#define STATS_RAY(kg, type)
+#define STATS_RAY_VISIBILITY(kg, visibility)
+#define STATS_BVH_NODE(kg)
+#define STATS_SHADER_EVAL(kg, type)
+
+#define STATS_TIMER_BEGIN(kg, phase)
+#define STATS_TIMER_END(kg, phase)
+#define STATS_SCOPED_TIMER(kg, phase)
+
+#endif
+
+#endif /* __KERNEL_STATS_H__ */
+
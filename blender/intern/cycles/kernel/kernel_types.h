@@ -30,6 +30,7 @@ CCL_NAMESPACE_BEGIN
 #define OBJECT_SIZE 		11
 #define OBJECT_VECTOR_SIZE	6
 #define LIGHT_SIZE			4
+#define LIGHT_TREE_NODE_SIZE	4
 #define FILTER_TABLE_SIZE	256
 #define RAMP_TABLE_SIZE		256
 #define PARTICLE_SIZE 		5
@@ -56,6 +57,7 @@ CCL_NAMESPACE_BEGIN
 #endif
 #define __SUBSURFACE__
 #define __CMJ__
+#define __QBVH__
 #endif
 
 #ifdef __KERNEL_CUDA__
@@ -143,6 +145,11 @@ CCL_NAMESPACE_BEGIN
 #define __HAIR__
 #endif
 
+/* render statistics, only counted by the CPU kernel */
+#if defined(__KERNEL_CPU__) && defined(WITH_CYCLES_STATS)
+#define __KERNEL_STATS__
+#endif
+
 /* Sanity check */
 
 #if defined(__KERNEL_OPENCL_NEED_ADVANCED_SHADING__) && !defined(__MULTI_CLOSURE__)
@@ -268,7 +275,8 @@ typedef enum PassType {
 	PASS_MIST = 2097152,
 	PASS_SUBSURFACE_DIRECT = 4194304,
 	PASS_SUBSURFACE_INDIRECT = 8388608,
-	PASS_SUBSURFACE_COLOR = 16777216
+	PASS_SUBSURFACE_COLOR = 16777216,
+	PASS_VARIANCE = 33554432
 } PassType;
 
 #define PASS_ALL (~0)
@@ -693,7 +701,7 @@ typedef struct KernelFilm {
 	int pass_emission;
 	int pass_background;
 	int pass_ao;
-	int pass_pad1;
+	int pass_variance;
 
 	int pass_shadow;
 	float pass_shadow_scale;
@@ -769,6 +777,12 @@ typedef struct KernelIntegrator {
 	/* sampler */
 	int sampling_pattern;
 
+	/* light tree */
+	int light_tree_triangle_root;
+	int light_tree_lamp_root;
+	int light_tree_num_triangles;
+	int light_tree_num_lamps;
+
 	/* padding */
 	int pad;
 } KernelIntegrator;
@@ -780,8 +794,9 @@ typedef struct KernelBVH {
 	int have_motion;
 	int have_curves;
 	int have_instancing;
+	int use_qbvh;
 
-	int pad1, pad2, pad3;
+	int pad1, pad2;
 } KernelBVH;
 
 typedef enum CurveFlag {
@@ -826,6 +841,45 @@ typedef struct KernelData {
 	KernelBlackbody blackbody;
 } KernelData;
 
+/* Render Statistics
+ *
+ * Counted per thread in KernelGlobals when built with WITH_CYCLES_STATS, and
+ * summed by the device. Phase times are in seconds and do not overlap, the
+ * total is the time of whole samples, so the remainder is spent elsewhere. */
+
+typedef enum StatsRayType {
+	STATS_RAY_CAMERA = 0,
+	STATS_RAY_SHADOW,
+	STATS_RAY_BOUNCE,
+	STATS_RAY_SUBSURFACE,
+	STATS_RAY_NUM
+} StatsRayType;
+
+typedef enum StatsShaderType {
+	STATS_SHADER_SURFACE = 0,
+	STATS_SHADER_BACKGROUND,
+	STATS_SHADER_DISPLACEMENT,
+	STATS_SHADER_NUM
+} StatsShaderType;
+
+typedef enum StatsPhase {
+	STATS_PHASE_INTERSECT = 0,	/* camera and bounce rays */
+	STATS_PHASE_SHADING,		/* shader setup and evaluation at path hits */
+	STATS_PHASE_LIGHTING,		/* light sampling and shadow rays */
+	STATS_PHASE_TOTAL,
+	STATS_PHASE_NUM
+} StatsPhase;
+
+#ifdef __KERNEL_CPU__
+typedef struct KernelStats {
+	uint64_t samples;
+	uint64_t rays[STATS_RAY_NUM];
+	uint64_t bvh_nodes;
+	uint64_t shader_evals[STATS_SHADER_NUM];
+	double phase_time[STATS_PHASE_NUM];
+} KernelStats;
+#endif
+
 CCL_NAMESPACE_END
 
 #endif /*  __KERNEL_TYPES_H__ */
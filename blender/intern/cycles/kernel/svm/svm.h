@@ -140,6 +140,8 @@ CCL_NAMESPACE_END
 /* Nodes */
 
 #include "svm_noise.h"
+#include "svm_math_util.h"
+#include "svm_color_util.h"
 #include "svm_texture.h"
 
 #include "svm_attribute.h"
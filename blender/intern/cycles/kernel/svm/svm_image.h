@@ -115,7 +115,10 @@ __device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, u
 	float4 r;
 
 #ifdef __KERNEL_CPU__
-	r = kernel_tex_image_interp(id, x, y);
+	if(kg->texture_cache && kg->texture_cache->has_image(id))
+		r = kg->texture_cache->lookup(id, x, y);
+	else
+		r = kernel_tex_image_interp(id, x, y);
 #else
 	/* not particularly proud of this massive switch, what are the
 	 * alternatives?
@@ -85,6 +85,7 @@ RenderTile::RenderTile()
 	start_sample = 0;
 	num_samples = 0;
 	resolution = 0;
+	tile_index = 0;
 
 	offset = 0;
 	stride = 0;
@@ -146,13 +147,27 @@ void RenderBuffers::reset(Device *device, BufferParams& params_)
 	device->mem_copy_to(rng_state);
 }
 
-bool RenderBuffers::copy_from_device()
+bool RenderBuffers::copy_from_device(bool with_rng_state)
 {
 	if(!buffer.device_pointer)
 		return false;
 
 	device->mem_copy_from(buffer, 0, params.width, params.height, params.get_passes_size()*sizeof(float));
 
+	if(with_rng_state)
+		device->mem_copy_from(rng_state, 0, params.width, params.height, sizeof(uint));
+
+	return true;
+}
+
+bool RenderBuffers::copy_to_device()
+{
+	if(!buffer.device_pointer)
+		return false;
+
+	device->mem_copy_to(buffer);
+	device->mem_copy_to(rng_state);
+
 	return true;
 }
 
@@ -301,6 +316,61 @@ bool RenderBuffers::get_pass_rect(PassType type, float exposure, int sample, int
 	return false;
 }
 
+bool RenderBuffers::get_sample_error(int sample, float *error)
+{
+	int pass_offset = 0, combined_offset = -1, variance_offset = -1;
+
+	foreach(Pass& pass, params.passes) {
+		if(pass.type == PASS_COMBINED)
+			combined_offset = pass_offset;
+		else if(pass.type == PASS_VARIANCE)
+			variance_offset = pass_offset;
+
+		pass_offset += pass.components;
+	}
+
+	if(combined_offset == -1 || variance_offset == -1 || sample < 2)
+		return false;
+
+	float *in_combined = (float*)buffer.data_pointer + combined_offset;
+	float *in_variance = (float*)buffer.data_pointer + variance_offset;
+	int pass_stride = params.get_passes_size();
+	float inv_sample = 1.0f/(float)sample;
+	float max_error = 0.0f;
+
+	/* average the error over small blocks and use the noisiest block, so a
+	 * small noisy region in an otherwise clean tile keeps the tile sampling */
+	for(int block_y = 0; block_y < params.height; block_y += ERROR_BLOCK_SIZE) {
+		for(int block_x = 0; block_x < params.width; block_x += ERROR_BLOCK_SIZE) {
+			int w = min(ERROR_BLOCK_SIZE, params.width - block_x);
+			int h = min(ERROR_BLOCK_SIZE, params.height - block_y);
+			double sum = 0.0;
+
+			for(int y = block_y; y < block_y + h; y++) {
+				int index = (y*params.width + block_x)*pass_stride;
+				float *combined = in_combined + index;
+				float *variance = in_variance + index;
+
+				for(int x = 0; x < w; x++, combined += pass_stride, variance += pass_stride) {
+					float mean = (combined[0] + combined[1] + combined[2])*(1.0f/3.0f)*inv_sample;
+					float var = max(variance[0]*inv_sample - mean*mean, 0.0f);
+
+					/* standard error of the mean, relative to the square root of the
+					 * intensity so noise in dark regions is weighted perceptually */
+					float std_error = sqrtf(var*inv_sample);
+					sum += std_error/max(sqrtf(fabsf(mean)), 1e-3f);
+				}
+			}
+
+			max_error = max(max_error, (float)(sum/(w*h)));
+		}
+	}
+
+	*error = max_error;
+
+	return true;
+}
+
 /* Display Buffer */
 
 DisplayBuffer::DisplayBuffer(Device *device_, bool linear)
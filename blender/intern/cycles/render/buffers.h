@@ -32,6 +32,9 @@ CCL_NAMESPACE_BEGIN
 class Device;
 struct float4;
 
+/* size in pixels of the blocks used for estimating the error of a tile */
+#define ERROR_BLOCK_SIZE 8
+
 /* Buffer Parameters
  * Size of render buffer and how it fits in the full image (border render). */
 
@@ -76,9 +79,15 @@ public:
 
 	void reset(Device *device, BufferParams& params);
 
-	bool copy_from_device();
+	bool copy_from_device(bool with_rng_state = false);
+	bool copy_to_device();
 	bool get_pass_rect(PassType type, float exposure, int sample, int components, float *pixels);
 
+	/* relative error of the combined pass estimated from the variance pass,
+	 * the maximum of the average error of blocks of ERROR_BLOCK_SIZE pixels,
+	 * returns false if there is no variance pass */
+	bool get_sample_error(int sample, float *error);
+
 protected:
 	void device_free();
 
@@ -134,6 +143,7 @@ public:
 	int num_samples;
 	int sample;
 	int resolution;
+	int tile_index;
 	int offset;
 	int stride;
 
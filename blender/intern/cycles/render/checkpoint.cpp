@@ -0,0 +1,364 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#include <string.h>
+
+#include "buffers.h"
+#include "checkpoint.h"
+
+#include "util_foreach.h"
+#include "util_path.h"
+#include "util_time.h"
+
+#include <boost/filesystem.hpp>
+
+CCL_NAMESPACE_BEGIN
+
+#define CHECKPOINT_MAGIC "CYCCKPT"
+#define CHECKPOINT_VERSION 1
+
+/* 64 bit file offsets, checkpoints of large images easily exceed 2GB */
+
+static bool file_seek(FILE *f, int64_t offset, int whence)
+{
+#ifdef _WIN32
+	return _fseeki64(f, offset, whence) == 0;
+#else
+	return fseeko(f, (off_t)offset, whence) == 0;
+#endif
+}
+
+static int64_t file_tell(FILE *f)
+{
+#ifdef _WIN32
+	return _ftelli64(f);
+#else
+	return (int64_t)ftello(f);
+#endif
+}
+
+RenderCheckpoint::RenderCheckpoint(const string& filepath_, double interval_)
+: filepath(filepath_), interval(interval_)
+{
+	memset(&header, 0, sizeof(header));
+	file = NULL;
+}
+
+RenderCheckpoint::~RenderCheckpoint()
+{
+	close(false);
+}
+
+bool RenderCheckpoint::open(BufferParams& params, int num_tiles)
+{
+	thread_scoped_lock lock(mutex);
+
+	if(file) {
+		fclose(file);
+		file = NULL;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+	header.version = CHECKPOINT_VERSION;
+	header.width = params.width;
+	header.height = params.height;
+	header.full_x = params.full_x;
+	header.full_y = params.full_y;
+	header.full_width = params.full_width;
+	header.full_height = params.full_height;
+	header.pass_stride = params.get_passes_size();
+	header.num_tiles = num_tiles;
+
+	TileInfo empty;
+	memset(&empty, 0, sizeof(empty));
+	empty.offset = -1;
+
+	tiles.clear();
+	tiles.resize(num_tiles, empty);
+
+	/* read tiles from existing checkpoint of the same image */
+	bool resume = false;
+
+	if(path_exists(filepath)) {
+		FILE *f = fopen(filepath.c_str(), "rb");
+
+		if(f) {
+			Header file_header;
+
+			if(fread(&file_header, sizeof(file_header), 1, f) == 1 &&
+			   memcmp(&file_header, &header, sizeof(header)) == 0)
+			{
+				resume = read_records(f, header);
+			}
+
+			fclose(f);
+		}
+	}
+
+	if(resume) {
+		/* rewrite with only the last record of each tile, so the file does not
+		 * keep growing with every resume */
+		if(compact())
+			return true;
+
+		tiles.clear();
+		tiles.resize(num_tiles, empty);
+	}
+
+	/* start new checkpoint */
+	path_create_directories(filepath);
+	file = fopen(filepath.c_str(), "wb");
+
+	if(!file) {
+		fprintf(stderr, "Failed to open checkpoint file %s for writing.\n", filepath.c_str());
+		return false;
+	}
+
+	if(fwrite(&header, sizeof(header), 1, file) != 1) {
+		fprintf(stderr, "Failed to write checkpoint file %s.\n", filepath.c_str());
+		fclose(file);
+		file = NULL;
+		return false;
+	}
+
+	fflush(file);
+
+	return true;
+}
+
+void RenderCheckpoint::close(bool finished)
+{
+	thread_scoped_lock lock(mutex);
+
+	if(file) {
+		fclose(file);
+		file = NULL;
+
+		if(finished)
+			boost::filesystem::remove(filepath);
+	}
+
+	tiles.clear();
+}
+
+bool RenderCheckpoint::read_records(FILE *f, const Header& header)
+{
+	if(!file_seek(f, 0, SEEK_END))
+		return false;
+
+	int64_t file_size = file_tell(f);
+	int64_t offset = sizeof(Header);
+	bool found = false;
+
+	if(!file_seek(f, offset, SEEK_SET))
+		return false;
+
+	Record record;
+
+	while(fread(&record, sizeof(record), 1, f) == 1) {
+		if(record.index < 0 || record.index >= header.num_tiles)
+			break;
+		if(record.w <= 0 || record.h <= 0 || record.sample <= 0)
+			break;
+
+		int64_t num_pixels = (int64_t)record.w*(int64_t)record.h;
+		int64_t size = num_pixels*(header.pass_stride*sizeof(float) + sizeof(uint));
+
+		offset += sizeof(record);
+
+		/* incomplete record at the end */
+		if(offset + size > file_size)
+			break;
+
+		TileInfo& info = tiles[record.index];
+		info.record = record;
+		info.offset = offset;
+		found = true;
+
+		offset += size;
+
+		if(!file_seek(f, offset, SEEK_SET))
+			break;
+	}
+
+	return found;
+}
+
+bool RenderCheckpoint::compact()
+{
+	string tmp_filepath = filepath + ".tmp";
+	FILE *src = fopen(filepath.c_str(), "rb");
+	FILE *dst = fopen(tmp_filepath.c_str(), "wb");
+
+	bool ok = (src && dst);
+
+	ok = ok && (fwrite(&header, sizeof(header), 1, dst) == 1);
+
+	vector<float> buffer;
+	vector<uint> rng_state;
+
+	foreach(TileInfo& info, tiles) {
+		if(!ok)
+			break;
+		if(info.offset == -1)
+			continue;
+
+		size_t num_pixels = (size_t)info.record.w*(size_t)info.record.h;
+		buffer.resize(num_pixels*header.pass_stride);
+		rng_state.resize(num_pixels);
+
+		ok = ok && file_seek(src, info.offset, SEEK_SET);
+		ok = ok && (fread(&buffer[0], sizeof(float), buffer.size(), src) == buffer.size());
+		ok = ok && (fread(&rng_state[0], sizeof(uint), rng_state.size(), src) == rng_state.size());
+		ok = ok && write_record(dst, info.record, &buffer[0], &rng_state[0], &info.offset);
+	}
+
+	if(src)
+		fclose(src);
+	if(dst)
+		fclose(dst);
+
+	if(ok) {
+		boost::filesystem::remove(filepath);
+		boost::filesystem::rename(tmp_filepath, filepath);
+
+		file = fopen(filepath.c_str(), "ab");
+		ok = (file != NULL);
+	}
+	else
+		boost::filesystem::remove(tmp_filepath);
+
+	if(!ok)
+		fprintf(stderr, "Failed to resume from checkpoint file %s.\n", filepath.c_str());
+
+	return ok;
+}
+
+bool RenderCheckpoint::write_record(FILE *f, const Record& record, const float *buffer, const uint *rng_state, int64_t *offset)
+{
+	size_t num_pixels = (size_t)record.w*(size_t)record.h;
+	size_t buffer_size = num_pixels*header.pass_stride;
+
+	bool ok = file_seek(f, 0, SEEK_END);
+
+	ok = ok && (fwrite(&record, sizeof(record), 1, f) == 1);
+
+	*offset = file_tell(f);
+
+	ok = ok && (fwrite(buffer, sizeof(float), buffer_size, f) == buffer_size);
+	ok = ok && (fwrite(rng_state, sizeof(uint), num_pixels, f) == num_pixels);
+
+	return ok;
+}
+
+int RenderCheckpoint::tile_sample(int index, int x, int y, int w, int h)
+{
+	thread_scoped_lock lock(mutex);
+
+	if(index < 0 || index >= (int)tiles.size())
+		return 0;
+
+	/* tiles are matched by index, dimensions must match too */
+	Record& record = tiles[index].record;
+
+	if(tiles[index].offset == -1 || record.x != x || record.y != y || record.w != w || record.h != h)
+		return 0;
+
+	return record.sample;
+}
+
+bool RenderCheckpoint::read_tile(int index, RenderBuffers *buffers)
+{
+	thread_scoped_lock lock(mutex);
+
+	if(index < 0 || index >= (int)tiles.size() || tiles[index].offset == -1)
+		return false;
+
+	TileInfo& info = tiles[index];
+	BufferParams& params = buffers->params;
+
+	if(params.width != info.record.w || params.height != info.record.h || params.get_passes_size() != header.pass_stride)
+		return false;
+
+	/* make sure appended records are on disk before reading them back */
+	if(file)
+		fflush(file);
+
+	FILE *f = fopen(filepath.c_str(), "rb");
+
+	if(!f)
+		return false;
+
+	size_t num_pixels = (size_t)info.record.w*(size_t)info.record.h;
+	size_t buffer_size = num_pixels*header.pass_stride;
+
+	bool ok = file_seek(f, info.offset, SEEK_SET);
+	ok = ok && (fread((float*)buffers->buffer.data_pointer, sizeof(float), buffer_size, f) == buffer_size);
+	ok = ok && (fread((uint*)buffers->rng_state.data_pointer, sizeof(uint), num_pixels, f) == num_pixels);
+
+	fclose(f);
+
+	if(!ok) {
+		fprintf(stderr, "Failed to read tile from checkpoint file %s.\n", filepath.c_str());
+		return false;
+	}
+
+	return buffers->copy_to_device();
+}
+
+void RenderCheckpoint::write_tile(int index, int x, int y, int sample, RenderBuffers *buffers, bool finished)
+{
+	thread_scoped_lock lock(mutex);
+
+	if(!file || index < 0 || index >= (int)tiles.size())
+		return;
+
+	TileInfo& info = tiles[index];
+	double current_time = time_dt();
+
+	if(sample <= 0 || (info.offset != -1 && sample <= info.record.sample))
+		return;
+	if(!finished && current_time - info.write_time < interval)
+		return;
+
+	if(!buffers->copy_from_device(true))
+		return;
+
+	Record record;
+	record.index = index;
+	record.x = x;
+	record.y = y;
+	record.w = buffers->params.width;
+	record.h = buffers->params.height;
+	record.sample = sample;
+
+	int64_t offset;
+
+	if(!write_record(file, record, (float*)buffers->buffer.data_pointer, (uint*)buffers->rng_state.data_pointer, &offset)) {
+		fprintf(stderr, "Failed to write checkpoint file %s.\n", filepath.c_str());
+		return;
+	}
+
+	fflush(file);
+
+	info.record = record;
+	info.offset = offset;
+	info.write_time = current_time;
+}
+
+CCL_NAMESPACE_END
+
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <stdio.h>
+
+#include "util_string.h"
+#include "util_thread.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class BufferParams;
+class RenderBuffers;
+
+/* Render Checkpoint
+ *
+ * File with the render buffers of tiles rendered in background mode. Finished
+ * tiles are appended as soon as they are done, partially rendered tiles at
+ * most once per interval. When a render is started and a checkpoint file for
+ * the same image exists, finished tiles are taken from it and partially
+ * rendered tiles continue from the last written sample.
+ *
+ * The last record of each tile is the valid one. A record that was not written
+ * completely, because the process was killed while writing it, is ignored. */
+
+class RenderCheckpoint {
+public:
+	RenderCheckpoint(const string& filepath, double interval);
+	~RenderCheckpoint();
+
+	/* open for rendering an image with the given buffer parameters, reading
+	 * tiles from an existing file if it matches */
+	bool open(BufferParams& params, int num_tiles);
+	/* close file, and remove it if the render finished */
+	void close(bool finished);
+
+	bool is_open() { return file != NULL; }
+
+	/* samples of tile stored in the checkpoint, 0 if there are none */
+	int tile_sample(int index, int x, int y, int w, int h);
+	/* read render buffers of tile, and copy them to the device */
+	bool read_tile(int index, RenderBuffers *buffers);
+	/* write render buffers of tile, partial tiles are skipped if written
+	 * less than interval seconds ago or without new samples */
+	void write_tile(int index, int x, int y, int sample, RenderBuffers *buffers, bool finished);
+
+protected:
+	struct Header {
+		char magic[8];
+		int version;
+		int width, height;
+		int full_x, full_y;
+		int full_width, full_height;
+		int pass_stride;
+		int num_tiles;
+	};
+
+	struct Record {
+		int index;
+		int x, y, w, h;
+		int sample;
+	};
+
+	struct TileInfo {
+		Record record;
+		int64_t offset;
+		double write_time;
+	};
+
+	bool read_records(FILE *f, const Header& header);
+	bool compact();
+	bool write_record(FILE *f, const Record& record, const float *buffer, const uint *rng_state, int64_t *offset);
+
+	string filepath;
+	double interval;
+
+	Header header;
+	vector<TileInfo> tiles;
+
+	FILE *file;
+	thread_mutex mutex;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __CHECKPOINT_H__ */
+
@@ -155,6 +155,9 @@ void Pass::add(PassType type, vector<Pass>& passes)
 			pass.components = 4;
 			pass.exposure = false;
 			break;
+		case PASS_VARIANCE:
+			pass.components = 1;
+			break;
 	}
 
 	passes.push_back(pass);
@@ -387,6 +390,9 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 				kfilm->pass_ao = kfilm->pass_stride;
 				kfilm->use_light_pass = 1;
 				break;
+			case PASS_VARIANCE:
+				kfilm->pass_variance = kfilm->pass_stride;
+				break;
 			case PASS_SHADOW:
 				kfilm->pass_shadow = kfilm->pass_stride;
 				kfilm->use_light_pass = 1;
@@ -161,7 +161,7 @@ ShaderGraph *ShaderGraph::copy()
 	ShaderGraph *newgraph = new ShaderGraph();
 
 	/* copy nodes */
-	set<ShaderNode*> nodes_all;
+	ShaderNodeSet nodes_all;
 	foreach(ShaderNode *node, nodes)
 		nodes_all.insert(node);
 
@@ -228,7 +228,7 @@ void ShaderGraph::finalize(bool do_bump, bool do_osl, bool do_multi_transform)
 	 * modified afterwards. */
 
 	if(!finalized) {
-		clean();
+		clean(do_osl);
 		default_inputs(do_osl);
 		refine_bump_nodes();
 
@@ -251,7 +251,7 @@ void ShaderGraph::finalize(bool do_bump, bool do_osl, bool do_multi_transform)
 	}
 }
 
-void ShaderGraph::find_dependencies(set<ShaderNode*>& dependencies, ShaderInput *input)
+void ShaderGraph::find_dependencies(ShaderNodeSet& dependencies, ShaderInput *input)
 {
 	/* find all nodes that this input depends on directly and indirectly */
 	ShaderNode *node = (input->link)? input->link->parent: NULL;
@@ -264,7 +264,7 @@ void ShaderGraph::find_dependencies(set<ShaderNode*>& dependencies, ShaderInput
 	}
 }
 
-void ShaderGraph::copy_nodes(set<ShaderNode*>& nodes, map<ShaderNode*, ShaderNode*>& nnodemap)
+void ShaderGraph::copy_nodes(ShaderNodeSet& nodes, map<ShaderNode*, ShaderNode*>& nnodemap)
 {
 	/* copy a set of nodes, and the links between them. the assumption is
 	 * made that all nodes that inputs are linked to are in the set too. */
@@ -388,33 +388,21 @@ void ShaderGraph::remove_unneeded_nodes()
 				}
 			}
 		
-			/* remove unused mix closure input when factor is 0.0 or 1.0 */
-			/* check for closure links and make sure factor link is disconnected */
-			if(mix->outputs[0]->links.size() && mix->inputs[1]->link && mix->inputs[2]->link && !mix->inputs[0]->link) {
-				/* factor 0.0 */
-				if(mix->inputs[0]->value.x == 0.0f) {
-					ShaderOutput *output = mix->inputs[1]->link;
+			/* remove unused mix closure input when factor is 0.0 or 1.0, the
+			 * factor is clamped so values outside the range work the same.
+			 * make sure factor link is disconnected */
+			if(mix->outputs[0]->links.size() && !mix->inputs[0]->link) {
+				float fac = mix->inputs[0]->value.x;
+
+				if(fac <= 0.0f || fac >= 1.0f) {
+					ShaderOutput *output = mix->inputs[(fac <= 0.0f)? 1: 2]->link;
 					vector<ShaderInput*> inputs = mix->outputs[0]->links;
-					
-					foreach(ShaderInput *sock, mix->inputs)
-						if(sock->link)
-							disconnect(sock);
 
-					foreach(ShaderInput *input, inputs) {
-						disconnect(input);
-						if(output)
-							connect(output, input);
-					}
-				}
-				/* factor 1.0 */
-				else if(mix->inputs[0]->value.x == 1.0f) {
-					ShaderOutput *output = mix->inputs[2]->link;
-					vector<ShaderInput*> inputs = mix->outputs[0]->links;
-					
 					foreach(ShaderInput *sock, mix->inputs)
 						if(sock->link)
 							disconnect(sock);
 
+					/* an unlinked closure input means no closure */
 					foreach(ShaderInput *input, inputs) {
 						disconnect(input);
 						if(output)
@@ -464,7 +452,122 @@ void ShaderGraph::break_cycles(ShaderNode *node, vector<bool>& visited, vector<b
 	on_stack[node->id] = false;
 }
 
-void ShaderGraph::clean()
+void ShaderGraph::constant_fold(vector<bool>& done, ShaderNode *node)
+{
+	if(done[node->id])
+		return;
+
+	done[node->id] = true;
+
+	/* fold dependencies first, so constants propagate through chains */
+	foreach(ShaderInput *input, node->inputs)
+		if(input->link)
+			constant_fold(done, input->link->parent);
+
+	foreach(ShaderOutput *socket, node->outputs) {
+		if(socket->links.size() == 0 || socket->type == SHADER_SOCKET_CLOSURE)
+			continue;
+
+		float3 value = make_float3(0.0f, 0.0f, 0.0f);
+
+		if(!node->constant_fold(socket, &value))
+			continue;
+
+		/* replace links with the value, except for inputs that get a texture
+		 * coordinate or other default when unlinked, and the shader output
+		 * where an unlinked displacement is ignored */
+		vector<ShaderInput*> links(socket->links);
+
+		foreach(ShaderInput *to, links) {
+			if(to->default_value == ShaderInput::NONE && to->parent != output()) {
+				disconnect(to);
+				to->value = value;
+			}
+		}
+	}
+}
+
+static void sort_dependencies(ShaderNode *node, vector<bool>& visited, vector<ShaderNode*>& sorted)
+{
+	visited[node->id] = true;
+
+	foreach(ShaderInput *input, node->inputs)
+		if(input->link && !visited[input->link->parent->id])
+			sort_dependencies(input->link->parent, visited, sorted);
+
+	sorted.push_back(node);
+}
+
+static bool nodes_equal(ShaderNode *a, ShaderNode *b)
+{
+	if(a->name != b->name || a->bump != b->bump)
+		return false;
+	if(a->inputs.size() != b->inputs.size() || a->outputs.size() != b->outputs.size())
+		return false;
+	if(!a->equals(b))
+		return false;
+
+	for(size_t i = 0; i < a->inputs.size(); i++) {
+		ShaderInput *ain = a->inputs[i];
+		ShaderInput *bin = b->inputs[i];
+
+		if(ain->link != bin->link)
+			return false;
+
+		if(!ain->link) {
+			if(ain->default_value != bin->default_value)
+				return false;
+			if(ain->value.x != bin->value.x || ain->value.y != bin->value.y || ain->value.z != bin->value.z)
+				return false;
+			if(ain->value_string != bin->value_string)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void ShaderGraph::deduplicate_nodes()
+{
+	/* merge nodes with the same settings and inputs, so that identical sub
+	 * expressions are only evaluated once. nodes are visited with their
+	 * dependencies first, so that merging propagates down the graph */
+	vector<bool> visited(num_node_ids, false);
+	vector<ShaderNode*> sorted;
+
+	sort_dependencies(output(), visited, sorted);
+
+	map<ustring, vector<ShaderNode*> > candidates;
+
+	foreach(ShaderNode *node, sorted) {
+		vector<ShaderNode*>& same_name = candidates[node->name];
+		ShaderNode *merge = NULL;
+
+		foreach(ShaderNode *other, same_name) {
+			if(nodes_equal(node, other)) {
+				merge = other;
+				break;
+			}
+		}
+
+		if(!merge) {
+			same_name.push_back(node);
+			continue;
+		}
+
+		/* relink to the existing node, this node is removed as unused */
+		for(size_t i = 0; i < node->outputs.size(); i++) {
+			vector<ShaderInput*> links(node->outputs[i]->links);
+
+			foreach(ShaderInput *to, links) {
+				disconnect(to);
+				connect(merge->outputs[i], to);
+			}
+		}
+	}
+}
+
+void ShaderGraph::clean(bool do_osl)
 {
 	/* remove proxy and unnecessary mix nodes */
 	remove_unneeded_nodes();
@@ -479,6 +582,22 @@ void ShaderGraph::clean()
 	/* break cycles */
 	break_cycles(output(), visited, on_stack);
 
+	/* fold constants, which may make mix closure factors constant, and then
+	 * merge identical nodes. folding uses the SVM functions, OSL shaders can
+	 * compute slightly different results so they are left to the OSL optimizer */
+	if(!do_osl) {
+		vector<bool> done(num_node_ids, false);
+		constant_fold(done, output());
+	}
+
+	remove_unneeded_nodes();
+	deduplicate_nodes();
+
+	/* find nodes still used after optimizations */
+	visited.assign(num_node_ids, false);
+	on_stack.assign(num_node_ids, false);
+	break_cycles(output(), visited, on_stack);
+
 	/* disconnect unused nodes */
 	foreach(ShaderNode *node, nodes) {
 		if(!visited[node->id]) {
@@ -573,7 +692,7 @@ void ShaderGraph::refine_bump_nodes()
 	foreach(ShaderNode *node, nodes) {
 		if(node->name == ustring("bump") && node->input("Height")->link) {
 			ShaderInput *bump_input = node->input("Height");
-			set<ShaderNode*> nodes_bump;
+			ShaderNodeSet nodes_bump;
 
 			/* make 2 extra copies of the subgraph defined in Bump input */
 			map<ShaderNode*, ShaderNode*> nodes_dx;
@@ -601,11 +720,12 @@ void ShaderGraph::refine_bump_nodes()
 			connect(out_dx, node->input("SampleX"));
 			connect(out_dy, node->input("SampleY"));
 			
-			/* add generated nodes */
-			foreach(NodePair& pair, nodes_dx)
-				add(pair.second);
-			foreach(NodePair& pair, nodes_dy)
-				add(pair.second);
+			/* add generated nodes, in the order of the original node ids so
+			 * the new ids don't depend on pointer order in the maps */
+			foreach(ShaderNode *node, nodes_bump)
+				add(nodes_dx[node]);
+			foreach(ShaderNode *node, nodes_bump)
+				add(nodes_dy[node]);
 			
 			/* connect what is conected is bump to samplecenter input*/
 			connect(out , node->input("SampleCenter"));
@@ -639,7 +759,7 @@ void ShaderGraph::bump_from_displacement()
 		return;
 	
 	/* find dependencies for the given input */
-	set<ShaderNode*> nodes_displace;
+	ShaderNodeSet nodes_displace;
 	find_dependencies(nodes_displace, displacement_in);
 
 	/* copy nodes for 3 bump samples */
@@ -696,13 +816,14 @@ void ShaderGraph::bump_from_displacement()
 		bump_normal_in->link = NULL;
 
 	/* finally, add the copied nodes to the graph. we can't do this earlier
-	 * because we would create dependency cycles in the above loop */
-	foreach(NodePair& pair, nodes_center)
-		add(pair.second);
-	foreach(NodePair& pair, nodes_dx)
-		add(pair.second);
-	foreach(NodePair& pair, nodes_dy)
-		add(pair.second);
+	 * because we would create dependency cycles in the above loop. the order
+	 * of the original node ids is used so the new ids are deterministic */
+	foreach(ShaderNode *node, nodes_displace)
+		add(nodes_center[node]);
+	foreach(ShaderNode *node, nodes_displace)
+		add(nodes_dx[node]);
+	foreach(ShaderNode *node, nodes_displace)
+		add(nodes_dy[node]);
 }
 
 void ShaderGraph::transform_multi_closure(ShaderNode *node, ShaderOutput *weight_out, bool volume)
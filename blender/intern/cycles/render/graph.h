@@ -192,6 +192,13 @@ public:
 	virtual bool has_converter_blackbody() { return false; }
 	virtual bool has_bssrdf_bump() { return false; }
 
+	/* constant folding, returns true and the value of the output socket if
+	 * it can be computed at compile time */
+	virtual bool constant_fold(ShaderOutput *socket, float3 *optimized_value) { return false; }
+	/* compare node settings other than inputs, for merging identical nodes.
+	 * nodes that do not implement this are never merged */
+	virtual bool equals(const ShaderNode *other) { return false; }
+
 	vector<ShaderInput*> inputs;
 	vector<ShaderOutput*> outputs;
 
@@ -203,6 +210,19 @@ public:
 };
 
 
+/* Set of shader nodes, ordered by node id rather than by pointer so that
+ * graph copies and compiled code do not depend on memory layout */
+
+struct ShaderNodeIDComparator
+{
+	bool operator()(const ShaderNode *n1, const ShaderNode *n2) const
+	{
+		return n1->id < n2->id;
+	}
+};
+
+typedef set<ShaderNode*, ShaderNodeIDComparator> ShaderNodeSet;
+
 /* Node definition utility macros */
 
 #define SHADER_NODE_CLASS(type) \
@@ -249,11 +269,13 @@ public:
 protected:
 	typedef pair<ShaderNode* const, ShaderNode*> NodePair;
 
-	void find_dependencies(set<ShaderNode*>& dependencies, ShaderInput *input);
-	void copy_nodes(set<ShaderNode*>& nodes, map<ShaderNode*, ShaderNode*>& nnodemap);
+	void find_dependencies(ShaderNodeSet& dependencies, ShaderInput *input);
+	void copy_nodes(ShaderNodeSet& nodes, map<ShaderNode*, ShaderNode*>& nnodemap);
 
 	void break_cycles(ShaderNode *node, vector<bool>& visited, vector<bool>& on_stack);
-	void clean();
+	void constant_fold(vector<bool>& done, ShaderNode *node);
+	void deduplicate_nodes();
+	void clean(bool do_osl);
 	void bump_from_displacement();
 	void refine_bump_nodes();
 	void default_inputs(bool do_osl);
@@ -22,6 +22,7 @@
 #include "util_image.h"
 #include "util_path.h"
 #include "util_progress.h"
+#include "util_texture_cache.h"
 
 #ifdef WITH_OSL
 #include <OSL/oslexec.h>
@@ -33,9 +34,13 @@ ImageManager::ImageManager()
 {
 	need_update = true;
 	pack_images = false;
+	compact_images = false;
 	osl_texture_system = NULL;
 	animation_frame = 0;
 
+	texture_cache = NULL;
+	texture_cache_size = 0;
+
 	tex_num_images = TEX_NUM_IMAGES;
 	tex_num_float_images = TEX_NUM_FLOAT_IMAGES;
 	tex_image_byte_start = TEX_IMAGE_BYTE_START;
@@ -47,6 +52,8 @@ ImageManager::~ImageManager()
 		assert(!images[slot]);
 	for(size_t slot = 0; slot < float_images.size(); slot++)
 		assert(!float_images[slot]);
+
+	delete texture_cache;
 }
 
 void ImageManager::set_pack_images(bool pack_images_)
@@ -54,6 +61,17 @@ void ImageManager::set_pack_images(bool pack_images_)
 	pack_images = pack_images_;
 }
 
+void ImageManager::set_compact_images(bool compact_images_)
+{
+	compact_images = compact_images_;
+}
+
+void ImageManager::set_texture_cache_size(int texture_cache_size_)
+{
+	/* size in megabytes, or 0 to load images fully into memory */
+	texture_cache_size = texture_cache_size_;
+}
+
 void ImageManager::set_osl_texture_system(void *texture_system)
 {
 	osl_texture_system = texture_system;
@@ -84,14 +102,24 @@ bool ImageManager::set_animation_frame_update(int frame)
 }
 
 bool ImageManager::is_float_image(const string& filename, void *builtin_data, bool& is_linear)
+{
+	int components;
+	bool is_half;
+
+	return image_info(filename, builtin_data, is_linear, components, is_half);
+}
+
+bool ImageManager::image_info(const string& filename, void *builtin_data, bool& is_linear, int& components, bool& is_half)
 {
 	bool is_float = false;
 	is_linear = false;
+	components = 4;
+	is_half = false;
 
 	if(builtin_data) {
 		if(builtin_image_info_cb) {
-			int width, height, channels;
-			builtin_image_info_cb(filename, builtin_data, is_float, width, height, channels);
+			int width, height;
+			builtin_image_info_cb(filename, builtin_data, is_float, width, height, components);
 		}
 
 		if(is_float)
@@ -120,6 +148,14 @@ bool ImageManager::is_float_image(const string& filename, void *builtin_data, bo
 				}
 			}
 
+			/* half float images can be stored as half floats without loss */
+			components = spec.nchannels;
+			is_half = (spec.format == TypeDesc::HALF);
+
+			for(size_t channel = 0; channel < spec.channelformats.size(); channel++)
+				if(spec.channelformats[channel] != TypeDesc::HALF)
+					is_half = false;
+
 			/* basic color space detection, not great but better than nothing
 			 * before we do OpenColorIO integration */
 			if(is_float) {
@@ -149,9 +185,11 @@ int ImageManager::add_image(const string& filename, void *builtin_data, bool ani
 {
 	Image *img;
 	size_t slot;
+	int components = 4;
+	bool is_half = false;
 
 	/* load image info and find out if we need a float texture */
-	is_float = (pack_images)? false: is_float_image(filename, builtin_data, is_linear);
+	is_float = (pack_images)? false: image_info(filename, builtin_data, is_linear, components, is_half);
 
 	if(is_float) {
 		/* find existing image */
@@ -186,6 +224,8 @@ int ImageManager::add_image(const string& filename, void *builtin_data, bool ani
 		img->need_load = true;
 		img->animated = animated;
 		img->users = 1;
+		img->components = components;
+		img->is_half = is_half;
 
 		float_images[slot] = img;
 	}
@@ -221,6 +261,8 @@ int ImageManager::add_image(const string& filename, void *builtin_data, bool ani
 		img->need_load = true;
 		img->animated = animated;
 		img->users = 1;
+		img->components = components;
+		img->is_half = false;
 
 		images[slot] = img;
 
@@ -271,13 +313,65 @@ void ImageManager::remove_image(const string& filename, void *builtin_data)
 	}
 }
 
-bool ImageManager::file_load_image(Image *img, device_vector<uchar4>& tex_img)
+static TypeDesc image_type_desc(uchar)
+{
+	return TypeDesc::UINT8;
+}
+
+static TypeDesc image_type_desc(half)
+{
+	return TypeDesc::HALF;
+}
+
+static TypeDesc image_type_desc(float)
+{
+	return TypeDesc::FLOAT;
+}
+
+static uchar image_one(uchar)
+{
+	return 255;
+}
+
+static half image_one(half)
+{
+	return 0x3C00;
+}
+
+static float image_one(float)
+{
+	return 1.0f;
+}
+
+bool ImageManager::builtin_load_pixels(Image *img, uchar *pixels)
+{
+	return builtin_image_pixels_cb(img->filename, img->builtin_data, pixels);
+}
+
+bool ImageManager::builtin_load_pixels(Image *img, half *pixels)
+{
+	/* builtin images are only available as bytes or floats */
+	return false;
+}
+
+bool ImageManager::builtin_load_pixels(Image *img, float *pixels)
+{
+	return builtin_image_float_pixels_cb(img->filename, img->builtin_data, pixels);
+}
+
+/* load image with components of type T into a texture with one or four
+ * channels. single channel textures take the first channel of the image,
+ * four channel textures get grey and alpha expanded as needed */
+
+template<typename T, typename DeviceType>
+bool ImageManager::file_load_image(Image *img, device_vector<DeviceType>& tex_img)
 {
 	if(img->filename == "")
 		return false;
 
 	ImageInput *in = NULL;
 	int width, height, components;
+	int channels = sizeof(DeviceType)/sizeof(T);
 
 	if(!img->builtin_data) {
 		/* load image from file through OIIO */
@@ -299,7 +393,7 @@ bool ImageManager::file_load_image(Image *img, device_vector<uchar4>& tex_img)
 	}
 	else {
 		/* load image using builtin images callbacks */
-		if(!builtin_image_info_cb || !builtin_image_pixels_cb)
+		if(!builtin_image_info_cb || !builtin_image_pixels_cb || !builtin_image_float_pixels_cb)
 			return false;
 
 		bool is_float;
@@ -316,13 +410,22 @@ bool ImageManager::file_load_image(Image *img, device_vector<uchar4>& tex_img)
 		return false;
 	}
 
-	/* read RGBA pixels */
-	uchar *pixels = (uchar*)tex_img.resize(width, height);
-	int scanlinesize = width*components*sizeof(uchar);
+	/* read pixels, through a temporary buffer if the image has more channels
+	 * than the texture */
+	T *pixels = (T*)tex_img.resize(width, height);
+	vector<T> tmp_pixels;
+	T *read_pixels = pixels;
+
+	if(components > channels) {
+		tmp_pixels.resize((size_t)width*height*components);
+		read_pixels = &tmp_pixels[0];
+	}
+
+	int scanlinesize = width*components*sizeof(T);
 
 	if(in) {
-		in->read_image(TypeDesc::UINT8,
-			(uchar*)pixels + (height-1)*scanlinesize,
+		in->read_image(image_type_desc(T()),
+			(uchar*)read_pixels + (height-1)*scanlinesize,
 			AutoStride,
 			-scanlinesize,
 			AutoStride);
@@ -331,125 +434,70 @@ bool ImageManager::file_load_image(Image *img, device_vector<uchar4>& tex_img)
 		delete in;
 	}
 	else {
-		builtin_image_pixels_cb(img->filename, img->builtin_data, pixels);
+		builtin_load_pixels(img, read_pixels);
 	}
 
-	if(components == 2) {
-		for(int i = width*height-1; i >= 0; i--) {
-			pixels[i*4+3] = pixels[i*2+1];
-			pixels[i*4+2] = pixels[i*2+0];
-			pixels[i*4+1] = pixels[i*2+0];
-			pixels[i*4+0] = pixels[i*2+0];
-		}
+	if(components > channels) {
+		for(int i = 0; i < width*height; i++)
+			pixels[i] = read_pixels[i*components];
 	}
-	else if(components == 3) {
-		for(int i = width*height-1; i >= 0; i--) {
-			pixels[i*4+3] = 255;
-			pixels[i*4+2] = pixels[i*3+2];
-			pixels[i*4+1] = pixels[i*3+1];
-			pixels[i*4+0] = pixels[i*3+0];
+	else if(channels == 4) {
+		T one = image_one(T());
+
+		if(components == 2) {
+			for(int i = width*height-1; i >= 0; i--) {
+				pixels[i*4+3] = pixels[i*2+1];
+				pixels[i*4+2] = pixels[i*2+0];
+				pixels[i*4+1] = pixels[i*2+0];
+				pixels[i*4+0] = pixels[i*2+0];
+			}
 		}
-	}
-	else if(components == 1) {
-		for(int i = width*height-1; i >= 0; i--) {
-			pixels[i*4+3] = 255;
-			pixels[i*4+2] = pixels[i];
-			pixels[i*4+1] = pixels[i];
-			pixels[i*4+0] = pixels[i];
+		else if(components == 3) {
+			for(int i = width*height-1; i >= 0; i--) {
+				pixels[i*4+3] = one;
+				pixels[i*4+2] = pixels[i*3+2];
+				pixels[i*4+1] = pixels[i*3+1];
+				pixels[i*4+0] = pixels[i*3+0];
+			}
+		}
+		else if(components == 1) {
+			for(int i = width*height-1; i >= 0; i--) {
+				pixels[i*4+3] = one;
+				pixels[i*4+2] = pixels[i];
+				pixels[i*4+1] = pixels[i];
+				pixels[i*4+0] = pixels[i];
+			}
 		}
 	}
 
 	return true;
 }
 
-bool ImageManager::file_load_float_image(Image *img, device_vector<float4>& tex_img)
+template<typename T>
+void ImageManager::device_free_pixels(Device *device, device_vector<T>& tex_img)
 {
-	if(img->filename == "")
-		return false;
-
-	ImageInput *in = NULL;
-	int width, height, components;
-
-	if(!img->builtin_data) {
-		/* load image from file through OIIO */
-		in = ImageInput::create(img->filename);
-
-		if(!in)
-			return false;
-
-		ImageSpec spec;
-
-		if(!in->open(img->filename, spec)) {
-			delete in;
-			return false;
-		}
-
-		/* we only handle certain number of components */
-		width = spec.width;
-		height = spec.height;
-		components = spec.nchannels;
-	}
-	else {
-		/* load image using builtin images callbacks */
-		if(!builtin_image_info_cb || !builtin_image_float_pixels_cb)
-			return false;
-
-		bool is_float;
-		builtin_image_info_cb(img->filename, img->builtin_data, is_float, width, height, components);
+	if(tex_img.device_pointer) {
+		thread_scoped_lock device_lock(device_mutex);
+		device->tex_free(tex_img);
 	}
 
-	if(!(components >= 1 && components <= 4)) {
-		if(in) {
-			in->close();
-			delete in;
-		}
-		return false;
-	}
-
-	/* read RGBA pixels */
-	float *pixels = (float*)tex_img.resize(width, height);
-	int scanlinesize = width*components*sizeof(float);
+	tex_img.clear();
+}
 
-	if(in) {
-		in->read_image(TypeDesc::FLOAT,
-			(uchar*)pixels + (height-1)*scanlinesize,
-			AutoStride,
-			-scanlinesize,
-			AutoStride);
+void ImageManager::device_free_slot_pixels(Device *device, DeviceScene *dscene, int slot)
+{
+	if(slot >= tex_image_byte_start) {
+		int byte_slot = slot - tex_image_byte_start;
 
-		in->close();
-		delete in;
+		device_free_pixels(device, dscene->tex_image[byte_slot]);
+		device_free_pixels(device, dscene->tex_image_grey[byte_slot]);
 	}
 	else {
-		builtin_image_float_pixels_cb(img->filename, img->builtin_data, pixels);
-	}
-
-	if(components == 2) {
-		for(int i = width*height-1; i >= 0; i--) {
-			pixels[i*4+3] = pixels[i*2+1];
-			pixels[i*4+2] = pixels[i*2+0];
-			pixels[i*4+1] = pixels[i*2+0];
-			pixels[i*4+0] = pixels[i*2+0];
-		}
-	}
-	else if(components == 3) {
-		for(int i = width*height-1; i >= 0; i--) {
-			pixels[i*4+3] = 1.0f;
-			pixels[i*4+2] = pixels[i*3+2];
-			pixels[i*4+1] = pixels[i*3+1];
-			pixels[i*4+0] = pixels[i*3+0];
-		}
-	}
-	else if(components == 1) {
-		for(int i = width*height-1; i >= 0; i--) {
-			pixels[i*4+3] = 1.0f;
-			pixels[i*4+2] = pixels[i];
-			pixels[i*4+1] = pixels[i];
-			pixels[i*4+0] = pixels[i];
-		}
+		device_free_pixels(device, dscene->tex_float_image[slot]);
+		device_free_pixels(device, dscene->tex_float_image_grey[slot]);
+		device_free_pixels(device, dscene->tex_half_image[slot]);
+		device_free_pixels(device, dscene->tex_half_image_grey[slot]);
 	}
-
-	return true;
 }
 
 void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int slot, Progress *progress)
@@ -471,67 +519,101 @@ void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int sl
 		is_float = true;
 	}
 
-	if(is_float) {
-		string filename = path_filename(float_images[slot]->filename);
-		progress->set_status("Updating Images", "Loading " + filename);
+	if(texture_cache && !img->builtin_data) {
+		/* look up tiles from disk on demand, instead of loading the image */
+		string filename = path_filename(img->filename);
+		progress->set_status("Updating Images", "Caching " + filename);
+
+		if(texture_cache->add_image(slot, img->filename)) {
+			/* free pixels in case the image was loaded into memory before */
+			device_free_slot_pixels(device, dscene, slot);
 
-		device_vector<float4>& tex_img = dscene->tex_float_image[slot];
+			img->need_load = false;
+			return;
+		}
+
+		/* fall back to loading into memory */
+		texture_cache->remove_image(slot);
+	}
+
+	string filename = path_filename(img->filename);
+	progress->set_status("Updating Images", "Loading " + filename);
+
+	/* free previous pixels, storage may change on reload */
+	device_free_slot_pixels(device, dscene, slot);
 
-		if(tex_img.device_pointer) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_free(tex_img);
+	bool grey = compact_images && img->components == 1;
+	device_memory *tex_mem = NULL;
+	string name;
+
+	if(is_float) {
+		bool is_half = compact_images && img->is_half;
+
+		if(grey && is_half) {
+			if(file_load_image<half>(img, dscene->tex_half_image_grey[slot]))
+				tex_mem = &dscene->tex_half_image_grey[slot];
+		}
+		else if(grey) {
+			if(file_load_image<float>(img, dscene->tex_float_image_grey[slot]))
+				tex_mem = &dscene->tex_float_image_grey[slot];
+		}
+		else if(is_half) {
+			if(file_load_image<half>(img, dscene->tex_half_image[slot]))
+				tex_mem = &dscene->tex_half_image[slot];
+		}
+		else {
+			if(file_load_image<float>(img, dscene->tex_float_image[slot]))
+				tex_mem = &dscene->tex_float_image[slot];
 		}
 
-		if(!file_load_float_image(img, tex_img)) {
+		if(!tex_mem) {
 			/* on failure to load, we set a 1x1 pixels pink image */
+			device_vector<float4>& tex_img = dscene->tex_float_image[slot];
 			float *pixels = (float*)tex_img.resize(1, 1);
 
 			pixels[0] = TEX_IMAGE_MISSING_R;
 			pixels[1] = TEX_IMAGE_MISSING_G;
 			pixels[2] = TEX_IMAGE_MISSING_B;
 			pixels[3] = TEX_IMAGE_MISSING_A;
-		}
 
-		string name;
+			tex_mem = &tex_img;
+		}
 
 		if(slot >= 10) name = string_printf("__tex_image_float_0%d", slot);
 		else name = string_printf("__tex_image_float_00%d", slot);
-
-		if(!pack_images) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_alloc(name.c_str(), tex_img, true, true);
-		}
 	}
 	else {
-		string filename = path_filename(images[slot - tex_image_byte_start]->filename);
-		progress->set_status("Updating Images", "Loading " + filename);
+		int byte_slot = slot - tex_image_byte_start;
 
-		device_vector<uchar4>& tex_img = dscene->tex_image[slot - tex_image_byte_start];
-
-		if(tex_img.device_pointer) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_free(tex_img);
+		if(grey) {
+			if(file_load_image<uchar>(img, dscene->tex_image_grey[byte_slot]))
+				tex_mem = &dscene->tex_image_grey[byte_slot];
+		}
+		else {
+			if(file_load_image<uchar>(img, dscene->tex_image[byte_slot]))
+				tex_mem = &dscene->tex_image[byte_slot];
 		}
 
-		if(!file_load_image(img, tex_img)) {
+		if(!tex_mem) {
 			/* on failure to load, we set a 1x1 pixels pink image */
+			device_vector<uchar4>& tex_img = dscene->tex_image[byte_slot];
 			uchar *pixels = (uchar*)tex_img.resize(1, 1);
 
 			pixels[0] = (TEX_IMAGE_MISSING_R * 255);
 			pixels[1] = (TEX_IMAGE_MISSING_G * 255);
 			pixels[2] = (TEX_IMAGE_MISSING_B * 255);
 			pixels[3] = (TEX_IMAGE_MISSING_A * 255);
-		}
 
-		string name;
+			tex_mem = &tex_img;
+		}
 
 		if(slot >= 10) name = string_printf("__tex_image_0%d", slot);
 		else name = string_printf("__tex_image_00%d", slot);
+	}
 
-		if(!pack_images) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_alloc(name.c_str(), tex_img, true, true);
-		}
+	if(!pack_images) {
+		thread_scoped_lock device_lock(device_mutex);
+		device->tex_alloc(name.c_str(), *tex_mem, true, true);
 	}
 
 	img->need_load = false;
@@ -552,6 +634,9 @@ void ImageManager::device_free_image(Device *device, DeviceScene *dscene, int sl
 	}
 
 	if(img) {
+		if(texture_cache)
+			texture_cache->remove_image(slot);
+
 		if(osl_texture_system) {
 #ifdef WITH_OSL
 			ustring filename(images[slot]->filename);
@@ -559,27 +644,13 @@ void ImageManager::device_free_image(Device *device, DeviceScene *dscene, int sl
 #endif
 		}
 		else if(is_float) {
-			device_vector<float4>& tex_img = dscene->tex_float_image[slot];
-
-			if(tex_img.device_pointer) {
-				thread_scoped_lock device_lock(device_mutex);
-				device->tex_free(tex_img);
-			}
-
-			tex_img.clear();
+			device_free_slot_pixels(device, dscene, slot);
 
 			delete float_images[slot];
 			float_images[slot] = NULL;
 		}
 		else {
-			device_vector<uchar4>& tex_img = dscene->tex_image[slot - tex_image_byte_start];
-
-			if(tex_img.device_pointer) {
-				thread_scoped_lock device_lock(device_mutex);
-				device->tex_free(tex_img);
-			}
-
-			tex_img.clear();
+			device_free_slot_pixels(device, dscene, slot);
 
 			delete images[slot - tex_image_byte_start];
 			images[slot - tex_image_byte_start] = NULL;
@@ -592,6 +663,13 @@ void ImageManager::device_update(Device *device, DeviceScene *dscene, Progress&
 	if(!need_update)
 		return;
 
+	/* texture cache is only supported for SVM on the CPU, with OSL the OSL
+	 * texture system is used instead */
+	if(texture_cache_size && !texture_cache && !osl_texture_system && !pack_images) {
+		texture_cache = new TextureCache(texture_cache_size);
+		device->const_copy_to("__texture_cache", &texture_cache, sizeof(texture_cache));
+	}
+
 	TaskPool pool;
 
 	for(size_t slot = 0; slot < images.size(); slot++) {
@@ -678,6 +756,14 @@ void ImageManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->tex_image_packed.clear();
 	dscene->tex_image_packed_info.clear();
 
+	if(texture_cache) {
+		TextureCache *null_cache = NULL;
+		device->const_copy_to("__texture_cache", &null_cache, sizeof(null_cache));
+
+		delete texture_cache;
+		texture_cache = NULL;
+	}
+
 	images.clear();
 	float_images.clear();
 }
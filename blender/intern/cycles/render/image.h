@@ -43,6 +43,7 @@ CCL_NAMESPACE_BEGIN
 class Device;
 class DeviceScene;
 class Progress;
+class TextureCache;
 
 class ImageManager {
 public:
@@ -58,6 +59,8 @@ public:
 
 	void set_osl_texture_system(void *texture_system);
 	void set_pack_images(bool pack_images_);
+	void set_compact_images(bool compact_images_);
+	void set_texture_cache_size(int texture_cache_size_);
 	void set_extended_image_limits(void);
 	bool set_animation_frame_update(int frame);
 
@@ -80,15 +83,35 @@ private:
 		bool need_load;
 		bool animated;
 		int users;
+
+		/* channels and format in the file, to choose the texture storage */
+		int components;
+		bool is_half;
 	};
 
 	vector<Image*> images;
 	vector<Image*> float_images;
 	void *osl_texture_system;
 	bool pack_images;
+	/* store single channel images with one channel and half float images as
+	 * half floats, instead of expanding all images to RGBA */
+	bool compact_images;
+
+	/* out of core image textures, read from disk on demand */
+	TextureCache *texture_cache;
+	int texture_cache_size;
+
+	bool image_info(const string& filename, void *builtin_data, bool& is_linear, int& components, bool& is_half);
+
+	template<typename T, typename DeviceType>
+	bool file_load_image(Image *img, device_vector<DeviceType>& tex_img);
+	bool builtin_load_pixels(Image *img, uchar *pixels);
+	bool builtin_load_pixels(Image *img, half *pixels);
+	bool builtin_load_pixels(Image *img, float *pixels);
 
-	bool file_load_image(Image *img, device_vector<uchar4>& tex_img);
-	bool file_load_float_image(Image *img, device_vector<float4>& tex_img);
+	template<typename T>
+	void device_free_pixels(Device *device, device_vector<T>& tex_img);
+	void device_free_slot_pixels(Device *device, DeviceScene *dscene, int slot);
 
 	void device_load_image(Device *device, DeviceScene *dscene, int slot, Progress *progess);
 	void device_free_image(Device *device, DeviceScene *dscene, int slot);
@@ -19,12 +19,14 @@
 #include "integrator.h"
 #include "film.h"
 #include "light.h"
+#include "light_tree.h"
 #include "mesh.h"
 #include "object.h"
 #include "scene.h"
 #include "shader.h"
 
 #include "util_foreach.h"
+#include "util_map.h"
 #include "util_progress.h"
 
 CCL_NAMESPACE_BEGIN
@@ -196,6 +198,13 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	float4 *distribution = dscene->light_distribution.resize(num_distribution + 1);
 	float totarea = 0.0f;
 
+	/* emitters for the light trees, and for each object with emission its
+	 * mesh and first emitter, to find emitters hit by rays */
+	vector<LightTreeEmitter> triangle_emitters;
+	vector<LightTreeEmitter> lamp_emitters;
+	vector<Mesh*> object_emitter_mesh(scene->objects.size(), NULL);
+	vector<uint> object_emitter_offset(scene->objects.size(), ~0);
+
 	/* triangles */
 	size_t offset = 0;
 	int j = 0;
@@ -243,16 +252,13 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 				use_light_visibility = true;
 			}
 
+			object_emitter_mesh[j] = mesh;
+			object_emitter_offset[j] = offset;
+
 			for(size_t i = 0; i < mesh->triangles.size(); i++) {
 				Shader *shader = scene->shaders[mesh->shader[i]];
 
 				if(shader->use_mis && shader->has_surface_emission) {
-					distribution[offset].x = totarea;
-					distribution[offset].y = __int_as_float(i + mesh->tri_offset);
-					distribution[offset].z = __int_as_float(shader_id);
-					distribution[offset].w = __int_as_float(object_id);
-					offset++;
-
 					Mesh::Triangle t = mesh->triangles[i];
 					float3 p1 = mesh->verts[t.v[0]];
 					float3 p2 = mesh->verts[t.v[1]];
@@ -264,7 +270,29 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 						p3 = transform_point(&tfm, p3);
 					}
 
-					totarea += triangle_area(p1, p2, p3);
+					float area = triangle_area(p1, p2, p3);
+					float3 N = cross(p2 - p1, p3 - p1);
+
+					/* area is turned into the cumulative distribution after
+					 * building the light trees */
+					distribution[offset].x = area;
+					distribution[offset].y = __int_as_float(i + mesh->tri_offset);
+					distribution[offset].z = __int_as_float(shader_id);
+					distribution[offset].w = __int_as_float(object_id);
+
+					LightTreeEmitter emitter;
+					emitter.bounds = BoundBox(p1);
+					emitter.bounds.grow(p2);
+					emitter.bounds.grow(p3);
+					emitter.centroid = (p1 + p2 + p3)*(1.0f/3.0f);
+					emitter.N = (len(N) > 0.0f)? normalize(N): make_float3(0.0f, 0.0f, 0.0f);
+					emitter.energy = area;
+					emitter.index = offset;
+					triangle_emitters.push_back(emitter);
+
+					offset++;
+
+					totarea += area;
 				}
 			}
 
@@ -314,19 +342,139 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	float lightarea = (totarea > 0.0f)? totarea/scene->lights.size(): 1.0f;
 	bool use_lamp_mis = false;
 
-	for(int i = 0; i < scene->lights.size(); i++, offset++) {
-		Light *light = scene->lights[i];
+	/* lamps with a position go first, in the order of the lamp tree */
+	for(int pass = 0; pass < 2; pass++) {
+		for(int i = 0; i < scene->lights.size(); i++) {
+			Light *light = scene->lights[i];
+			bool infinite = (light->type == LIGHT_DISTANT || light->type == LIGHT_BACKGROUND);
+
+			if(infinite != (pass == 1))
+				continue;
+
+			distribution[offset].x = lightarea;
+			distribution[offset].y = __int_as_float(~(int)i);
+			distribution[offset].z = 1.0f;
+			distribution[offset].w = light->size;
+
+			if(!infinite) {
+				float radius = light->size;
+
+				if(light->type == LIGHT_AREA) {
+					float3 axisu = light->axisu*(light->sizeu*light->size);
+					float3 axisv = light->axisv*(light->sizev*light->size);
+					radius = 0.5f*(len(axisu) + len(axisv));
+				}
 
-		distribution[offset].x = totarea;
-		distribution[offset].y = __int_as_float(~(int)i);
-		distribution[offset].z = 1.0f;
-		distribution[offset].w = light->size;
-		totarea += lightarea;
+				float3 extent = make_float3(radius, radius, radius);
 
-		if(light->size > 0.0f && light->use_mis)
-			use_lamp_mis = true;
-		if(light->type == LIGHT_BACKGROUND)
-			num_background_lights++;
+				LightTreeEmitter emitter;
+				emitter.bounds = BoundBox(light->co - extent, light->co + extent);
+				emitter.centroid = light->co;
+				emitter.N = make_float3(0.0f, 0.0f, 0.0f);
+				emitter.energy = 1.0f;
+				emitter.index = offset;
+				lamp_emitters.push_back(emitter);
+			}
+
+			offset++;
+			totarea += lightarea;
+
+			if(light->size > 0.0f && light->use_mis)
+				use_lamp_mis = true;
+			if(light->type == LIGHT_BACKGROUND)
+				num_background_lights++;
+		}
+	}
+
+	/* build light trees, and reorder the distribution to match them */
+	vector<float4> tree_nodes;
+	LightTree tree(tree_nodes);
+
+	int triangle_root = tree.build(triangle_emitters, 0);
+	int lamp_root = tree.build(lamp_emitters, num_triangles);
+
+	if(tree_nodes.size()) {
+		vector<float4> entries(distribution, distribution + num_distribution);
+
+		for(size_t i = 0; i < triangle_emitters.size(); i++)
+			distribution[i] = entries[triangle_emitters[i].index];
+		for(size_t i = 0; i < lamp_emitters.size(); i++)
+			distribution[num_triangles + i] = entries[lamp_emitters[i].index];
+	}
+
+	if(triangle_root != -1) {
+		/* table to find the distribution index of emissive triangles hit by
+		 * rays, for multiple importance sampling. it starts with two entries
+		 * per object: the offset of the emissive range of its mesh, and the
+		 * offset of its first emitter in the tree order map. a mesh range is
+		 * shared by all instances and holds the first primitive and number of
+		 * primitives it covers, followed by the emitter index of each of them
+		 * within the mesh. the tree order map at the end gives the
+		 * distribution index of each emitter after reordering. */
+		vector<uint> table(scene->objects.size()*2, ~0);
+		map<Mesh*, uint> mesh_range;
+
+		for(size_t i = 0; i < scene->objects.size(); i++) {
+			Mesh *mesh = object_emitter_mesh[i];
+
+			if(!mesh)
+				continue;
+
+			map<Mesh*, uint>::iterator it = mesh_range.find(mesh);
+
+			if(it == mesh_range.end()) {
+				size_t first = 0;
+				size_t end = 0;
+
+				for(size_t k = 0; k < mesh->triangles.size(); k++) {
+					Shader *shader = scene->shaders[mesh->shader[k]];
+
+					if(shader->use_mis && shader->has_surface_emission) {
+						if(end == 0)
+							first = k;
+						end = k + 1;
+					}
+				}
+
+				it = mesh_range.insert(std::pair<Mesh*, uint>(mesh, (uint)table.size())).first;
+				table.push_back((uint)(first + mesh->tri_offset));
+				table.push_back((uint)(end - first));
+
+				uint local = 0;
+
+				for(size_t k = first; k < end; k++) {
+					Shader *shader = scene->shaders[mesh->shader[k]];
+
+					if(shader->use_mis && shader->has_surface_emission)
+						table.push_back(local++);
+					else
+						table.push_back(~0);
+				}
+			}
+
+			table[i*2 + 0] = it->second;
+		}
+
+		size_t tree_order = table.size();
+		table.resize(tree_order + num_triangles);
+
+		for(size_t i = 0; i < scene->objects.size(); i++)
+			if(object_emitter_mesh[i])
+				table[i*2 + 1] = (uint)tree_order + object_emitter_offset[i];
+
+		for(size_t i = 0; i < triangle_emitters.size(); i++)
+			table[tree_order + triangle_emitters[i].index] = i;
+
+		dscene->light_tree_emitters.copy(&table[0], table.size());
+	}
+
+	/* cumulative distribution from areas */
+	totarea = 0.0f;
+
+	for(size_t i = 0; i < num_distribution; i++) {
+		float area = distribution[i].x;
+		distribution[i].x = totarea;
+		totarea += area;
 	}
 
 	/* normalize cumulative distribution functions */
@@ -386,11 +534,26 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		if(num_background_lights < num_lights)
 			kfilm->pass_shadow_scale *= (float)(num_lights - num_background_lights)/(float)num_lights;
 
+		/* light trees */
+		kintegrator->light_tree_triangle_root = triangle_root;
+		kintegrator->light_tree_lamp_root = lamp_root;
+		kintegrator->light_tree_num_triangles = (triangle_root != -1)? num_triangles: 0;
+		kintegrator->light_tree_num_lamps = (lamp_root != -1)? lamp_emitters.size(): 0;
+
+		if(tree_nodes.size()) {
+			dscene->light_tree_nodes.copy(&tree_nodes[0], tree_nodes.size());
+			device->tex_alloc("__light_tree_nodes", dscene->light_tree_nodes);
+		}
+
+		if(triangle_root != -1)
+			device->tex_alloc("__light_tree_emitters", dscene->light_tree_emitters);
+
 		/* CDF */
 		device->tex_alloc("__light_distribution", dscene->light_distribution);
 	}
 	else {
 		dscene->light_distribution.clear();
+		dscene->light_tree_emitters.clear();
 
 		kintegrator->num_distribution = 0;
 		kintegrator->num_all_lights = 0;
@@ -398,6 +561,10 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		kintegrator->pdf_lights = 0.0f;
 		kintegrator->inv_pdf_lights = 0.0f;
 		kintegrator->use_lamp_mis = false;
+		kintegrator->light_tree_triangle_root = -1;
+		kintegrator->light_tree_lamp_root = -1;
+		kintegrator->light_tree_num_triangles = 0;
+		kintegrator->light_tree_num_lamps = 0;
 		kfilm->pass_shadow_scale = 1.0f;
 	}
 }
@@ -668,11 +835,15 @@ void LightManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->light_data);
 	device->tex_free(dscene->light_background_marginal_cdf);
 	device->tex_free(dscene->light_background_conditional_cdf);
+	device->tex_free(dscene->light_tree_nodes);
+	device->tex_free(dscene->light_tree_emitters);
 
 	dscene->light_distribution.clear();
 	dscene->light_data.clear();
 	dscene->light_background_marginal_cdf.clear();
 	dscene->light_background_conditional_cdf.clear();
+	dscene->light_tree_nodes.clear();
+	dscene->light_tree_emitters.clear();
 }
 
 void LightManager::tag_update(Scene *scene)
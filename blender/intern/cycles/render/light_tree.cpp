@@ -0,0 +1,146 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#include <algorithm>
+
+#include "kernel_types.h"
+
+#include "light_tree.h"
+
+#include "util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+struct LightTreeCentroidCompare {
+	int dim;
+
+	LightTreeCentroidCompare(int dim_)
+	: dim(dim_)
+	{
+	}
+
+	bool operator()(const LightTreeEmitter& a, const LightTreeEmitter& b) const
+	{
+		float ca = (dim == 0)? a.centroid.x: (dim == 1)? a.centroid.y: a.centroid.z;
+		float cb = (dim == 0)? b.centroid.x: (dim == 1)? b.centroid.y: b.centroid.z;
+
+		if(ca != cb)
+			return ca < cb;
+
+		/* keep order deterministic for equal centroids */
+		return a.index < b.index;
+	}
+};
+
+LightTree::LightTree(vector<float4>& nodes_, int max_leaf_size_)
+: nodes(nodes_), max_leaf_size(max_leaf_size_)
+{
+}
+
+int LightTree::build(vector<LightTreeEmitter>& emitters, int offset)
+{
+	if(emitters.size() == 0)
+		return -1;
+
+	return recursive_build(emitters, 0, emitters.size(), offset);
+}
+
+int LightTree::recursive_build(vector<LightTreeEmitter>& emitters, int start, int end, int offset)
+{
+	/* bounds, energy and centroid bounds */
+	BoundBox bounds = BoundBox::empty;
+	BoundBox centroid_bounds = BoundBox::empty;
+	float energy = 0.0f;
+
+	for(int i = start; i < end; i++) {
+		bounds.grow(emitters[i].bounds);
+		centroid_bounds.grow(emitters[i].centroid);
+		energy += emitters[i].energy;
+	}
+
+	/* cone bounding the normals. emission is two sided, so normals are only
+	 * bounded up to sign, flipping them to the side of the first normal */
+	float3 axis = make_float3(0.0f, 0.0f, 0.0f);
+	float3 ref = make_float3(0.0f, 0.0f, 0.0f);
+	bool omnidirectional = false;
+
+	for(int i = start; i < end; i++) {
+		float3 N = emitters[i].N;
+
+		if(is_zero(N)) {
+			omnidirectional = true;
+			break;
+		}
+
+		if(is_zero(ref))
+			ref = N;
+
+		axis += (dot(N, ref) < 0.0f)? -N: N;
+	}
+
+	float cos_theta_o = 0.0f;
+
+	if(!omnidirectional && len(axis) > 1e-5f) {
+		axis = normalize(axis);
+		cos_theta_o = 1.0f;
+
+		for(int i = start; i < end; i++)
+			cos_theta_o = min(cos_theta_o, fabsf(dot(axis, emitters[i].N)));
+	}
+	else
+		axis = make_float3(0.0f, 0.0f, 0.0f);
+
+	int index = nodes.size()/LIGHT_TREE_NODE_SIZE;
+	nodes.resize(nodes.size() + LIGHT_TREE_NODE_SIZE);
+
+	int num = end - start;
+	float3 extent = centroid_bounds.size();
+	int dim = (extent.x >= extent.y && extent.x >= extent.z)? 0: (extent.y >= extent.z)? 1: 2;
+	float max_extent = (dim == 0)? extent.x: (dim == 1)? extent.y: extent.z;
+
+	float4 link;
+
+	if(num <= max_leaf_size || max_extent == 0.0f) {
+		/* leaf with range of emitters */
+		link = make_float4(__int_as_float(offset + start), __int_as_float(num),
+			__int_as_float(0), __int_as_float(1));
+	}
+	else {
+		/* median split along the largest centroid axis */
+		int mid = start + num/2;
+
+		std::nth_element(emitters.begin() + start, emitters.begin() + mid,
+			emitters.begin() + end, LightTreeCentroidCompare(dim));
+
+		int left = recursive_build(emitters, start, mid, offset);
+		int right = recursive_build(emitters, mid, end, offset);
+
+		link = make_float4(__int_as_float(left), __int_as_float(right),
+			__int_as_float(offset + mid), __int_as_float(0));
+	}
+
+	float4 *node = &nodes[index*LIGHT_TREE_NODE_SIZE];
+
+	node[0] = make_float4(bounds.min.x, bounds.min.y, bounds.min.z, energy);
+	node[1] = make_float4(bounds.max.x, bounds.max.y, bounds.max.z, cos_theta_o);
+	node[2] = make_float4(axis.x, axis.y, axis.z, 0.0f);
+	node[3] = link;
+
+	return index;
+}
+
+CCL_NAMESPACE_END
+
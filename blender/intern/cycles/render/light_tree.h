@@ -0,0 +1,66 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "util_boundbox.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree Emitter
+ *
+ * Bounds, normal and energy of a triangle or lamp in the light distribution.
+ * Emitters without a preferred direction have a zero normal. */
+
+struct LightTreeEmitter {
+	BoundBox bounds;
+	float3 centroid;
+	float3 N;
+	float energy;
+	int index;
+};
+
+/* Light Tree
+ *
+ * Binary tree over emitters, traversed stochastically in the kernel to pick
+ * emitters by their estimated contribution to a shading point instead of only
+ * by area. Nodes store the bounds and total energy of their emitters, and a
+ * cone bounding the emitter normals, see kernel_light.h for the layout. Leaves
+ * cover a range of consecutive emitters in the light distribution, building
+ * reorders the emitters into that order. */
+
+class LightTree {
+public:
+	LightTree(vector<float4>& nodes, int max_leaf_size = 4);
+
+	/* build tree for emitters stored from offset in the light distribution,
+	 * appending to nodes, and return the root node index */
+	int build(vector<LightTreeEmitter>& emitters, int offset);
+
+protected:
+	int recursive_build(vector<LightTreeEmitter>& emitters, int start, int end, int offset);
+
+	vector<float4>& nodes;
+	int max_leaf_size;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
+
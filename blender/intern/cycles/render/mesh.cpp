@@ -29,11 +29,17 @@
 
 #include "util_cache.h"
 #include "util_foreach.h"
+#include "util_md5.h"
 #include "util_progress.h"
 #include "util_set.h"
 
 CCL_NAMESPACE_BEGIN
 
+/* Rebuild the top level BVH instead of refitting it when its SAH cost grows
+ * beyond this factor of the cost after the last full build. */
+
+#define BVH_REFIT_MAX_SAH_RATIO 1.5f
+
 /* Mesh */
 
 Mesh::Mesh()
@@ -54,6 +60,8 @@ Mesh::Mesh()
 	curve_offset = 0;
 	curvekey_offset = 0;
 
+	shared_mesh = NULL;
+
 	attributes.triangle_mesh = this;
 	curve_attributes.curve_mesh = this;
 }
@@ -376,7 +384,7 @@ void Mesh::compute_bvh(SceneParams *params, Progress *progress, int n, int total
 
 	compute_bounds();
 
-	if(!transform_applied) {
+	if(!transform_applied && !shared_mesh) {
 		string msg = "Updating Mesh BVH ";
 		if(name == "")
 			msg += string_printf("%u/%u", (uint)(n+1), (uint)total);
@@ -412,6 +420,73 @@ void Mesh::compute_bvh(SceneParams *params, Progress *progress, int n, int total
 	need_update_rebuild = false;
 }
 
+static void md5_append_float3(MD5Hash& md5, const float3 *data, size_t size)
+{
+	/* float3 may be padded, only hash the actual coordinates */
+	vector<float> buffer(size*3);
+
+	for(size_t i = 0; i < size; i++) {
+		buffer[i*3+0] = data[i].x;
+		buffer[i*3+1] = data[i].y;
+		buffer[i*3+2] = data[i].z;
+	}
+
+	if(size)
+		md5.append((const uint8_t*)&buffer[0], buffer.size()*sizeof(float));
+}
+
+void Mesh::compute_content_hash()
+{
+	/* hash of all data that goes into the BVH and packed mesh arrays, meshes
+	 * with the same hash can share them */
+	MD5Hash md5;
+
+	md5_append_float3(md5, (verts.size())? &verts[0]: NULL, verts.size());
+
+	if(triangles.size())
+		md5.append((const uint8_t*)&triangles[0], triangles.size()*sizeof(Triangle));
+	if(shader.size())
+		md5.append((const uint8_t*)&shader[0], shader.size()*sizeof(uint));
+
+	vector<uint8_t> smooth_flags(smooth.begin(), smooth.end());
+	if(smooth_flags.size())
+		md5.append(&smooth_flags[0], smooth_flags.size());
+
+	if(curve_keys.size()) {
+		vector<float> buffer(curve_keys.size()*4);
+
+		for(size_t i = 0; i < curve_keys.size(); i++) {
+			buffer[i*4+0] = curve_keys[i].co.x;
+			buffer[i*4+1] = curve_keys[i].co.y;
+			buffer[i*4+2] = curve_keys[i].co.z;
+			buffer[i*4+3] = curve_keys[i].radius;
+		}
+
+		md5.append((const uint8_t*)&buffer[0], buffer.size()*sizeof(float));
+	}
+
+	if(curves.size())
+		md5.append((const uint8_t*)&curves[0], curves.size()*sizeof(Curve));
+	if(used_shaders.size())
+		md5.append((const uint8_t*)&used_shaders[0], used_shaders.size()*sizeof(uint));
+
+	/* vertex normals are packed too, and may come from the host application */
+	Attribute *attr_vN = attributes.find(ATTR_STD_VERTEX_NORMAL);
+	if(attr_vN)
+		md5_append_float3(md5, attr_vN->data_float3(), verts.size());
+
+	int flags[2] = {transform_negative_scaled, displacement_method};
+	md5.append((const uint8_t*)flags, sizeof(flags));
+
+	content_hash = md5.get_hex();
+}
+
+Mesh *Mesh::get_shared_mesh()
+{
+	/* mesh that owns the BVH and packed data used for this mesh */
+	return (shared_mesh)? shared_mesh: this;
+}
+
 void Mesh::tag_update(Scene *scene, bool rebuild)
 {
 	need_update = true;
@@ -435,6 +510,7 @@ void Mesh::tag_update(Scene *scene, bool rebuild)
 MeshManager::MeshManager()
 {
 	bvh = NULL;
+	bvh_build_SAH = 0.0f;
 	need_update = true;
 }
 
@@ -751,6 +827,61 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 	}
 }
 
+void MeshManager::update_shared_meshes(Scene *scene, Progress& progress)
+{
+	if(!need_update)
+		return;
+
+	/* meshes with identical data, for example from objects duplicated along
+	 * with their mesh datablock, use the BVH and packed data of the first of
+	 * them, and are instanced like a single mesh with multiple users */
+	map<string, Mesh*> hash_map;
+
+	foreach(Mesh *mesh, scene->meshes) {
+		if(mesh->need_update)
+			mesh->compute_content_hash();
+
+		/* meshes with transform applied are no longer in object space, and
+		 * true displacement modifies the mesh after this point */
+		bool can_share = !mesh->transform_applied &&
+			(mesh->triangles.size() || mesh->curves.size());
+
+		if(can_share && mesh->displacement_method != Mesh::DISPLACE_BUMP) {
+			foreach(uint sindex, mesh->used_shaders)
+				if(scene->shaders[sindex]->has_displacement)
+					can_share = false;
+		}
+
+		Mesh *shared_mesh = NULL;
+
+		if(can_share) {
+			map<string, Mesh*>::iterator it = hash_map.find(mesh->content_hash);
+
+			if(it == hash_map.end())
+				hash_map[mesh->content_hash] = mesh;
+			else
+				shared_mesh = it->second;
+		}
+
+		if(shared_mesh != mesh->shared_mesh) {
+			if(shared_mesh) {
+				delete mesh->bvh;
+				mesh->bvh = NULL;
+			}
+			else {
+				/* no longer shared, needs its own BVH */
+				mesh->need_update = true;
+				mesh->need_update_rebuild = true;
+			}
+
+			mesh->shared_mesh = shared_mesh;
+			scene->object_manager->need_update = true;
+		}
+
+		if(progress.get_cancel()) return;
+	}
+}
+
 void MeshManager::device_update_mesh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
 	/* count and update offsets */
@@ -761,6 +892,16 @@ void MeshManager::device_update_mesh(Device *device, DeviceScene *dscene, Scene
 	size_t curve_size = 0;
 
 	foreach(Mesh *mesh, scene->meshes) {
+		if(mesh->shared_mesh) {
+			/* shared meshes always come after the mesh they share data with */
+			mesh->vert_offset = mesh->shared_mesh->vert_offset;
+			mesh->tri_offset = mesh->shared_mesh->tri_offset;
+
+			mesh->curvekey_offset = mesh->shared_mesh->curvekey_offset;
+			mesh->curve_offset = mesh->shared_mesh->curve_offset;
+			continue;
+		}
+
 		mesh->vert_offset = vert_size;
 		mesh->tri_offset = tri_size;
 
@@ -784,6 +925,9 @@ void MeshManager::device_update_mesh(Device *device, DeviceScene *dscene, Scene
 		float4 *tri_vindex = dscene->tri_vindex.resize(tri_size);
 
 		foreach(Mesh *mesh, scene->meshes) {
+			if(mesh->shared_mesh)
+				continue;
+
 			mesh->pack_normals(scene, &normal[mesh->tri_offset], &vnormal[mesh->vert_offset]);
 			mesh->pack_verts(&tri_verts[mesh->vert_offset], &tri_vindex[mesh->tri_offset], mesh->vert_offset);
 
@@ -806,6 +950,9 @@ void MeshManager::device_update_mesh(Device *device, DeviceScene *dscene, Scene
 		float4 *curves = dscene->curves.resize(curve_size);
 
 		foreach(Mesh *mesh, scene->meshes) {
+			if(mesh->shared_mesh)
+				continue;
+
 			mesh->pack_curves(scene, &curve_keys[mesh->curvekey_offset], &curves[mesh->curve_offset], mesh->curvekey_offset);
 			if(progress.get_cancel()) return;
 		}
@@ -815,22 +962,46 @@ void MeshManager::device_update_mesh(Device *device, DeviceScene *dscene, Scene
 	}
 }
 
-void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
+void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, bool refit, Progress& progress)
 {
-	/* bvh build */
-	progress.set_status("Updating Scene BVH", "Building");
+	if(refit) {
+		/* bvh refit */
+		progress.set_status("Updating Scene BVH", "Refitting");
 
-	BVHParams bparams;
-	bparams.top_level = true;
-	bparams.use_qbvh = scene->params.use_qbvh;
-	bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
-	bparams.use_cache = scene->params.use_bvh_cache;
+		bvh->objects = scene->objects;
+		bvh->refit(progress);
 
-	delete bvh;
-	bvh = BVH::create(bparams, scene->objects);
-	bvh->build(progress);
+		if(progress.get_cancel()) return;
 
-	if(progress.get_cancel()) return;
+		/* rebuild once objects moved so much that the refitted BVH is
+		 * considerably slower to traverse than a new one */
+		if(bvh->pack.SAH > bvh_build_SAH*BVH_REFIT_MAX_SAH_RATIO)
+			refit = false;
+	}
+
+	if(!refit) {
+		/* bvh build */
+		progress.set_status("Updating Scene BVH", "Building");
+
+		BVHParams bparams;
+		bparams.top_level = true;
+		bparams.use_qbvh = scene->params.use_qbvh;
+		bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
+		bparams.use_cache = scene->params.use_bvh_cache;
+
+		bvh_meshes.clear();
+
+		delete bvh;
+		bvh = BVH::create(bparams, scene->objects);
+		bvh->build(progress);
+
+		if(progress.get_cancel()) return;
+
+		foreach(Object *object, scene->objects)
+			bvh_meshes.push_back(object->mesh->get_shared_mesh());
+
+		bvh_build_SAH = bvh->pack.SAH;
+	}
 
 	/* copy to device */
 	progress.set_status("Updating Scene BVH", "Copying BVH to device");
@@ -867,6 +1038,7 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	}
 
 	dscene->data.bvh.root = pack.root_index;
+	dscene->data.bvh.use_qbvh = scene->params.use_qbvh;
 }
 
 void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
@@ -898,11 +1070,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	if(progress.get_cancel()) return;
 
 	/* update displacement */
-	bool displacement_done = false;
-
-	foreach(Mesh *mesh, scene->meshes)
-		if(mesh->need_update && displace(device, dscene, scene, mesh, progress))
-			displacement_done = true;
+	bool displacement_done = displace(device, dscene, scene, progress);
 
 	/* todo: properly handle cancel halfway displacement */
 	if(progress.get_cancel()) return;
@@ -920,10 +1088,29 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	/* update bvh */
 	size_t i = 0, num_bvh = 0;
+	bool mesh_bvh_rebuild = false;
+
+	foreach(Mesh *mesh, scene->meshes) {
+		if(mesh->need_update && !mesh->transform_applied && !mesh->shared_mesh) {
+			if(mesh->need_update_rebuild || !mesh->bvh)
+				mesh_bvh_rebuild = true;
 
-	foreach(Mesh *mesh, scene->meshes)
-		if(mesh->need_update && !mesh->transform_applied)
 			num_bvh++;
+		}
+	}
+
+	/* the top level BVH can be refitted if the objects and the layout of
+	 * the instanced BVH's stay the same, as is the case when only object
+	 * transforms and deformations change, like during animation playback.
+	 * with static BVH transforms are applied, so it is always rebuilt. */
+	bool refit_bvh = bvh && !mesh_bvh_rebuild &&
+		scene->params.bvh_type == SceneParams::BVH_DYNAMIC &&
+		bvh->objects == scene->objects &&
+		bvh_meshes.size() == scene->objects.size();
+
+	for(size_t j = 0; refit_bvh && j < scene->objects.size(); j++)
+		if(scene->objects[j]->mesh->get_shared_mesh() != bvh_meshes[j])
+			refit_bvh = false;
 
 	TaskPool pool;
 
@@ -952,7 +1139,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	if(progress.get_cancel()) return;
 
-	device_update_bvh(device, dscene, scene, progress);
+	device_update_bvh(device, dscene, scene, refit_bvh, progress);
 
 	need_update = false;
 }
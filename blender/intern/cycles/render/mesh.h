@@ -24,6 +24,7 @@
 #include "util_list.h"
 #include "util_map.h"
 #include "util_param.h"
+#include "util_string.h"
 #include "util_transform.h"
 #include "util_types.h"
 #include "util_vector.h"
@@ -102,6 +103,10 @@ public:
 	size_t curve_offset;
 	size_t curvekey_offset;
 
+	/* Identical Meshes */
+	Mesh *shared_mesh;
+	string content_hash;
+
 	/* Functions */
 	Mesh();
 	~Mesh();
@@ -121,6 +126,8 @@ public:
 	void pack_verts(float4 *tri_verts, float4 *tri_vindex, size_t vert_offset);
 	void pack_curves(Scene *scene, float4 *curve_key_co, float4 *curve_data, size_t curvekey_offset);
 	void compute_bvh(SceneParams *params, Progress *progress, int n, int total);
+	void compute_content_hash();
+	Mesh *get_shared_mesh();
 
 	bool need_attribute(Scene *scene, AttributeStandard std);
 	bool need_attribute(Scene *scene, ustring name);
@@ -134,22 +141,30 @@ class MeshManager {
 public:
 	BVH *bvh;
 
+	/* meshes used by the objects in the top level BVH, and its SAH cost at
+	 * the last full build, to decide if it can be refitted instead */
+	vector<Mesh*> bvh_meshes;
+	float bvh_build_SAH;
+
 	bool need_update;
 
 	MeshManager();
 	~MeshManager();
 
-	bool displace(Device *device, DeviceScene *dscene, Scene *scene, Mesh *mesh, Progress& progress);
+	/* apply displacement shaders of all meshes that need an update */
+	bool displace(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 
 	/* attributes */
 	void update_osl_attributes(Device *device, Scene *scene, vector<AttributeRequestSet>& mesh_attributes);
 	void update_svm_attributes(Device *device, DeviceScene *dscene, Scene *scene, vector<AttributeRequestSet>& mesh_attributes);
 
+	void update_shared_meshes(Scene *scene, Progress& progress);
+
 	void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_object(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_mesh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_attributes(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
-	void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
+	void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, bool refit, Progress& progress);
 	void device_free(Device *device, DeviceScene *dscene);
 
 	void tag_update(Scene *scene);
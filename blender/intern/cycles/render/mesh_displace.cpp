@@ -22,42 +22,38 @@
 #include "shader.h"
 
 #include "util_foreach.h"
+#include "util_map.h"
 #include "util_progress.h"
 
 CCL_NAMESPACE_BEGIN
 
-bool MeshManager::displace(Device *device, DeviceScene *dscene, Scene *scene, Mesh *mesh, Progress& progress)
-{
-	/* verify if we have a displacement shader */
-	bool has_displacement = false;
-
-	if(mesh->displacement_method != Mesh::DISPLACE_BUMP) {
-		foreach(uint sindex, mesh->used_shaders)
-			if(scene->shaders[sindex]->has_displacement)
-				has_displacement = true;
-	}
-	
-	if(!has_displacement)
-		return false;
+/* Displacement
+ *
+ * Displacement of all meshes is evaluated in one batch. Vertices of all
+ * displaced meshes are gathered into a single shader evaluation input, which
+ * is evaluated in chunks that the device splits over its threads or devices,
+ * with progress reported and cancel checked in between. */
 
-	string msg = string_printf("Computing Displacement %s", mesh->name.c_str());
-	progress.set_status("Updating Mesh", msg);
+#define DISPLACE_CHUNK_SIZE (64*1024)
 
-	/* find object index. todo: is arbitrary */
-	size_t object_index = ~0;
+static bool mesh_has_displacement(Scene *scene, Mesh *mesh)
+{
+	if(mesh->displacement_method == Mesh::DISPLACE_BUMP)
+		return false;
 
-	for(size_t i = 0; i < scene->objects.size(); i++) {
-		if(scene->objects[i]->mesh == mesh) {
-			object_index = i;
-			break;
-		}
-	}
+	foreach(uint sindex, mesh->used_shaders)
+		if(scene->shaders[sindex]->has_displacement)
+			return true;
+	
+	return false;
+}
 
-	/* setup input for device task */
+/* visit displaced vertices of mesh in the order used for shader input and
+ * output, calling func(vertex, triangle, corner) once for each vertex */
+template<typename Func>
+static void mesh_foreach_displaced_vert(Scene *scene, Mesh *mesh, Func func)
+{
 	vector<bool> done(mesh->verts.size(), false);
-	device_vector<uint4> d_input;
-	uint4 *d_input_data = d_input.resize(mesh->verts.size());
-	size_t d_input_size = 0;
 
 	for(size_t i = 0; i < mesh->triangles.size(); i++) {
 		Mesh::Triangle t = mesh->triangles[i];
@@ -71,32 +67,93 @@ bool MeshManager::displace(Device *device, DeviceScene *dscene, Scene *scene, Me
 				continue;
 
 			done[t.v[j]] = true;
+			func(t.v[j], i, j);
+		}
+	}
+}
 
-			/* set up object, primitive and barycentric coordinates */
-			/* when used, non-instanced convention: object = ~object */
-			int object = ~object_index;
-			int prim = mesh->tri_offset + i;
-			float u, v;
-			
-			switch (j) {
-				case 0:
-					u = 1.0f;
-					v = 0.0f;
-					break;
-				case 1:
-					u = 0.0f;
-					v = 1.0f;
-					break;
-				default:
-					u = 0.0f;
-					v = 0.0f;
-					break;
-			}
-
-			/* back */
-			uint4 in = make_uint4(object, prim, __float_as_int(u), __float_as_int(v));
-			d_input_data[d_input_size++] = in;
+struct DisplaceInput {
+	uint4 *data;
+	size_t *size;
+	int object;
+	size_t tri_offset;
+
+	void operator()(int vert, size_t tri, int corner)
+	{
+		/* set up object, primitive and barycentric coordinates */
+		int prim = tri_offset + tri;
+		float u, v;
+		
+		switch (corner) {
+			case 0:
+				u = 1.0f;
+				v = 0.0f;
+				break;
+			case 1:
+				u = 0.0f;
+				v = 1.0f;
+				break;
+			default:
+				u = 0.0f;
+				v = 0.0f;
+				break;
 		}
+
+		data[(*size)++] = make_uint4(object, prim, __float_as_int(u), __float_as_int(v));
+	}
+};
+
+struct DisplaceOutput {
+	Mesh *mesh;
+	float4 *offset;
+	size_t *k;
+
+	void operator()(int vert, size_t tri, int corner)
+	{
+		mesh->verts[vert] += float4_to_float3(offset[(*k)++]);
+	}
+};
+
+bool MeshManager::displace(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
+{
+	/* find meshes with a displacement shader */
+	vector<Mesh*> meshes;
+	size_t num_verts = 0;
+
+	foreach(Mesh *mesh, scene->meshes) {
+		if(mesh->need_update && mesh_has_displacement(scene, mesh)) {
+			meshes.push_back(mesh);
+			num_verts += mesh->verts.size();
+		}
+	}
+
+	if(meshes.size() == 0)
+		return false;
+
+	progress.set_status("Updating Mesh", "Computing Displacement");
+
+	/* find object index for each mesh. todo: is arbitrary */
+	map<Mesh*, size_t> object_index;
+
+	for(size_t i = scene->objects.size(); i > 0; i--)
+		object_index[scene->objects[i-1]->mesh] = i-1;
+
+	/* setup input for device task, for all meshes */
+	device_vector<uint4> d_input;
+	uint4 *d_input_data = d_input.resize(num_verts);
+	size_t d_input_size = 0;
+
+	foreach(Mesh *mesh, meshes) {
+		map<Mesh*, size_t>::iterator it = object_index.find(mesh);
+
+		DisplaceInput input;
+		input.data = d_input_data;
+		input.size = &d_input_size;
+		/* when used, non-instanced convention: object = ~object */
+		input.object = ~((it != object_index.end())? it->second: ~0);
+		input.tri_offset = mesh->tri_offset;
+
+		mesh_foreach_displaced_vert(scene, mesh, input);
 	}
 
 	if(d_input_size == 0)
@@ -113,17 +170,33 @@ bool MeshManager::displace(Device *device, DeviceScene *dscene, Scene *scene, Me
 	device->mem_copy_to(d_input);
 	device->mem_alloc(d_output, MEM_WRITE_ONLY);
 
-	DeviceTask task(DeviceTask::SHADER);
-	task.shader_input = d_input.device_pointer;
-	task.shader_output = d_output.device_pointer;
-	task.shader_eval_type = SHADER_EVAL_DISPLACE;
-	task.shader_x = 0;
-	task.shader_w = d_output.size();
+	DeviceTask main_task(DeviceTask::SHADER);
+	main_task.shader_input = d_input.device_pointer;
+	main_task.shader_output = d_output.device_pointer;
+	main_task.shader_eval_type = SHADER_EVAL_DISPLACE;
+	main_task.shader_x = 0;
+	main_task.shader_w = d_output.size();
+
+	list<DeviceTask> split_tasks;
+	main_task.split_max_size(split_tasks, DISPLACE_CHUNK_SIZE);
+
+	size_t num_done = 0;
+
+	foreach(DeviceTask& task, split_tasks) {
+		string msg = string_printf("Computing Displacement %d/%d vertices",
+			(int)num_done, (int)d_input_size);
+		progress.set_status("Updating Mesh", msg);
 
-	device->task_add(task);
-	device->task_wait();
+		device->task_add(task);
+		device->task_wait();
+		device->mem_copy_from(d_output, task.shader_x, 1, task.shader_w, sizeof(float4));
+
+		num_done += task.shader_w;
+
+		if(progress.get_cancel())
+			break;
+	}
 
-	device->mem_copy_from(d_output, 0, 1, d_output.size(), sizeof(float4));
 	device->mem_free(d_input);
 	device->mem_free(d_output);
 
@@ -131,40 +204,30 @@ bool MeshManager::displace(Device *device, DeviceScene *dscene, Scene *scene, Me
 		return false;
 
 	/* read result */
-	done.clear();
-	done.resize(mesh->verts.size(), false);
-	int k = 0;
-
 	float4 *offset = (float4*)d_output.data_pointer;
-
-	for(size_t i = 0; i < mesh->triangles.size(); i++) {
-		Mesh::Triangle t = mesh->triangles[i];
-		Shader *shader = scene->shaders[mesh->shader[i]];
-
-		if(!shader->has_displacement)
-			continue;
-
-		for(int j = 0; j < 3; j++) {
-			if(!done[t.v[j]]) {
-				done[t.v[j]] = true;
-				float3 off = float4_to_float3(offset[k++]);
-				mesh->verts[t.v[j]] += off;
-			}
+	size_t k = 0;
+
+	foreach(Mesh *mesh, meshes) {
+		DisplaceOutput output;
+		output.mesh = mesh;
+		output.offset = offset;
+		output.k = &k;
+
+		mesh_foreach_displaced_vert(scene, mesh, output);
+
+		/* for displacement method both, we only need to recompute the face
+		 * normals, as bump mapping in the shader will already alter the
+		 * vertex normal, so we start from the non-displaced vertex normals
+		 * to avoid applying the perturbation twice. */
+		mesh->attributes.remove(ATTR_STD_FACE_NORMAL);
+		mesh->add_face_normals();
+
+		if(mesh->displacement_method == Mesh::DISPLACE_TRUE) {
+			mesh->attributes.remove(ATTR_STD_VERTEX_NORMAL);
+			mesh->add_vertex_normals();
 		}
 	}
 
-	/* for displacement method both, we only need to recompute the face
-	 * normals, as bump mapping in the shader will already alter the
-	 * vertex normal, so we start from the non-displaced vertex normals
-	 * to avoid applying the perturbation twice. */
-	mesh->attributes.remove(ATTR_STD_FACE_NORMAL);
-	mesh->add_face_normals();
-
-	if(mesh->displacement_method == Mesh::DISPLACE_TRUE) {
-		mesh->attributes.remove(ATTR_STD_VERTEX_NORMAL);
-		mesh->add_vertex_normals();
-	}
-
 	return true;
 }
 
@@ -17,6 +17,8 @@
 #include "image.h"
 #include "nodes.h"
 #include "svm.h"
+#include "svm_color_util.h"
+#include "svm_math_util.h"
 #include "osl.h"
 #include "sky_model.h"
 
@@ -1311,6 +1313,42 @@ ConvertNode::ConvertNode(ShaderSocketType from_, ShaderSocketType to_, bool auto
 		assert(0);
 }
 
+bool ConvertNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	ShaderInput *in = inputs[0];
+
+	if(in->link || from == SHADER_SOCKET_STRING || to == SHADER_SOCKET_STRING)
+		return false;
+
+	/* same conversions as svm_node_convert */
+	float3 value = in->value;
+	float f;
+
+	if(from == SHADER_SOCKET_FLOAT || from == SHADER_SOCKET_INT)
+		f = value.x;
+	else if(from == SHADER_SOCKET_COLOR)
+		f = linear_rgb_to_gray(value);
+	else
+		f = (value.x + value.y + value.z)*(1.0f/3.0f);
+
+	if(to == SHADER_SOCKET_FLOAT)
+		*optimized_value = make_float3(f, 0.0f, 0.0f);
+	else if(to == SHADER_SOCKET_INT)
+		*optimized_value = make_float3((float)(int)f, 0.0f, 0.0f);
+	else if(from == SHADER_SOCKET_FLOAT || from == SHADER_SOCKET_INT)
+		*optimized_value = make_float3(f, f, f);
+	else
+		*optimized_value = value;
+
+	return true;
+}
+
+bool ConvertNode::equals(const ShaderNode *other)
+{
+	const ConvertNode *node = static_cast<const ConvertNode*>(other);
+	return from == node->from && to == node->to;
+}
+
 void ConvertNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *in = inputs[0];
@@ -2148,6 +2186,12 @@ TextureCoordinateNode::TextureCoordinateNode()
 	from_dupli = false;
 }
 
+bool TextureCoordinateNode::equals(const ShaderNode *other)
+{
+	const TextureCoordinateNode *node = static_cast<const TextureCoordinateNode*>(other);
+	return from_dupli == node->from_dupli;
+}
+
 void TextureCoordinateNode::attributes(AttributeRequestSet *attributes)
 {
 	if(!from_dupli) {
@@ -2613,6 +2657,17 @@ ValueNode::ValueNode()
 	add_output("Value", SHADER_SOCKET_FLOAT);
 }
 
+bool ValueNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	*optimized_value = make_float3(value, 0.0f, 0.0f);
+	return true;
+}
+
+bool ValueNode::equals(const ShaderNode *other)
+{
+	return value == static_cast<const ValueNode*>(other)->value;
+}
+
 void ValueNode::compile(SVMCompiler& compiler)
 {
 	ShaderOutput *val_out = output("Value");
@@ -2637,6 +2692,18 @@ ColorNode::ColorNode()
 	add_output("Color", SHADER_SOCKET_COLOR);
 }
 
+bool ColorNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	*optimized_value = value;
+	return true;
+}
+
+bool ColorNode::equals(const ShaderNode *other)
+{
+	const ColorNode *node = static_cast<const ColorNode*>(other);
+	return value.x == node->value.x && value.y == node->value.y && value.z == node->value.z;
+}
+
 void ColorNode::compile(SVMCompiler& compiler)
 {
 	ShaderOutput *color_out = output("Color");
@@ -2741,6 +2808,21 @@ InvertNode::InvertNode()
 	add_output("Color",  SHADER_SOCKET_COLOR);
 }
 
+bool InvertNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	ShaderInput *fac_in = input("Fac");
+	ShaderInput *color_in = input("Color");
+
+	if(fac_in->link || color_in->link)
+		return false;
+
+	float fac = fac_in->value.x;
+	float3 color = color_in->value;
+
+	*optimized_value = fac*(make_float3(1.0f, 1.0f, 1.0f) - color) + (1.0f - fac)*color;
+	return true;
+}
+
 void InvertNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *fac_in = input("Fac");
@@ -2774,6 +2856,45 @@ MixNode::MixNode()
 	add_output("Color",  SHADER_SOCKET_COLOR);
 }
 
+bool MixNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	ShaderInput *fac_in = input("Fac");
+	ShaderInput *color1_in = input("Color1");
+	ShaderInput *color2_in = input("Color2");
+
+	if(fac_in->link)
+		return false;
+
+	NodeMix mix_type = (NodeMix)type_enum[type];
+	float fac = fac_in->value.x;
+	float3 color;
+
+	if(!color1_in->link && !color2_in->link) {
+		color = svm_mix(mix_type, fac, color1_in->value, color2_in->value);
+	}
+	else if(mix_type == NODE_MIX_BLEND && fac <= 0.0f && !color1_in->link) {
+		/* other input is not used */
+		color = color1_in->value;
+	}
+	else if(mix_type == NODE_MIX_BLEND && fac >= 1.0f && !color2_in->link) {
+		color = color2_in->value;
+	}
+	else
+		return false;
+
+	if(use_clamp)
+		color = svm_mix_clamp(color);
+
+	*optimized_value = color;
+	return true;
+}
+
+bool MixNode::equals(const ShaderNode *other)
+{
+	const MixNode *node = static_cast<const MixNode*>(other);
+	return type == node->type && use_clamp == node->use_clamp;
+}
+
 static ShaderEnum mix_type_init()
 {
 	ShaderEnum enm;
@@ -2840,6 +2961,19 @@ CombineRGBNode::CombineRGBNode()
 	add_output("Image", SHADER_SOCKET_COLOR);
 }
 
+bool CombineRGBNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	ShaderInput *r_in = input("R");
+	ShaderInput *g_in = input("G");
+	ShaderInput *b_in = input("B");
+
+	if(r_in->link || g_in->link || b_in->link)
+		return false;
+
+	*optimized_value = make_float3(r_in->value.x, g_in->value.x, b_in->value.x);
+	return true;
+}
+
 void CombineRGBNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *red_in = input("R");
@@ -2904,6 +3038,28 @@ GammaNode::GammaNode()
 	add_output("Color", SHADER_SOCKET_COLOR);
 }
 
+bool GammaNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	ShaderInput *color_in = input("Color");
+	ShaderInput *gamma_in = input("Gamma");
+
+	if(color_in->link || gamma_in->link)
+		return false;
+
+	float3 color = color_in->value;
+	float gamma = gamma_in->value.x;
+
+	if(color.x > 0.0f)
+		color.x = powf(color.x, gamma);
+	if(color.y > 0.0f)
+		color.y = powf(color.y, gamma);
+	if(color.z > 0.0f)
+		color.z = powf(color.z, gamma);
+
+	*optimized_value = color;
+	return true;
+}
+
 void GammaNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *color_in = input("Color");
@@ -2932,6 +3088,27 @@ BrightContrastNode::BrightContrastNode()
 	add_output("Color", SHADER_SOCKET_COLOR);
 }
 
+bool BrightContrastNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	ShaderInput *color_in = input("Color");
+	ShaderInput *bright_in = input("Bright");
+	ShaderInput *contrast_in = input("Contrast");
+
+	if(color_in->link || bright_in->link || contrast_in->link)
+		return false;
+
+	float3 color = color_in->value;
+	float a = 1.0f + contrast_in->value.x;
+	float b = bright_in->value.x - contrast_in->value.x*0.5f;
+
+	color.x = max(a*color.x + b, 0.0f);
+	color.y = max(a*color.y + b, 0.0f);
+	color.z = max(a*color.z + b, 0.0f);
+
+	*optimized_value = color;
+	return true;
+}
+
 void BrightContrastNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *color_in = input("Color");
@@ -2964,6 +3141,20 @@ SeparateRGBNode::SeparateRGBNode()
 	add_output("B", SHADER_SOCKET_FLOAT);
 }
 
+bool SeparateRGBNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	ShaderInput *color_in = input("Image");
+
+	if(color_in->link)
+		return false;
+
+	float3 color = color_in->value;
+	float value = (socket == output("R"))? color.x: (socket == output("G"))? color.y: color.z;
+
+	*optimized_value = make_float3(value, 0.0f, 0.0f);
+	return true;
+}
+
 void SeparateRGBNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *color_in = input("Image");
@@ -3069,6 +3260,11 @@ AttributeNode::AttributeNode()
 	add_output("Fac",  SHADER_SOCKET_FLOAT);
 }
 
+bool AttributeNode::equals(const ShaderNode *other)
+{
+	return attribute == static_cast<const AttributeNode*>(other)->attribute;
+}
+
 void AttributeNode::attributes(AttributeRequestSet *attributes)
 {
 	ShaderOutput *color_out = output("Color");
@@ -3340,6 +3536,29 @@ MathNode::MathNode()
 	add_output("Value",  SHADER_SOCKET_FLOAT);
 }
 
+bool MathNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	ShaderInput *value1_in = input("Value1");
+	ShaderInput *value2_in = input("Value2");
+
+	if(value1_in->link || value2_in->link)
+		return false;
+
+	float value = svm_math((NodeMath)type_enum[type], value1_in->value.x, value2_in->value.x);
+
+	if(use_clamp)
+		value = svm_math(NODE_MATH_CLAMP, value, 0.0f);
+
+	*optimized_value = make_float3(value, 0.0f, 0.0f);
+	return true;
+}
+
+bool MathNode::equals(const ShaderNode *other)
+{
+	const MathNode *node = static_cast<const MathNode*>(other);
+	return type == node->type && use_clamp == node->use_clamp;
+}
+
 static ShaderEnum math_type_init()
 {
 	ShaderEnum enm;
@@ -3407,6 +3626,32 @@ VectorMathNode::VectorMathNode()
 	add_output("Vector",  SHADER_SOCKET_VECTOR);
 }
 
+bool VectorMathNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	ShaderInput *vector1_in = input("Vector1");
+	ShaderInput *vector2_in = input("Vector2");
+
+	if(vector1_in->link || vector2_in->link)
+		return false;
+
+	float value;
+	float3 vector;
+
+	svm_vector_math(&value, &vector, (NodeVectorMath)type_enum[type], vector1_in->value, vector2_in->value);
+
+	if(socket == output("Value"))
+		*optimized_value = make_float3(value, 0.0f, 0.0f);
+	else
+		*optimized_value = vector;
+
+	return true;
+}
+
+bool VectorMathNode::equals(const ShaderNode *other)
+{
+	return type == static_cast<const VectorMathNode*>(other)->type;
+}
+
 static ShaderEnum vector_math_type_init()
 {
 	ShaderEnum enm;
@@ -3647,6 +3892,36 @@ RGBRampNode::RGBRampNode()
 	interpolate = true;
 }
 
+bool RGBRampNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	ShaderInput *fac_in = input("Fac");
+
+	if(fac_in->link)
+		return false;
+
+	/* same lookup as rgb_ramp_lookup */
+	float f = clamp(fac_in->value.x, 0.0f, 1.0f)*(RAMP_TABLE_SIZE-1);
+	int i = clamp(float_to_int(f), 0, RAMP_TABLE_SIZE-1);
+	float t = f - (float)i;
+	float4 a = ramp[i];
+
+	if(interpolate && t > 0.0f)
+		a = (1.0f - t)*a + t*ramp[i+1];
+
+	if(socket == output("Color"))
+		*optimized_value = make_float3(a.x, a.y, a.z);
+	else
+		*optimized_value = make_float3(a.w, 0.0f, 0.0f);
+
+	return true;
+}
+
+bool RGBRampNode::equals(const ShaderNode *other)
+{
+	const RGBRampNode *node = static_cast<const RGBRampNode*>(other);
+	return interpolate == node->interpolate && memcmp(ramp, node->ramp, sizeof(ramp)) == 0;
+}
+
 void RGBRampNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *fac_in = input("Fac");
@@ -189,6 +189,8 @@ class ConvertNode : public ShaderNode {
 public:
 	ConvertNode(ShaderSocketType from, ShaderSocketType to, bool autoconvert = false);
 	SHADER_NODE_BASE_CLASS(ConvertNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode *other);
 
 	ShaderSocketType from, to;
 };
@@ -336,12 +338,14 @@ public:
 class GeometryNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(GeometryNode)
+	bool equals(const ShaderNode * /*other*/) { return true; }
 	void attributes(AttributeRequestSet *attributes);
 };
 
 class TextureCoordinateNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(TextureCoordinateNode)
+	bool equals(const ShaderNode *other);
 	void attributes(AttributeRequestSet *attributes);
 	
 	bool from_dupli;
@@ -350,6 +354,7 @@ public:
 class LightPathNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(LightPathNode)
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class LightFalloffNode : public ShaderNode {
@@ -360,6 +365,7 @@ public:
 class ObjectInfoNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(ObjectInfoNode)
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class ParticleInfoNode : public ShaderNode {
@@ -378,6 +384,8 @@ public:
 class ValueNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(ValueNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode *other);
 
 	float value;
 };
@@ -385,6 +393,8 @@ public:
 class ColorNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(ColorNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode *other);
 
 	float3 value;
 };
@@ -407,11 +417,15 @@ public:
 class InvertNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(InvertNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class MixNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(MixNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode *other);
 
 	bool use_clamp;
 
@@ -422,41 +436,53 @@ public:
 class CombineRGBNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(CombineRGBNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class CombineHSVNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(CombineHSVNode)
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class GammaNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(GammaNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class BrightContrastNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(BrightContrastNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class SeparateRGBNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(SeparateRGBNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class SeparateHSVNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(SeparateHSVNode)
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class HSVNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(HSVNode)
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class AttributeNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(AttributeNode)
+	bool equals(const ShaderNode *other);
 	void attributes(AttributeRequestSet *attributes);
 
 	ustring attribute;
@@ -465,16 +491,19 @@ public:
 class CameraNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(CameraNode)
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class FresnelNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(FresnelNode)
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class LayerWeightNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(LayerWeightNode)
+	bool equals(const ShaderNode * /*other*/) { return true; }
 };
 
 class WireframeNode : public ShaderNode {
@@ -499,6 +528,8 @@ public:
 class MathNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(MathNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode *other);
 
 	bool use_clamp;
 
@@ -516,6 +547,8 @@ public:
 class VectorMathNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(VectorMathNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode *other);
 
 	ustring type;
 	static ShaderEnum type_enum;
@@ -554,6 +587,8 @@ public:
 class RGBRampNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(RGBRampNode)
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	bool equals(const ShaderNode *other);
 	float4 ramp[RAMP_TABLE_SIZE];
 	bool interpolate;
 };
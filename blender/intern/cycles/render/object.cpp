@@ -363,10 +363,12 @@ void ObjectManager::apply_static_transforms(DeviceScene *dscene, Scene *scene, u
 	bool have_instancing = false;
 
 	foreach(Object *object, scene->objects) {
-		map<Mesh*, int>::iterator it = mesh_users.find(object->mesh);
+		/* meshes sharing data count as users of the same mesh */
+		Mesh *mesh = object->mesh->get_shared_mesh();
+		map<Mesh*, int>::iterator it = mesh_users.find(mesh);
 
 		if(it == mesh_users.end())
-			mesh_users[object->mesh] = 1;
+			mesh_users[mesh] = 1;
 		else
 			it->second++;
 	}
@@ -375,7 +377,7 @@ void ObjectManager::apply_static_transforms(DeviceScene *dscene, Scene *scene, u
 
 	/* apply transforms for objects with single user meshes */
 	foreach(Object *object, scene->objects) {
-		if(mesh_users[object->mesh] == 1) {
+		if(mesh_users[object->mesh->get_shared_mesh()] == 1) {
 			if(!(motion_blur && object->use_motion)) {
 				if(!object->mesh->transform_applied) {
 					object->apply_transform();
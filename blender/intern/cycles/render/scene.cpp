@@ -61,8 +61,12 @@ Scene::Scene(const SceneParams& params_, const DeviceInfo& device_info_)
 	else
 		shader_manager = ShaderManager::create(this, SceneParams::SVM);
 
-	if (device_info_.type == DEVICE_CPU)
+	if (device_info_.type == DEVICE_CPU) {
 		image_manager->set_extended_image_limits();
+
+		/* out of core image textures are only supported on the CPU */
+		image_manager->set_texture_cache_size(params.texture_cache_size);
+	}
 }
 
 Scene::~Scene()
@@ -141,6 +145,7 @@ void Scene::device_update(Device *device_, Progress& progress)
 	 */
 	
 	image_manager->set_pack_images(device->info.pack_images);
+	image_manager->set_compact_images(device->info.compact_images);
 
 	progress.set_status("Updating Background");
 	background->device_update(device, &dscene, this);
@@ -162,6 +167,11 @@ void Scene::device_update(Device *device_, Progress& progress)
 
 	if(progress.get_cancel()) return;
 
+	progress.set_status("Updating Meshes", "Finding identical meshes");
+	mesh_manager->update_shared_meshes(this, progress);
+
+	if(progress.get_cancel()) return;
+
 	progress.set_status("Updating Objects");
 	object_manager->device_update(device, &dscene, this, progress);
 
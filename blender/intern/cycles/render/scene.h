@@ -88,6 +88,8 @@ public:
 	device_vector<float4> light_data;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
+	device_vector<float4> light_tree_nodes;
+	device_vector<uint> light_tree_emitters;
 
 	/* particles */
 	device_vector<float4> particles;
@@ -107,6 +109,12 @@ public:
 	device_vector<uchar4> tex_image[TEX_EXTENDED_NUM_IMAGES];
 	device_vector<float4> tex_float_image[TEX_EXTENDED_NUM_FLOAT_IMAGES];
 
+	/* compact images, single channel and half float */
+	device_vector<uchar> tex_image_grey[TEX_EXTENDED_NUM_IMAGES];
+	device_vector<float> tex_float_image_grey[TEX_EXTENDED_NUM_FLOAT_IMAGES];
+	device_vector<half4> tex_half_image[TEX_EXTENDED_NUM_FLOAT_IMAGES];
+	device_vector<half> tex_half_image_grey[TEX_EXTENDED_NUM_FLOAT_IMAGES];
+
 	/* opencl images */
 	device_vector<uchar4> tex_image_packed;
 	device_vector<uint4> tex_image_packed_info;
@@ -124,6 +132,7 @@ public:
 	bool use_bvh_spatial_split;
 	bool use_qbvh;
 	bool persistent_data;
+	int texture_cache_size;
 
 	SceneParams()
 	{
@@ -131,12 +140,9 @@ public:
 		bvh_type = BVH_DYNAMIC;
 		use_bvh_cache = false;
 		use_bvh_spatial_split = false;
-#ifdef __QBVH__
-		use_qbvh = true;
-#else
 		use_qbvh = false;
-#endif
 		persistent_data = false;
+		texture_cache_size = 0;
 	}
 
 	bool modified(const SceneParams& params)
@@ -145,7 +151,8 @@ public:
 		&& use_bvh_cache == params.use_bvh_cache
 		&& use_bvh_spatial_split == params.use_bvh_spatial_split
 		&& use_qbvh == params.use_qbvh
-		&& persistent_data == params.persistent_data); }
+		&& persistent_data == params.persistent_data
+		&& texture_cache_size == params.texture_cache_size); }
 };
 
 /* Scene */
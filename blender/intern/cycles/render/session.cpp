@@ -14,11 +14,13 @@
  * limitations under the License
  */
 
+#include <float.h>
 #include <string.h>
 #include <limits.h>
 
 #include "buffers.h"
 #include "camera.h"
+#include "checkpoint.h"
 #include "device.h"
 #include "integrator.h"
 #include "scene.h"
@@ -28,11 +30,27 @@
 #include "util_function.h"
 #include "util_math.h"
 #include "util_opengl.h"
+#include "util_path.h"
 #include "util_task.h"
 #include "util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
+/* number of threads and devices acquiring tiles at the same time */
+static int session_num_tile_workers(const DeviceInfo& info)
+{
+	if(info.multi_devices.size()) {
+		int num_workers = 0;
+
+		foreach(const DeviceInfo& subinfo, info.multi_devices)
+			num_workers += session_num_tile_workers(subinfo);
+
+		return num_workers;
+	}
+
+	return (info.type == DEVICE_CPU)? TaskScheduler::num_threads(): 1;
+}
+
 /* Note about  preserve_tile_device option for tile manager:
  * progressive refine and viewport rendering does requires tiles to
  * always be allocated for the same device
@@ -50,6 +68,16 @@ Session::Session(const SessionParams& params_)
 
 	device = Device::create(params.device, stats, params.background);
 
+	/* adaptive sampling only works when tiles are rendered to completion
+	 * one after the other, not for progressive or viewport rendering */
+	if(params.background && !params.progressive_refine && params.adaptive_threshold > 0.0f)
+		tile_manager.set_adaptive_sampling(params.adaptive_min_samples);
+
+	/* split the last tiles by samples so threads and devices don't go idle at
+	 * the end of the render, only for tiles that are written once when done */
+	else if(params.background && !params.progressive_refine && params.checkpoint_path == "")
+		tile_manager.set_tail_split(session_num_tile_workers(params.device));
+
 	if(params.background) {
 		buffers = NULL;
 		display = NULL;
@@ -61,6 +89,7 @@ Session::Session(const SessionParams& params_)
 
 	session_thread = NULL;
 	scene = NULL;
+	checkpoint = NULL;
 
 	start_time = 0.0;
 	reset_time = 0.0;
@@ -105,6 +134,7 @@ Session::~Session()
 	foreach(RenderBuffers *buffers, tile_buffers)
 		delete buffers;
 
+	delete checkpoint;
 	delete buffers;
 	delete display;
 	delete scene;
@@ -351,17 +381,25 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 	Tile tile;
 	int device_num = device->device_number(tile_device);
 
-	if(!tile_manager.next_tile(tile, device_num))
-		return false;
+	while(!tile_manager.next_tile(tile, device_num)) {
+		/* with adaptive sampling, tiles still being rendered by other threads
+		 * might be returned unconverged, so wait for them instead of stopping */
+		if(!tile_manager.busy_tiles() || progress.get_cancel())
+			return false;
+
+		tile_cond.wait(tile_lock);
+	}
 	
 	/* fill render tile */
 	rtile.x = tile_manager.state.buffer.full_x + tile.x;
 	rtile.y = tile_manager.state.buffer.full_y + tile.y;
 	rtile.w = tile.w;
 	rtile.h = tile.h;
-	rtile.start_sample = tile_manager.state.sample;
-	rtile.num_samples = tile_manager.state.num_samples;
+	rtile.start_sample = tile_manager.state.sample + tile.sample;
+	rtile.num_samples = tile.num_samples;
+	rtile.sample = rtile.start_sample;
 	rtile.resolution = tile_manager.state.resolution_divider;
+	rtile.tile_index = tile.index;
 
 	tile_lock.unlock();
 
@@ -389,9 +427,10 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 	buffer_params.get_offset_stride(rtile.offset, rtile.stride);
 
 	RenderBuffers *tilebuffers;
+	bool new_buffers = false;
 
 	/* allocate buffers */
-	if(params.progressive_refine) {
+	if(params.progressive_refine || tile_manager.adaptive_sampling()) {
 		tile_lock.lock();
 
 		if(tile_buffers.size() == 0)
@@ -403,6 +442,7 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 			tile_buffers[tile.index] = tilebuffers;
 
 			tilebuffers->reset(tile_device, buffer_params);
+			new_buffers = true;
 		}
 
 		tile_lock.unlock();
@@ -411,6 +451,17 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 		tilebuffers = new RenderBuffers(tile_device);
 
 		tilebuffers->reset(tile_device, buffer_params);
+		new_buffers = true;
+	}
+
+	/* tile resumed from checkpoint, continue with the stored samples or start
+	 * over if they can't be read */
+	if(checkpoint && new_buffers && tile.sample > 0) {
+		if(!checkpoint->read_tile(tile.index, tilebuffers)) {
+			rtile.start_sample = tile_manager.state.sample;
+			rtile.num_samples += tile.sample;
+			rtile.sample = rtile.start_sample;
+		}
 	}
 
 	rtile.buffer = tilebuffers->buffer.device_pointer;
@@ -428,8 +479,23 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 
 void Session::update_tile_sample(RenderTile& rtile)
 {
+	/* partially rendered tile, written at most once per checkpoint interval */
+	if(checkpoint && rtile.buffers) {
+		int x = rtile.x - tile_manager.state.buffer.full_x;
+		int y = rtile.y - tile_manager.state.buffer.full_y;
+
+		checkpoint->write_tile(rtile.tile_index, x, y, rtile.sample - tile_manager.state.sample, rtile.buffers, false);
+	}
+
 	thread_scoped_lock tile_lock(tile_mutex);
 
+	/* sample ranges of split tiles other than the first only contain part of
+	 * the samples, they are shown once added together */
+	if(tile_manager.tail_split() && rtile.start_sample != tile_manager.state.sample) {
+		update_status_time();
+		return;
+	}
+
 	if(update_render_tile_cb) {
 		if(params.progressive_refine == false) {
 			/* todo: optimize this by making it thread safe and removing lock */
@@ -443,8 +509,58 @@ void Session::update_tile_sample(RenderTile& rtile)
 
 void Session::release_tile(RenderTile& rtile)
 {
+	if(tile_manager.adaptive_sampling()) {
+		/* estimate error outside of the lock, it loops over all tile pixels */
+		float error = FLT_MAX;
+		bool converged = false;
+
+		if(rtile.buffers->copy_from_device() && rtile.buffers->get_sample_error(rtile.sample, &error)) {
+			int tile_samples = rtile.sample - tile_manager.state.sample;
+			converged = (tile_samples >= params.adaptive_min_samples && error < params.adaptive_threshold);
+		}
+
+		thread_scoped_lock tile_lock(tile_mutex);
+
+		bool finished = tile_manager.return_tile(rtile.tile_index, rtile.sample, error,
+		                                         converged || progress.get_cancel());
+
+		if(checkpoint) {
+			int x = rtile.x - tile_manager.state.buffer.full_x;
+			int y = rtile.y - tile_manager.state.buffer.full_y;
+
+			checkpoint->write_tile(rtile.tile_index, x, y, rtile.sample - tile_manager.state.sample, rtile.buffers, finished);
+		}
+
+		if(finished) {
+			if(write_render_tile_cb)
+				write_render_tile_cb(rtile);
+
+			tile_buffers[rtile.tile_index] = NULL;
+			delete rtile.buffers;
+		}
+
+		/* wake up threads waiting for a tile to become available */
+		tile_cond.notify_all();
+
+		update_status_time();
+
+		return;
+	}
+
+	if(tile_manager.tail_split()) {
+		release_tile_part(rtile);
+		return;
+	}
+
 	thread_scoped_lock tile_lock(tile_mutex);
 
+	if(checkpoint) {
+		int x = rtile.x - tile_manager.state.buffer.full_x;
+		int y = rtile.y - tile_manager.state.buffer.full_y;
+
+		checkpoint->write_tile(rtile.tile_index, x, y, rtile.sample - tile_manager.state.sample, rtile.buffers, true);
+	}
+
 	if(write_render_tile_cb) {
 		if(params.progressive_refine == false) {
 			/* todo: optimize this by making it thread safe and removing lock */
@@ -457,6 +573,61 @@ void Session::release_tile(RenderTile& rtile)
 	update_status_time();
 }
 
+void Session::release_tile_part(RenderTile& rtile)
+{
+	/* read back outside of the lock, to add to the other sample ranges */
+	rtile.buffers->copy_from_device();
+
+	thread_scoped_lock tile_lock(tile_mutex);
+
+	bool split;
+	int num_done_samples;
+	bool finished = tile_manager.finish_tile_part(rtile.tile_index, rtile.sample - rtile.start_sample,
+	                                              progress.get_cancel(), &split, &num_done_samples);
+
+	if(split) {
+		if(tile_buffers.size() == 0)
+			tile_buffers.resize(tile_manager.state.num_tiles, NULL);
+
+		/* first finished range holds the sum, the others are added to it. passes
+		 * are sums over samples, and render buffers use the same random numbers
+		 * per pixel, so this is the same as rendering all samples at once */
+		RenderBuffers *sum = tile_buffers[rtile.tile_index];
+
+		if(sum == NULL) {
+			tile_buffers[rtile.tile_index] = rtile.buffers;
+		}
+		else {
+			float *sum_data = (float*)sum->buffer.data_pointer;
+			float *data = (float*)rtile.buffers->buffer.data_pointer;
+
+			for(size_t i = 0; i < sum->buffer.size(); i++)
+				sum_data[i] += data[i];
+
+			delete rtile.buffers;
+		}
+
+		if(finished) {
+			rtile.buffers = tile_buffers[rtile.tile_index];
+			rtile.buffers->copy_to_device();
+			tile_buffers[rtile.tile_index] = NULL;
+
+			rtile.start_sample = tile_manager.state.sample;
+			rtile.num_samples = num_done_samples;
+			rtile.sample = tile_manager.state.sample + num_done_samples;
+		}
+	}
+
+	if(finished) {
+		if(write_render_tile_cb)
+			write_render_tile_cb(rtile);
+
+		delete rtile.buffers;
+	}
+
+	update_status_time();
+}
+
 void Session::run_cpu()
 {
 	bool tiles_written = false;
@@ -484,6 +655,8 @@ void Session::run_cpu()
 				progress.set_status("Finished");
 				break;
 			}
+
+			checkpoint_begin();
 		}
 		else {
 			/* if in interactive mode, and we are either paused or done for now,
@@ -582,6 +755,93 @@ void Session::run_cpu()
 
 	if(!tiles_written)
 		update_progressive_refine(true);
+
+	checkpoint_end();
+}
+
+void Session::checkpoint_begin()
+{
+	/* checkpoints need all samples of a tile to be rendered into the same
+	 * buffers, so not for progressive rendering */
+	if(checkpoint || params.checkpoint_path == "" || params.progressive || params.progressive_refine)
+		return;
+
+	checkpoint = new RenderCheckpoint(params.checkpoint_path, params.checkpoint_interval);
+
+	if(!checkpoint->open(tile_manager.state.buffer, tile_manager.state.num_tiles)) {
+		delete checkpoint;
+		checkpoint = NULL;
+		return;
+	}
+
+	/* resume tiles stored in checkpoint, finished tiles are written out
+	 * right away and partial tiles continue from the stored sample */
+	list<Tile>& tiles = tile_manager.state.tiles;
+	int num_resumed = 0;
+
+	for(list<Tile>::iterator it = tiles.begin(); it != tiles.end(); it++) {
+		Tile& tile = *it;
+		int sample = checkpoint->tile_sample(tile.index, tile.x, tile.y, tile.w, tile.h);
+
+		if(sample == 0)
+			continue;
+
+		num_resumed++;
+
+		if(!tile_manager.resume_tile(tile.index, sample))
+			continue;
+
+		RenderTile rtile;
+		rtile.x = tile_manager.state.buffer.full_x + tile.x;
+		rtile.y = tile_manager.state.buffer.full_y + tile.y;
+		rtile.w = tile.w;
+		rtile.h = tile.h;
+		rtile.start_sample = tile_manager.state.sample;
+		rtile.num_samples = sample;
+		rtile.sample = tile_manager.state.sample + sample;
+		rtile.resolution = tile_manager.state.resolution_divider;
+		rtile.tile_index = tile.index;
+
+		BufferParams buffer_params = tile_manager.params;
+		buffer_params.full_x = rtile.x;
+		buffer_params.full_y = rtile.y;
+		buffer_params.width = rtile.w;
+		buffer_params.height = rtile.h;
+		buffer_params.get_offset_stride(rtile.offset, rtile.stride);
+
+		RenderBuffers *tilebuffers = new RenderBuffers(device);
+		tilebuffers->reset(device, buffer_params);
+
+		if(checkpoint->read_tile(tile.index, tilebuffers)) {
+			rtile.buffer = tilebuffers->buffer.device_pointer;
+			rtile.rng_state = tilebuffers->rng_state.device_pointer;
+			rtile.buffers = tilebuffers;
+
+			if(write_render_tile_cb)
+				write_render_tile_cb(rtile);
+		}
+		else {
+			/* can't be read, render it again */
+			tile_manager.restart_tile(tile.index);
+		}
+
+		delete tilebuffers;
+	}
+
+	if(num_resumed)
+		progress.set_status(string_printf("Resumed %d tiles from checkpoint", num_resumed));
+}
+
+void Session::checkpoint_end()
+{
+	if(!checkpoint)
+		return;
+
+	/* keep the checkpoint when cancelled, to resume the render later */
+	checkpoint->close(!progress.get_cancel());
+
+	delete checkpoint;
+	checkpoint = NULL;
 }
 
 void Session::run()
@@ -608,13 +868,19 @@ void Session::run()
 
 	/* run */
 	if(!progress.get_cancel()) {
-		/* reset number of rendered samples */
+		/* reset number of rendered samples and statistics */
 		progress.reset_sample();
 
+		KernelStats kstats;
+		memset(&kstats, 0, sizeof(kstats));
+		device->kernel_stats(&kstats, true);
+
 		if(device_use_gl)
 			run_gpu();
 		else
 			run_cpu();
+
+		stats_write();
 	}
 
 	/* progress update */
@@ -624,6 +890,51 @@ void Session::run()
 		progress.set_update();
 }
 
+void Session::stats_write()
+{
+	KernelStats kstats;
+	memset(&kstats, 0, sizeof(kstats));
+
+	if(!device->kernel_stats(&kstats, true))
+		return;
+
+	double phase_sum = 0.0;
+
+	for(int i = 0; i < STATS_PHASE_TOTAL; i++)
+		phase_sum += kstats.phase_time[i];
+
+	/* times are summed over all threads */
+	string json = "{\n";
+	json += string_printf("\t\"samples\": %llu,\n", (unsigned long long)kstats.samples);
+	json += "\t\"rays\": {\n";
+	json += string_printf("\t\t\"camera\": %llu,\n", (unsigned long long)kstats.rays[STATS_RAY_CAMERA]);
+	json += string_printf("\t\t\"shadow\": %llu,\n", (unsigned long long)kstats.rays[STATS_RAY_SHADOW]);
+	json += string_printf("\t\t\"bounce\": %llu,\n", (unsigned long long)kstats.rays[STATS_RAY_BOUNCE]);
+	json += string_printf("\t\t\"subsurface\": %llu\n", (unsigned long long)kstats.rays[STATS_RAY_SUBSURFACE]);
+	json += "\t},\n";
+	json += string_printf("\t\"bvh_nodes\": %llu,\n", (unsigned long long)kstats.bvh_nodes);
+	json += "\t\"shader_evals\": {\n";
+	json += string_printf("\t\t\"surface\": %llu,\n", (unsigned long long)kstats.shader_evals[STATS_SHADER_SURFACE]);
+	json += string_printf("\t\t\"background\": %llu,\n", (unsigned long long)kstats.shader_evals[STATS_SHADER_BACKGROUND]);
+	json += string_printf("\t\t\"displacement\": %llu\n", (unsigned long long)kstats.shader_evals[STATS_SHADER_DISPLACEMENT]);
+	json += "\t},\n";
+	json += "\t\"thread_time\": {\n";
+	json += string_printf("\t\t\"intersect\": %f,\n", kstats.phase_time[STATS_PHASE_INTERSECT]);
+	json += string_printf("\t\t\"shading\": %f,\n", kstats.phase_time[STATS_PHASE_SHADING]);
+	json += string_printf("\t\t\"lighting\": %f,\n", kstats.phase_time[STATS_PHASE_LIGHTING]);
+	json += string_printf("\t\t\"other\": %f,\n", max(kstats.phase_time[STATS_PHASE_TOTAL] - phase_sum, 0.0));
+	json += string_printf("\t\t\"total\": %f\n", kstats.phase_time[STATS_PHASE_TOTAL]);
+	json += "\t}\n";
+	json += "}\n";
+
+	if(params.stats_path == "") {
+		printf("Render statistics:\n%s", json.c_str());
+	}
+	else if(!path_write_text(params.stats_path, json)) {
+		fprintf(stderr, "Failed to write render statistics to %s.\n", params.stats_path.c_str());
+	}
+}
+
 bool Session::draw(BufferParams& buffer_params)
 {
 	if(device_use_gl)
@@ -659,7 +970,7 @@ void Session::reset(BufferParams& buffer_params, int samples)
 	else
 		reset_cpu(buffer_params, samples);
 
-	if(params.progressive_refine) {
+	if(params.progressive_refine || tile_manager.adaptive_sampling() || tile_manager.tail_split()) {
 		thread_scoped_lock buffers_lock(buffers_mutex);
 
 		foreach(RenderBuffers *buffers, tile_buffers)
@@ -34,6 +34,7 @@ class DeviceScene;
 class DisplayBuffer;
 class Progress;
 class RenderBuffers;
+class RenderCheckpoint;
 class Scene;
 
 /* Session Parameters */
@@ -53,8 +54,20 @@ public:
 	int start_resolution;
 	int threads;
 
+	/* adaptive sampling, disabled if threshold is zero */
+	float adaptive_threshold;
+	int adaptive_min_samples;
+
 	bool display_buffer_linear;
 
+	/* background render checkpoint file, disabled if empty */
+	string checkpoint_path;
+	double checkpoint_interval;
+
+	/* render statistics JSON file when built with WITH_CYCLES_STATS,
+	 * printed to the console if empty */
+	string stats_path;
+
 	double cancel_timeout;
 	double reset_timeout;
 	double text_timeout;
@@ -74,8 +87,16 @@ public:
 		start_resolution = INT_MAX;
 		threads = 0;
 
+		adaptive_threshold = 0.0f;
+		adaptive_min_samples = 16;
+
 		display_buffer_linear = false;
 
+		checkpoint_path = "";
+		checkpoint_interval = 300.0;
+
+		stats_path = "";
+
 		cancel_timeout = 0.1;
 		reset_timeout = 0.1;
 		text_timeout = 1.0;
@@ -96,7 +117,12 @@ public:
 		&& tile_size == params.tile_size
 		&& start_resolution == params.start_resolution
 		&& threads == params.threads
+		&& adaptive_threshold == params.adaptive_threshold
+		&& adaptive_min_samples == params.adaptive_min_samples
 		&& display_buffer_linear == params.display_buffer_linear
+		&& checkpoint_path == params.checkpoint_path
+		&& checkpoint_interval == params.checkpoint_interval
+		&& stats_path == params.stats_path
 		&& cancel_timeout == params.cancel_timeout
 		&& reset_timeout == params.reset_timeout
 		&& text_timeout == params.text_timeout
@@ -165,9 +191,15 @@ protected:
 	bool acquire_tile(Device *tile_device, RenderTile& tile);
 	void update_tile_sample(RenderTile& tile);
 	void release_tile(RenderTile& tile);
+	void release_tile_part(RenderTile& tile);
 
 	void update_progress_sample();
 
+	void checkpoint_begin();
+	void checkpoint_end();
+
+	void stats_write();
+
 	bool device_use_gl;
 
 	thread *session_thread;
@@ -182,6 +214,7 @@ protected:
 	thread_condition_variable pause_cond;
 	thread_mutex pause_mutex;
 	thread_mutex tile_mutex;
+	thread_condition_variable tile_cond;
 	thread_mutex buffers_mutex;
 	thread_mutex display_mutex;
 
@@ -197,6 +230,8 @@ protected:
 	bool update_progressive_refine(bool cancel);
 
 	vector<RenderBuffers *> tile_buffers;
+
+	RenderCheckpoint *checkpoint;
 };
 
 CCL_NAMESPACE_END
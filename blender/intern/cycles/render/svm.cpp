@@ -24,6 +24,7 @@
 
 #include "util_debug.h"
 #include "util_foreach.h"
+#include "util_hash.h"
 #include "util_progress.h"
 
 CCL_NAMESPACE_BEGIN
@@ -63,6 +64,7 @@ void SVMShaderManager::device_update(Device *device, DeviceScene *dscene, Scene
 	}
 	
 	bool use_multi_closure = device->info.advanced_shading;
+	SVMProgramCache cache;
 
 	for(i = 0; i < scene->shaders.size(); i++) {
 		Shader *shader = scene->shaders[i];
@@ -77,9 +79,13 @@ void SVMShaderManager::device_update(Device *device, DeviceScene *dscene, Scene
 		SVMCompiler compiler(scene->shader_manager, scene->image_manager,
 			use_multi_closure);
 		compiler.background = ((int)i == scene->default_background);
-		compiler.compile(shader, svm_nodes, i);
+		compiler.compile(shader, svm_nodes, i, &cache);
 	}
 
+	if(cache.num_shared)
+		progress.set_status("Updating Shaders", string_printf("%d of %d programs shared",
+			cache.num_shared, cache.num_programs));
+
 	dscene->svm_nodes.copy((uint4*)&svm_nodes[0], svm_nodes.size());
 	device->tex_alloc("__svm_nodes", dscene->svm_nodes);
 
@@ -177,7 +183,7 @@ void SVMCompiler::stack_clear_offset(ShaderSocketType type, int offset)
 		active_stack.users[offset + i]--;
 }
 
-void SVMCompiler::stack_backup(StackBackup& backup, set<ShaderNode*>& done)
+void SVMCompiler::stack_backup(StackBackup& backup, ShaderNodeSet& done)
 {
 	backup.done = done;
 	backup.stack = active_stack;
@@ -190,7 +196,7 @@ void SVMCompiler::stack_backup(StackBackup& backup, set<ShaderNode*>& done)
 	}
 }
 
-void SVMCompiler::stack_restore(StackBackup& backup, set<ShaderNode*>& done)
+void SVMCompiler::stack_restore(StackBackup& backup, ShaderNodeSet& done)
 {
 	int i = 0;
 
@@ -259,7 +265,7 @@ void SVMCompiler::stack_link(ShaderInput *input, ShaderOutput *output)
 	}
 }
 
-void SVMCompiler::stack_clear_users(ShaderNode *node, set<ShaderNode*>& done)
+void SVMCompiler::stack_clear_users(ShaderNode *node, ShaderNodeSet& done)
 {
 	/* optimization we should add:
 	 * find and lower user counts for outputs for which all inputs are done.
@@ -362,7 +368,7 @@ bool SVMCompiler::node_skip_input(ShaderNode *node, ShaderInput *input)
 	return false;
 }
 
-void SVMCompiler::find_dependencies(set<ShaderNode*>& dependencies, const set<ShaderNode*>& done, ShaderInput *input)
+void SVMCompiler::find_dependencies(ShaderNodeSet& dependencies, const ShaderNodeSet& done, ShaderInput *input)
 {
 	ShaderNode *node = (input->link)? input->link->parent: NULL;
 
@@ -375,7 +381,7 @@ void SVMCompiler::find_dependencies(set<ShaderNode*>& dependencies, const set<Sh
 	}
 }
 
-void SVMCompiler::generate_svm_nodes(const set<ShaderNode*>& nodes, set<ShaderNode*>& done)
+void SVMCompiler::generate_svm_nodes(const ShaderNodeSet& nodes, ShaderNodeSet& done)
 {
 	bool nodes_done;
 
@@ -408,7 +414,7 @@ void SVMCompiler::generate_svm_nodes(const set<ShaderNode*>& nodes, set<ShaderNo
 	} while(!nodes_done);
 }
 
-void SVMCompiler::generate_closure(ShaderNode *node, set<ShaderNode*>& done)
+void SVMCompiler::generate_closure(ShaderNode *node, ShaderNodeSet& done)
 {
 	if(node->name == ustring("mix_closure") || node->name == ustring("add_closure")) {
 		ShaderInput *fin = node->input("Fac");
@@ -417,7 +423,7 @@ void SVMCompiler::generate_closure(ShaderNode *node, set<ShaderNode*>& done)
 
 		/* execute dependencies for mix weight */
 		if(fin) {
-			set<ShaderNode*> dependencies;
+			ShaderNodeSet dependencies;
 			find_dependencies(dependencies, done, fin);
 			generate_svm_nodes(dependencies, done);
 
@@ -474,7 +480,7 @@ void SVMCompiler::generate_closure(ShaderNode *node, set<ShaderNode*>& done)
 		/* execute dependencies for closure */
 		foreach(ShaderInput *in, node->inputs) {
 			if(!node_skip_input(node, in) && in->link) {
-				set<ShaderNode*> dependencies;
+				ShaderNodeSet dependencies;
 				find_dependencies(dependencies, done, in);
 				generate_svm_nodes(dependencies, done);
 			}
@@ -499,7 +505,7 @@ void SVMCompiler::generate_closure(ShaderNode *node, set<ShaderNode*>& done)
 	}
 }
 
-void SVMCompiler::generate_multi_closure(ShaderNode *node, set<ShaderNode*>& done, set<ShaderNode*>& closure_done)
+void SVMCompiler::generate_multi_closure(ShaderNode *node, ShaderNodeSet& done, ShaderNodeSet& closure_done)
 {
 	/* todo: the weak point here is that unlike the single closure sampling 
 	 * we will evaluate all nodes even if they are used as input for closures
@@ -526,7 +532,7 @@ void SVMCompiler::generate_multi_closure(ShaderNode *node, set<ShaderNode*>& don
 		/* execute dependencies for closure */
 		foreach(ShaderInput *in, node->inputs) {
 			if(!node_skip_input(node, in) && in->link) {
-				set<ShaderNode*> dependencies;
+				ShaderNodeSet dependencies;
 				find_dependencies(dependencies, done, in);
 				generate_svm_nodes(dependencies, done);
 			}
@@ -638,10 +644,10 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
 			}
 
 			if(generate) {
-				set<ShaderNode*> done;
+				ShaderNodeSet done;
 
 				if(use_multi_closure) {
-					set<ShaderNode*> closure_done;
+					ShaderNodeSet closure_done;
 					generate_multi_closure(clin->link->parent, done, closure_done);
 				}
 				else
@@ -656,7 +662,7 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
 	add_node(NODE_END, 0, 0, 0);
 }
 
-void SVMCompiler::compile(Shader *shader, vector<int4>& global_svm_nodes, int index)
+void SVMCompiler::compile(Shader *shader, vector<int4>& global_svm_nodes, int index, SVMProgramCache *cache)
 {
 	/* copy graph for shader with bump mapping */
 	ShaderNode *node = shader->graph->output();
@@ -683,27 +689,89 @@ void SVMCompiler::compile(Shader *shader, vector<int4>& global_svm_nodes, int in
 
 	/* generate surface shader */
 	compile_type(shader, shader->graph, SHADER_TYPE_SURFACE);
-	global_svm_nodes[index*2 + 0].y = global_svm_nodes.size();
-	global_svm_nodes[index*2 + 1].y = global_svm_nodes.size();
-	global_svm_nodes.insert(global_svm_nodes.end(), svm_nodes.begin(), svm_nodes.end());
+	int offset = add_program(global_svm_nodes, cache);
+	global_svm_nodes[index*2 + 0].y = offset;
+	global_svm_nodes[index*2 + 1].y = offset;
 
 	if(shader->graph_bump) {
 		compile_type(shader, shader->graph_bump, SHADER_TYPE_SURFACE);
-		global_svm_nodes[index*2 + 1].y = global_svm_nodes.size();
-		global_svm_nodes.insert(global_svm_nodes.end(), svm_nodes.begin(), svm_nodes.end());
+		global_svm_nodes[index*2 + 1].y = add_program(global_svm_nodes, cache);
 	}
 
 	/* generate volume shader */
 	compile_type(shader, shader->graph, SHADER_TYPE_VOLUME);
-	global_svm_nodes[index*2 + 0].z = global_svm_nodes.size();
-	global_svm_nodes[index*2 + 1].z = global_svm_nodes.size();
-	global_svm_nodes.insert(global_svm_nodes.end(), svm_nodes.begin(), svm_nodes.end());
+	offset = add_program(global_svm_nodes, cache);
+	global_svm_nodes[index*2 + 0].z = offset;
+	global_svm_nodes[index*2 + 1].z = offset;
 
 	/* generate displacement shader */
 	compile_type(shader, shader->graph, SHADER_TYPE_DISPLACEMENT);
-	global_svm_nodes[index*2 + 0].w = global_svm_nodes.size();
-	global_svm_nodes[index*2 + 1].w = global_svm_nodes.size();
+	offset = add_program(global_svm_nodes, cache);
+	global_svm_nodes[index*2 + 0].w = offset;
+	global_svm_nodes[index*2 + 1].w = offset;
+}
+
+int SVMCompiler::add_program(vector<int4>& global_svm_nodes, SVMProgramCache *cache)
+{
+	if(cache)
+		return cache->add(global_svm_nodes, svm_nodes);
+
+	int offset = global_svm_nodes.size();
 	global_svm_nodes.insert(global_svm_nodes.end(), svm_nodes.begin(), svm_nodes.end());
+
+	return offset;
+}
+
+/* Program Cache */
+
+SVMProgramCache::SVMProgramCache()
+{
+	num_programs = 0;
+	num_shared = 0;
+}
+
+int SVMProgramCache::add(vector<int4>& global_svm_nodes, const vector<int4>& program)
+{
+	/* programs of unused shader types are only a NODE_END, shared but not
+	 * counted in the statistics */
+	bool trivial = (program.size() <= 1);
+
+	if(!trivial)
+		num_programs++;
+
+	/* hash program */
+	uint hash = hash_int(program.size());
+
+	foreach(const int4& node, program) {
+		hash = hash_int_2d(hash, node.x);
+		hash = hash_int_2d(hash, node.y);
+		hash = hash_int_2d(hash, node.z);
+		hash = hash_int_2d(hash, node.w);
+	}
+
+	/* compare with programs of the same hash */
+	vector<Entry>& entries = programs[hash];
+	size_t size = program.size()*sizeof(int4);
+
+	foreach(const Entry& entry, entries) {
+		if(entry.size == (int)program.size() &&
+		   (size == 0 || memcmp(&global_svm_nodes[entry.offset], &program[0], size) == 0))
+		{
+			if(!trivial)
+				num_shared++;
+			return entry.offset;
+		}
+	}
+
+	/* append new program */
+	Entry entry;
+	entry.offset = global_svm_nodes.size();
+	entry.size = program.size();
+	entries.push_back(entry);
+
+	global_svm_nodes.insert(global_svm_nodes.end(), program.begin(), program.end());
+
+	return entry.offset;
 }
 
 CCL_NAMESPACE_END
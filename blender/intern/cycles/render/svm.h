@@ -21,6 +21,7 @@
 #include "graph.h"
 #include "shader.h"
 
+#include "util_map.h"
 #include "util_set.h"
 #include "util_string.h"
 
@@ -48,13 +49,41 @@ public:
 	void device_free(Device *device, DeviceScene *dscene, Scene *scene);
 };
 
+/* Program Cache
+ *
+ * Shares SVM programs between shaders. Compiled programs are position
+ * independent, so shaders that compile to the same nodes, as happens for
+ * duplicated materials and for unused shader types, can all jump to a single
+ * copy in the global program. */
+
+class SVMProgramCache {
+public:
+	SVMProgramCache();
+
+	/* return offset of program in global nodes, appending it if no identical
+	 * program was added before */
+	int add(vector<int4>& global_svm_nodes, const vector<int4>& program);
+
+	int num_programs;
+	int num_shared;
+
+protected:
+	struct Entry {
+		int offset;
+		int size;
+	};
+
+	map<uint, vector<Entry> > programs;
+};
+
 /* Graph Compiler */
 
 class SVMCompiler {
 public:
 	SVMCompiler(ShaderManager *shader_manager, ImageManager *image_manager,
 		bool use_multi_closure_);
-	void compile(Shader *shader, vector<int4>& svm_nodes, int index);
+	void compile(Shader *shader, vector<int4>& svm_nodes, int index,
+		SVMProgramCache *cache = NULL);
 
 	void stack_assign(ShaderOutput *output);
 	void stack_assign(ShaderInput *input);
@@ -110,28 +139,29 @@ protected:
 	struct StackBackup {
 		Stack stack;
 		vector<int> offsets;
-		set<ShaderNode*> done;
+		ShaderNodeSet done;
 	};
 
-	void stack_backup(StackBackup& backup, set<ShaderNode*>& done);
-	void stack_restore(StackBackup& backup, set<ShaderNode*>& done);
+	void stack_backup(StackBackup& backup, ShaderNodeSet& done);
+	void stack_restore(StackBackup& backup, ShaderNodeSet& done);
 
 	void stack_clear_temporary(ShaderNode *node);
 	int stack_size(ShaderSocketType type);
-	void stack_clear_users(ShaderNode *node, set<ShaderNode*>& done);
+	void stack_clear_users(ShaderNode *node, ShaderNodeSet& done);
 
 	bool node_skip_input(ShaderNode *node, ShaderInput *input);
 
 	/* single closure */
-	void find_dependencies(set<ShaderNode*>& dependencies, const set<ShaderNode*>& done, ShaderInput *input);
-	void generate_svm_nodes(const set<ShaderNode*>& nodes, set<ShaderNode*>& done);
-	void generate_closure(ShaderNode *node, set<ShaderNode*>& done);
+	void find_dependencies(ShaderNodeSet& dependencies, const ShaderNodeSet& done, ShaderInput *input);
+	void generate_svm_nodes(const ShaderNodeSet& nodes, ShaderNodeSet& done);
+	void generate_closure(ShaderNode *node, ShaderNodeSet& done);
 
 	/* multi closure */
-	void generate_multi_closure(ShaderNode *node, set<ShaderNode*>& done, set<ShaderNode*>& closure_done);
+	void generate_multi_closure(ShaderNode *node, ShaderNodeSet& done, ShaderNodeSet& closure_done);
 
 	/* compile */
 	void compile_type(Shader *shader, ShaderGraph *graph, ShaderType type);
+	int add_program(vector<int4>& global_svm_nodes, SVMProgramCache *cache);
 
 	vector<int4> svm_nodes;
 	ShaderType current_type;
@@ -31,6 +31,8 @@ TileManager::TileManager(bool progressive_, int num_samples_, int2 tile_size_, i
 	num_devices = num_devices_;
 	preserve_tile_device = preserve_tile_device_;
 	background = background_;
+	adaptive_min_samples = 0;
+	split_workers = 0;
 
 	BufferParams buffer_params;
 	reset(buffer_params, 0);
@@ -62,6 +64,7 @@ void TileManager::reset(BufferParams& params_, int num_samples_)
 	state.sample = -1;
 	state.num_tiles = 0;
 	state.num_rendered_tiles = 0;
+	state.num_busy_tiles = 0;
 	state.num_samples = 0;
 	state.resolution_divider = divider;
 	state.tiles.clear();
@@ -72,6 +75,16 @@ void TileManager::set_samples(int num_samples_)
 	num_samples = num_samples_;
 }
 
+void TileManager::set_adaptive_sampling(int min_samples)
+{
+	adaptive_min_samples = max(min_samples, 0);
+}
+
+void TileManager::set_tail_split(int num_workers)
+{
+	split_workers = max(num_workers, 0);
+}
+
 /* splits image into tiles and assigns equal amount of tiles to every render device */
 void TileManager::gen_tiles_global()
 {
@@ -220,7 +233,19 @@ list<Tile>::iterator TileManager::next_background_tile(int device, TileOrder til
 					break;
 			}
 
-			if(distx < mindist) {
+			bool better = (distx < mindist);
+
+			/* with adaptive sampling, tiles that were not started yet come
+			 * first, after that the noisiest tiles get the remaining threads */
+			if(adaptive_sampling() && best != state.tiles.end() && cur_tile.error != best->error)
+				better = (cur_tile.error > best->error);
+
+			/* with tail splitting, tiles with most samples left come first,
+			 * which are the tiles that were not started yet */
+			if(tail_split() && best != state.tiles.end() && cur_tile.sample != best->sample)
+				better = (cur_tile.sample < best->sample);
+
+			if(better) {
 				best = iter;
 				mindist = distx;
 			}
@@ -230,6 +255,21 @@ list<Tile>::iterator TileManager::next_background_tile(int device, TileOrder til
 	return best;
 }
 
+int TileManager::split_num_parts()
+{
+	/* tiles not fully handed out yet */
+	int num_tiles = 0;
+
+	for(list<Tile>::iterator iter = state.tiles.begin(); iter != state.tiles.end(); iter++)
+		if(!iter->rendering)
+			num_tiles++;
+
+	if(num_tiles == 0 || num_tiles >= split_workers)
+		return 1;
+
+	return (split_workers + num_tiles - 1)/num_tiles;
+}
+
 bool TileManager::next_tile(Tile& tile, int device)
 {
 	list<Tile>::iterator tile_it;
@@ -240,16 +280,135 @@ bool TileManager::next_tile(Tile& tile, int device)
 		tile_it = next_viewport_tile(device);
 
 	if(tile_it != state.tiles.end()) {
+		int num_parts = (tail_split())? split_num_parts(): 1;
+
 		tile_it->rendering = true;
+
+		if(tile_it->sample == 0)
+			state.num_rendered_tiles++;
+
+		if(adaptive_sampling()) {
+			/* hand out one range of samples, the tile gets returned after it */
+			tile_it->num_samples = min(adaptive_min_samples, state.num_samples - tile_it->sample);
+			state.num_busy_tiles++;
+		}
+		else
+			tile_it->num_samples = (state.num_samples - tile_it->sample + num_parts - 1)/num_parts;
+
 		tile = *tile_it;
+
+		if(tail_split()) {
+			/* the first range can finish before the next one is handed out, so
+			 * mark the tile as split as soon as a range is not the whole tile */
+			if(tile_it->num_samples < state.num_samples - tile_it->sample)
+				tile_it->split = true;
+
+			/* tile stays available to others until all samples are handed out */
+			tile_it->sample += tile_it->num_samples;
+			tile_it->rendering = (tile_it->sample >= state.num_samples);
+			tile_it->num_parts++;
+			tile_it->num_busy_parts++;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+bool TileManager::finish_tile_part(int index, int num_samples, bool cancel, bool *split, int *num_done_samples)
+{
+	list<Tile>::iterator iter;
+
+	for(iter = state.tiles.begin(); iter != state.tiles.end(); iter++)
+		if(iter->index == index)
+			break;
+
+	if(iter == state.tiles.end()) {
+		*split = false;
+		*num_done_samples = num_samples;
+		return true;
+	}
+
+	iter->num_busy_parts--;
+	iter->num_done_samples += num_samples;
+
+	/* no more ranges are handed out after cancel */
+	if(cancel)
+		iter->rendering = true;
+
+	*split = iter->split;
+	*num_done_samples = iter->num_done_samples;
+
+	return (iter->num_busy_parts == 0 && iter->rendering);
+}
+
+bool TileManager::return_tile(int index, int sample, float error, bool converged)
+{
+	list<Tile>::iterator iter;
+
+	for(iter = state.tiles.begin(); iter != state.tiles.end(); iter++)
+		if(iter->index == index)
+			break;
+
+	if(iter == state.tiles.end())
+		return true;
+
+	state.num_busy_tiles--;
+
+	iter->sample = sample - state.sample;
+	iter->error = error;
+
+	/* finished tiles stay tagged as rendering so they are not handed out again */
+	if(converged || iter->sample >= state.num_samples)
+		return true;
+
+	iter->rendering = false;
+
+	return false;
+}
+
+bool TileManager::resume_tile(int index, int sample)
+{
+	list<Tile>::iterator iter;
+
+	for(iter = state.tiles.begin(); iter != state.tiles.end(); iter++)
+		if(iter->index == index)
+			break;
+
+	if(iter == state.tiles.end() || iter->rendering || sample <= 0)
+		return false;
+
+	/* counted as rendered here, next_tile only counts tiles starting at zero */
+	if(iter->sample == 0)
 		state.num_rendered_tiles++;
 
+	iter->sample = min(sample, state.num_samples);
+
+	if(iter->sample >= state.num_samples) {
+		iter->rendering = true;
 		return true;
 	}
 
 	return false;
 }
 
+void TileManager::restart_tile(int index)
+{
+	list<Tile>::iterator iter;
+
+	for(iter = state.tiles.begin(); iter != state.tiles.end(); iter++)
+		if(iter->index == index)
+			break;
+
+	if(iter == state.tiles.end() || iter->sample == 0)
+		return;
+
+	iter->sample = 0;
+	iter->rendering = false;
+	state.num_rendered_tiles--;
+}
+
 bool TileManager::done()
 {
 	return (state.sample+state.num_samples >= num_samples && state.resolution_divider == 1);
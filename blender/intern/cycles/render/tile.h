@@ -17,6 +17,7 @@
 #ifndef __TILE_H__
 #define __TILE_H__
 
+#include <float.h>
 #include <limits.h>
 
 #include "buffers.h"
@@ -33,11 +34,29 @@ public:
 	int device;
 	bool rendering;
 
+	/* samples already rendered and sample range handed out for rendering,
+	 * relative to the start sample of the current pass */
+	int sample;
+	int num_samples;
+
+	/* estimated error for adaptive sampling, FLT_MAX until known */
+	float error;
+
+	/* tail splitting: set once a range does not cover all remaining samples,
+	 * number of sample ranges handed out and still being rendered, and
+	 * samples of finished ranges */
+	bool split;
+	int num_parts;
+	int num_busy_parts;
+	int num_done_samples;
+
 	Tile()
 	{}
 
 	Tile(int index_, int x_, int y_, int w_, int h_, int device_)
-	: index(index_), x(x_), y(y_), w(w_), h(h_), device(device_), rendering(false) {}
+	: index(index_), x(x_), y(y_), w(w_), h(h_), device(device_), rendering(false),
+	  sample(0), num_samples(0), error(FLT_MAX),
+	  split(false), num_parts(0), num_busy_parts(0), num_done_samples(0) {}
 };
 
 /* Tile order */
@@ -64,6 +83,7 @@ public:
 		int resolution_divider;
 		int num_tiles;
 		int num_rendered_tiles;
+		int num_busy_tiles;
 		list<Tile> tiles;
 	} state;
 
@@ -80,6 +100,31 @@ public:
 	bool done();
 	
 	void set_tile_order(TileOrder tile_order_) { tile_order = tile_order_; }
+
+	/* adaptive sampling: tiles are handed out in ranges of samples and put back
+	 * after each range until they converged or reached the full sample count */
+	void set_adaptive_sampling(int min_samples);
+	bool adaptive_sampling() { return adaptive_min_samples > 0; }
+	bool return_tile(int index, int sample, float error, bool converged);
+	bool busy_tiles() { return state.num_busy_tiles > 0; }
+
+	/* checkpoint resume: samples of a tile that were already rendered, returns
+	 * true if the tile is finished and should not be handed out */
+	bool resume_tile(int index, int sample);
+
+	/* undo resume_tile for a tile whose stored samples can't be used, so it
+	 * is rendered from the start */
+	void restart_tile(int index);
+
+	/* tail splitting: once there are fewer tiles left than threads and devices
+	 * rendering them, tiles are split into sample ranges that are rendered at
+	 * the same time into separate buffers, and added together afterwards */
+	void set_tail_split(int num_workers);
+	bool tail_split() { return split_workers > 1; }
+	/* finish a sample range of a tile, returns true if no more ranges of the
+	 * tile are rendered. split is set if the tile was rendered in multiple
+	 * ranges, and num_done_samples to the samples of all finished ranges */
+	bool finish_tile_part(int index, int num_samples, bool cancel, bool *split, int *num_done_samples);
 protected:
 
 	void set_tiles();
@@ -89,6 +134,8 @@ protected:
 	TileOrder tile_order;
 	int start_resolution;
 	int num_devices;
+	int adaptive_min_samples;
+	int split_workers;
 
 	/* in some cases it is important that the same tile will be returned for the same
 	 * device it was originally generated for (i.e. viewport rendering when buffer is
@@ -120,6 +167,9 @@ protected:
 
 	/* returns first unhandled tile for viewport render */
 	list<Tile>::iterator next_viewport_tile(int device);
+
+	/* number of ranges to split the remaining samples of a tile into */
+	int split_num_parts();
 };
 
 CCL_NAMESPACE_END
@@ -36,8 +36,11 @@
 #include "subd_split.h"
 #include "subd_vert.h"
 
+#include "mesh.h"
+
 #include "util_debug.h"
 #include "util_foreach.h"
+#include "util_task.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -285,21 +288,193 @@ void SubdMesh::link_boundary_edge(SubdEdge *edge)
 		edge->vert->edge = edge;
 }
 
+/* Tessellation
+ *
+ * Faces are tessellated in parallel, in chunks of a fixed number of faces.
+ * Each chunk is diced into a separate mesh, and these are appended in face
+ * order at the end, so the result is the same for any number of threads.
+ *
+ * Tessellation factors of edges between quads are computed once, on the patch
+ * of the quad with the lowest id, and used by both quads. These edges are
+ * always diced uniformly, as a non-uniform edge would be partitioned again by
+ * each patch while splitting. This way both sides of an edge always get the
+ * same vertices and no cracks appear, even though patch evaluation differs
+ * slightly between the two patches. Factors are written by one task only and
+ * read after all tasks finished, so no locks are needed. */
+
+#define SUBD_TESSELLATE_CHUNK_SIZE 64
+
+struct SubdMesh::TessellateState {
+	DiagSplit *split;
+	SubdBuilder *builder;
+	int shader;
+	bool smooth;
+
+	vector<Patch*> patches;
+	vector<int> edge_factors;
+	vector<Mesh*> chunk_meshes;
+};
+
+/* corners of quad patches, in the order of the face edges starting at them */
+static const float2 quad_corners[4] = {
+	{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
+
+static bool is_quad_face(SubdFace *face)
+{
+	return (face != NULL && face->num_edges() == 4);
+}
+
+static bool owns_edge(SubdFace *face, SubdEdge *edge)
+{
+	SubdFace *pair_face = edge->pair->face;
+	return !(is_quad_face(pair_face) && pair_face->id < face->id);
+}
+
+void SubdMesh::tessellate_patches(TessellateState *state, int start, int end)
+{
+	for(int f = start; f < end; f++) {
+		SubdFace *face = faces[f];
+		Patch *patch = state->builder->run(face);
+
+		state->patches[f] = patch;
+
+		if(!is_quad_face(face))
+			continue;
+
+		/* compute factors for edges owned by this face */
+		int k = 0;
+
+		for(SubdFace::EdgeIterator it(face->edges()); !it.isDone(); it.advance(), k++) {
+			SubdEdge *edge = it.current();
+
+			if(!owns_edge(face, edge))
+				continue;
+
+			float2 Pstart = quad_corners[k];
+			float2 Pend = quad_corners[(k+1)%4];
+
+			if(is_quad_face(edge->pair->face))
+				state->edge_factors[edge->id/2] = state->split->T_shared(patch, Pstart, Pend);
+			else
+				state->edge_factors[edge->id/2] = state->split->T(patch, Pstart, Pend);
+		}
+	}
+}
+
+void SubdMesh::tessellate_dice(TessellateState *state, int chunk, int start, int end)
+{
+	/* dicing uses temporary storage in DiagSplit, so use a copy per chunk */
+	DiagSplit split = *state->split;
+	Mesh *mesh = new Mesh();
+
+	for(int f = start; f < end; f++) {
+		SubdFace *face = faces[f];
+		Patch *patch = state->patches[f];
+
+		if(patch->is_triangle()) {
+			split.split_triangle(mesh, patch, state->shader, state->smooth);
+		}
+		else {
+			/* shared factors, edges go around the patch as tu0, tv1, tu1, tv0 */
+			int factors[4];
+			int k = 0;
+
+			for(SubdFace::EdgeIterator it(face->edges()); !it.isDone(); it.advance(), k++)
+				factors[k] = state->edge_factors[it.current()->id/2];
+
+			QuadDice::EdgeFactors ef;
+			ef.tu0 = factors[0];
+			ef.tv1 = factors[1];
+			ef.tu1 = factors[2];
+			ef.tv0 = factors[3];
+
+			split.split_quad(mesh, patch, state->shader, state->smooth, ef);
+		}
+
+		delete patch;
+		state->patches[f] = NULL;
+	}
+
+	state->chunk_meshes[chunk] = mesh;
+}
+
+static void tessellate_append(Mesh *mesh, Mesh *chunk_mesh)
+{
+	size_t vert_offset = mesh->verts.size();
+	size_t tri_offset = mesh->triangles.size();
+	size_t num_verts = chunk_mesh->verts.size();
+	size_t num_tris = chunk_mesh->triangles.size();
+
+	mesh->reserve(vert_offset + num_verts, tri_offset + num_tris,
+		mesh->curves.size(), mesh->curve_keys.size());
+
+	float3 *vN = mesh->attributes.add(ATTR_STD_VERTEX_NORMAL)->data_float3();
+	Attribute *chunk_attr_vN = chunk_mesh->attributes.find(ATTR_STD_VERTEX_NORMAL);
+	float3 *chunk_vN = (chunk_attr_vN)? chunk_attr_vN->data_float3(): NULL;
+
+	for(size_t i = 0; i < num_verts; i++) {
+		mesh->verts[vert_offset + i] = chunk_mesh->verts[i];
+		if(chunk_vN)
+			vN[vert_offset + i] = chunk_vN[i];
+	}
+
+	for(size_t i = 0; i < num_tris; i++) {
+		Mesh::Triangle tri = chunk_mesh->triangles[i];
+
+		tri.v[0] += vert_offset;
+		tri.v[1] += vert_offset;
+		tri.v[2] += vert_offset;
+
+		mesh->triangles[tri_offset + i] = tri;
+		mesh->shader[tri_offset + i] = chunk_mesh->shader[i];
+		mesh->smooth[tri_offset + i] = chunk_mesh->smooth[i];
+	}
+}
+
 void SubdMesh::tessellate(DiagSplit *split, bool linear, Mesh *mesh, int shader, bool smooth)
 {
+	/* builders keep no state while running, so can be shared by threads */
 	SubdBuilder *builder = SubdBuilder::create(linear);
 	int num_faces = faces.size();
-		        
-	for(int f = 0; f < num_faces; f++) {
-		SubdFace *face = faces[f];
-		Patch *patch = builder->run(face);
+	int num_chunks = (num_faces + SUBD_TESSELLATE_CHUNK_SIZE - 1)/SUBD_TESSELLATE_CHUNK_SIZE;
 
-		if(patch->is_triangle())
-			split->split_triangle(mesh, patch, shader, smooth);
-		else
-			split->split_quad(mesh, patch, shader, smooth);
+	TessellateState state;
+	state.split = split;
+	state.builder = builder;
+	state.shader = shader;
+	state.smooth = smooth;
+	state.patches.resize(num_faces, NULL);
+	state.edge_factors.resize(edges.size(), 0);
+	state.chunk_meshes.resize(num_chunks, NULL);
 
-		delete patch;
+	TaskPool pool;
+
+	/* build patches and compute shared edge factors */
+	for(int chunk = 0; chunk < num_chunks; chunk++) {
+		int start = chunk*SUBD_TESSELLATE_CHUNK_SIZE;
+		int end = min(start + SUBD_TESSELLATE_CHUNK_SIZE, num_faces);
+
+		pool.push(function_bind(&SubdMesh::tessellate_patches, this, &state, start, end));
+	}
+
+	pool.wait_work();
+
+	/* split and dice */
+	for(int chunk = 0; chunk < num_chunks; chunk++) {
+		int start = chunk*SUBD_TESSELLATE_CHUNK_SIZE;
+		int end = min(start + SUBD_TESSELLATE_CHUNK_SIZE, num_faces);
+
+		pool.push(function_bind(&SubdMesh::tessellate_dice, this, &state, chunk, start, end));
+	}
+
+	pool.wait_work();
+
+	/* append in face order */
+	mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
+
+	foreach(Mesh *chunk_mesh, state.chunk_meshes) {
+		tessellate_append(mesh, chunk_mesh);
+		delete chunk_mesh;
 	}
 
 	delete builder;
@@ -65,6 +65,11 @@ public:
 		Mesh *mesh, int shader, bool smooth);
 
 protected:
+	struct TessellateState;
+
+	void tessellate_patches(TessellateState *state, int start, int end);
+	void tessellate_dice(TessellateState *state, int chunk, int start, int end);
+
 	bool can_add_face(int *index, int num);
 	bool can_add_edge(int i, int j);
 	SubdEdge *add_edge(int i, int j);
@@ -60,7 +60,7 @@ float3 DiagSplit::project(Patch *patch, float2 uv)
 	return P;
 }
 
-int DiagSplit::T(Patch *patch, float2 Pstart, float2 Pend)
+int DiagSplit::T(Patch *patch, float2 Pstart, float2 Pend, bool uniform)
 {
 	float3 Plast = make_float3(0.0f, 0.0f, 0.0f);
 	float Lsum = 0.0f;
@@ -83,12 +83,27 @@ int DiagSplit::T(Patch *patch, float2 Pstart, float2 Pend)
 	int tmin = (int)ceil(Lsum/dicing_rate);
 	int tmax = (int)ceil((test_steps-1)*Lmax/dicing_rate); // XXX paper says N instead of N-1, seems wrong?
 
-	if(tmax - tmin > split_threshold)
+	if(tmax - tmin > split_threshold && !uniform)
 		return DSPLIT_NON_UNIFORM;
 	
 	return tmax;
 }
 
+int DiagSplit::T_shared(Patch *patch, float2 Pstart, float2 Pend, int depth)
+{
+	/* a non-uniform edge is partitioned again for every subpatch, evaluating
+	 * the patch on each side separately, so the two sides may not agree. a
+	 * uniform edge is always diced at the same parametric positions. */
+	int t = T(patch, Pstart, Pend, depth >= DSPLIT_MAX_DEPTH);
+
+	if(t == DSPLIT_NON_UNIFORM) {
+		float2 P = (Pstart + Pend)*0.5f;
+		t = T_shared(patch, Pstart, P, depth+1) + T_shared(patch, P, Pend, depth+1);
+	}
+
+	return t;
+}
+
 void DiagSplit::partition_edge(Patch *patch, float2 *P, int *t0, int *t1, float2 Pstart, float2 Pend, int t)
 {
 	if(t == DSPLIT_NON_UNIFORM) {
@@ -298,6 +313,19 @@ void DiagSplit::split_quad(Mesh *mesh, Patch *patch, int shader, bool smooth)
 	ef_split.tv0 = T(patch, sub_split.P00, sub_split.P01);
 	ef_split.tv1 = T(patch, sub_split.P10, sub_split.P11);
 
+	split_quad(mesh, patch, shader, smooth, ef_split);
+}
+
+void DiagSplit::split_quad(Mesh *mesh, Patch *patch, int shader, bool smooth, QuadDice::EdgeFactors ef_split)
+{
+	QuadDice::SubPatch sub_split;
+
+	sub_split.patch = patch;
+	sub_split.P00 = make_float2(0.0f, 0.0f);
+	sub_split.P10 = make_float2(1.0f, 0.0f);
+	sub_split.P01 = make_float2(0.0f, 1.0f);
+	sub_split.P11 = make_float2(1.0f, 1.0f);
+
 	split(sub_split, ef_split);
 
 	QuadDice dice(mesh, shader, smooth, dicing_rate);
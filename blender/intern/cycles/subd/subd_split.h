@@ -33,6 +33,7 @@ class Mesh;
 class Patch;
 
 #define DSPLIT_NON_UNIFORM -1
+#define DSPLIT_MAX_DEPTH 16
 
 class DiagSplit {
 public:
@@ -49,7 +50,10 @@ public:
 	DiagSplit();
 
 	float3 project(Patch *patch, float2 uv);
-	int T(Patch *patch, float2 Pstart, float2 Pend);
+	int T(Patch *patch, float2 Pstart, float2 Pend, bool uniform=false);
+	/* uniform factor for edges shared with another patch, from the factors
+	 * of the parts the edge would be split into if non-uniform */
+	int T_shared(Patch *patch, float2 Pstart, float2 Pend, int depth=0);
 	void partition_edge(Patch *patch, float2 *P, int *t0, int *t1,
 		float2 Pstart, float2 Pend, int t);
 
@@ -61,6 +65,9 @@ public:
 
 	void split_triangle(Mesh *mesh, Patch *patch, int shader, bool smooth);
 	void split_quad(Mesh *mesh, Patch *patch, int shader, bool smooth);
+	/* split quad with given tessellation factors for the patch edges, so
+	 * adjacent patches can share them */
+	void split_quad(Mesh *mesh, Patch *patch, int shader, bool smooth, QuadDice::EdgeFactors ef);
 };
 
 CCL_NAMESPACE_END
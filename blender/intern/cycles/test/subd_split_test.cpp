@@ -0,0 +1,177 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/* Test that two adjacent patches split an edge they share into the same
+ * vertices, when the edge would be split non-uniformly. */
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "subd_patch.h"
+#include "subd_split.h"
+
+#include "util_math.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* control points along v of the shared edge, strongly non-uniform in speed */
+static const float shared_y[4] = {0.0f, 0.02f, 0.04f, 1.0f};
+static const float far_a_y[4] = {0.0f, 0.3f, 0.32f, 1.0f};
+static const float far_b_y[4] = {1.0f, 2.0f/3.0f, 1.0f/3.0f, 0.0f};
+
+/* patch a covers x in [0, 1] and has the shared edge at u = 1, patch b covers
+ * x in [1, 2] and has the shared edge at u = 0, running in the opposite
+ * direction. the far edge of patch a is non-uniform too and the far edge of
+ * patch b is uniform, so the two patches split differently. */
+static void build_patches(BicubicPatch *a, BicubicPatch *b)
+{
+	for(int j = 0; j < 4; j++) {
+		for(int i = 0; i < 4; i++) {
+			float t = i/3.0f;
+
+			float ya = (1.0f - t)*far_a_y[j] + t*shared_y[j];
+			float yb = (1.0f - t)*shared_y[3-j] + t*far_b_y[j];
+
+			a->hull[j*4 + i] = make_float3(t, ya, 0.0f);
+			b->hull[j*4 + i] = make_float3(1.0f + t, yb, 0.0f);
+		}
+	}
+}
+
+static bool less_y(const float3& a, const float3& b)
+{
+	return a.y < b.y;
+}
+
+/* split patch with the given factor for the shared edge, and collect the
+ * vertices that dicing would create along it */
+static void shared_edge_verts(DiagSplit& split, Patch *patch, float shared_u, int t, vector<float3>& verts)
+{
+	QuadDice::SubPatch sub;
+	QuadDice::EdgeFactors ef;
+
+	sub.patch = patch;
+	sub.P00 = make_float2(0.0f, 0.0f);
+	sub.P10 = make_float2(1.0f, 0.0f);
+	sub.P01 = make_float2(0.0f, 1.0f);
+	sub.P11 = make_float2(1.0f, 1.0f);
+
+	ef.tu0 = split.T(patch, sub.P00, sub.P10);
+	ef.tu1 = split.T(patch, sub.P01, sub.P11);
+	ef.tv0 = (shared_u == 0.0f)? t: split.T(patch, sub.P00, sub.P01);
+	ef.tv1 = (shared_u == 1.0f)? t: split.T(patch, sub.P10, sub.P11);
+
+	split.split(sub, ef);
+
+	for(size_t i = 0; i < split.subpatches_quad.size(); i++) {
+		QuadDice::SubPatch& s = split.subpatches_quad[i];
+		QuadDice::EdgeFactors& f = split.edgefactors_quad[i];
+
+		float2 Pstart, Pend;
+		int n;
+
+		if(s.P00.x == shared_u && s.P01.x == shared_u) {
+			Pstart = s.P00;
+			Pend = s.P01;
+			n = f.tv0;
+		}
+		else if(s.P10.x == shared_u && s.P11.x == shared_u) {
+			Pstart = s.P10;
+			Pend = s.P11;
+			n = f.tv1;
+		}
+		else
+			continue;
+
+		n = max(n, 1);
+
+		for(int k = 0; k <= n; k++) {
+			float2 uv = interp(Pstart, Pend, k/(float)n);
+			float3 P;
+
+			patch->eval(&P, NULL, NULL, uv.x, uv.y);
+			verts.push_back(P);
+		}
+	}
+
+	split.subpatches_quad.clear();
+	split.edgefactors_quad.clear();
+
+	/* sort and remove corners shared between subpatches */
+	std::sort(verts.begin(), verts.end(), less_y);
+
+	vector<float3> unique;
+
+	for(size_t i = 0; i < verts.size(); i++)
+		if(unique.empty() || fabsf(verts[i].y - unique.back().y) > 1e-5f)
+			unique.push_back(verts[i]);
+
+	verts = unique;
+}
+
+static int test_shared_edge_non_uniform()
+{
+	BicubicPatch a, b;
+	build_patches(&a, &b);
+
+	DiagSplit split;
+	split.dicing_rate = 0.05f;
+
+	/* the shared edge must be one the split would partition non-uniformly */
+	float2 Pstart = make_float2(1.0f, 0.0f);
+	float2 Pend = make_float2(1.0f, 1.0f);
+
+	if(split.T(&a, Pstart, Pend) != DSPLIT_NON_UNIFORM) {
+		printf("shared edge is uniform, test is invalid\n");
+		return 1;
+	}
+
+	/* factor computed once on the owner patch, used by both */
+	int t = split.T_shared(&a, Pstart, Pend);
+
+	vector<float3> verts_a, verts_b;
+	shared_edge_verts(split, &a, 1.0f, t, verts_a);
+	shared_edge_verts(split, &b, 0.0f, t, verts_b);
+
+	if(verts_a.size() != verts_b.size()) {
+		printf("shared edge has %d vertices on one side and %d on the other\n",
+			(int)verts_a.size(), (int)verts_b.size());
+		return 1;
+	}
+
+	for(size_t i = 0; i < verts_a.size(); i++) {
+		if(len(verts_a[i] - verts_b[i]) > 1e-4f) {
+			printf("crack at shared edge vertex %d: (%f %f %f) != (%f %f %f)\n", (int)i,
+				verts_a[i].x, verts_a[i].y, verts_a[i].z,
+				verts_b[i].x, verts_b[i].y, verts_b[i].z);
+			return 1;
+		}
+	}
+
+	printf("shared edge: %d segments, no cracks\n", t);
+
+	return 0;
+}
+
+CCL_NAMESPACE_END
+
+int main(int argc, char *argv[])
+{
+	return ccl::test_shared_edge_non_uniform();
+}
+
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+/* Test that a tile rendered in multiple sample ranges with tail splitting
+ * adds up to the same result as rendering all samples at once, also when a
+ * range finishes before the next one is handed out. */
+
+#include <stdio.h>
+#include <limits.h>
+
+#include "buffers.h"
+#include "tile.h"
+
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+static const int num_samples = 16;
+static const int num_workers = 4;
+
+/* stand-in for the render buffer of a sample range, the value each sample
+ * adds to a pixel is its sample number */
+static float render_range(int start_sample, int range_samples)
+{
+	float sum = 0.0f;
+
+	for(int s = start_sample; s < start_sample + range_samples; s++)
+		sum += (float)s;
+
+	return sum;
+}
+
+/* render the single tile in ranges, finishing the first range right away
+ * if finish_first is set, and add up ranges like Session::release_tile_part */
+static int test_split(bool finish_first)
+{
+	BufferParams params;
+	params.width = params.full_width = 16;
+	params.height = params.full_height = 16;
+
+	TileManager tile_manager(false, num_samples, make_int2(16, 16), INT_MAX, false, true, TILE_CENTER);
+	tile_manager.set_tail_split(num_workers);
+	tile_manager.reset(params, num_samples);
+	tile_manager.next();
+
+	vector<Tile> ranges;
+	Tile tile;
+
+	float sum = 0.0f;
+	bool have_sum = false;
+	int num_ranges = 0;
+	bool finished = false;
+	bool split = false;
+	int num_done_samples = 0;
+
+	if(finish_first) {
+		if(!tile_manager.next_tile(tile)) {
+			printf("no tile handed out\n");
+			return 1;
+		}
+
+		finished = tile_manager.finish_tile_part(tile.index, tile.num_samples, false, &split, &num_done_samples);
+		num_ranges++;
+
+		if(finished || !split) {
+			printf("first range of %d samples %s\n", tile.num_samples,
+				finished? "finished the tile": "is not marked as split");
+			return 1;
+		}
+
+		sum = render_range(tile.sample, tile.num_samples);
+		have_sum = true;
+	}
+
+	while(tile_manager.next_tile(tile))
+		ranges.push_back(tile);
+
+	for(size_t i = 0; i < ranges.size(); i++) {
+		float range_sum = render_range(ranges[i].sample, ranges[i].num_samples);
+
+		finished = tile_manager.finish_tile_part(ranges[i].index, ranges[i].num_samples, false, &split, &num_done_samples);
+		num_ranges++;
+
+		if(split) {
+			sum = (have_sum)? sum + range_sum: range_sum;
+			have_sum = true;
+		}
+		else
+			sum = range_sum;
+
+		if(finished != (i == ranges.size() - 1)) {
+			printf("range %d of %d %s\n", (int)i + 1, (int)ranges.size(),
+				finished? "finished the tile early": "did not finish the tile");
+			return 1;
+		}
+	}
+
+	float expected = render_range(0, num_samples);
+
+	if(num_done_samples != num_samples || sum != expected) {
+		printf("tile in %d ranges: %d samples adding up to %f, expected %d samples adding up to %f\n",
+			num_ranges, num_done_samples, (double)sum, num_samples, (double)expected);
+		return 1;
+	}
+
+	printf("tile in %d ranges%s: matches unsplit result\n", num_ranges,
+		(finish_first)? ", first finished early": "");
+
+	return 0;
+}
+
+CCL_NAMESPACE_END
+
+int main(int argc, char *argv[])
+{
+	int result = 0;
+
+	result |= ccl::test_split(false);
+	result |= ccl::test_split(true);
+
+	return result;
+}
@@ -15,6 +15,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "util_cache.h"
 #include "util_debug.h"
@@ -33,43 +34,240 @@
 #include <boost/filesystem.hpp> 
 #include <boost/algorithm/string.hpp>
 
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
 CCL_NAMESPACE_BEGIN
 
+/* File Format
+ *
+ * Header, followed by the buffers, each stored as its size followed by the
+ * data aligned to CACHE_ALIGN bytes, so that mapped memory can be used
+ * directly for SSE data types, and a trailer marking a completely written
+ * file. The header stores the file size, checked together with the trailer
+ * on lookup; the data hash is only verified when asked for, as it requires
+ * reading the entire file. */
+
+#define CACHE_MAGIC "CYCACHE"
+#define CACHE_TRAILER "CYCEND"
+#define CACHE_VERSION 3
+#define CACHE_ALIGN 16
+
+typedef struct CacheHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t pad;
+	uint64_t file_size;
+	char key_hash[32];
+	char data_hash[32];
+} CacheHeader;
+
+typedef struct CacheTrailer {
+	char magic[8];
+} CacheTrailer;
+
+static size_t cache_align(size_t offset)
+{
+	return (offset + CACHE_ALIGN - 1) & ~(size_t)(CACHE_ALIGN - 1);
+}
+
+static void cache_hash_append(MD5Hash& md5, const uint8_t *data, size_t size)
+{
+	/* MD5Hash takes int sizes, append large buffers in chunks */
+	const size_t chunk = 1 << 30;
+
+	for(size_t offset = 0; offset < size; offset += chunk)
+		md5.append(data + offset, (int)((size - offset < chunk)? size - offset: chunk));
+}
+
+static bool cache_file_write(FILE *f, MD5Hash& md5, const void *data, size_t size)
+{
+	cache_hash_append(md5, (const uint8_t*)data, size);
+	return (size == 0 || fwrite(data, size, 1, f) == 1);
+}
+
 /* CacheData */
 
 CacheData::CacheData(const string& name_)
 {
 	name = name_;
-	f = NULL;
 	have_filename = false;
+
+	map_data = NULL;
+	map_size = 0;
+	map_offset = 0;
+	map_handle = NULL;
 }
 
 CacheData::~CacheData()
 {
-	if(f)
-		fclose(f);
+	unmap();
 }
 
-const string& CacheData::get_filename()
+const string& CacheData::get_hash()
 {
-	if(!have_filename) {
-		MD5Hash hash;
+	if(hash.empty()) {
+		MD5Hash md5;
 
 		foreach(const CacheBuffer& buffer, buffers)
 			if(buffer.size)
-				hash.append((uint8_t*)buffer.data, buffer.size);
+				cache_hash_append(md5, (uint8_t*)buffer.data, buffer.size);
 		
-		filename = name + "_" + hash.get_hex();
+		hash = md5.get_hex();
+	}
+
+	return hash;
+}
+
+const string& CacheData::get_filename()
+{
+	if(!have_filename) {
+		filename = name + "_" + get_hash();
 		have_filename = true;
 	}
 
 	return filename;
 }
 
+bool CacheData::map(const string& filepath)
+{
+	unmap();
+
+	/* mapped copy-on-write, so the data can be modified in memory, for
+	 * example when refitting a BVH read from the cache */
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if(file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size;
+
+	if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMapping(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	CloseHandle(file);
+
+	if(!mapping)
+		return false;
+
+	void *data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+
+	if(!data) {
+		CloseHandle(mapping);
+		return false;
+	}
+
+	map_handle = mapping;
+	map_size = (size_t)file_size.QuadPart;
+#else
+	int fd = open(filepath.c_str(), O_RDONLY);
+
+	if(fd == -1)
+		return false;
+
+	struct stat st;
+
+	if(fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void *data = mmap(NULL, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if(data == MAP_FAILED)
+		return false;
+
+	map_size = st.st_size;
+#endif
+
+	map_data = (uint8_t*)data;
+	map_offset = 0;
+
+	return true;
+}
+
+void CacheData::unmap()
+{
+	if(!map_data)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(map_data);
+	CloseHandle((HANDLE)map_handle);
+#else
+	munmap(map_data, map_size);
+#endif
+
+	map_data = NULL;
+	map_size = 0;
+	map_offset = 0;
+	map_handle = NULL;
+}
+
+bool CacheData::read_buffer(void *&data, size_t& size)
+{
+	data = NULL;
+	size = 0;
+
+	if(map_offset + sizeof(size_t) > map_size) {
+		fprintf(stderr, "Failed to read buffer size from cache.\n");
+		return false;
+	}
+
+	memcpy(&size, map_data + map_offset, sizeof(size_t));
+	map_offset = cache_align(map_offset + sizeof(size_t));
+
+	if(map_offset > map_size || size > map_size - map_offset) {
+		fprintf(stderr, "Failed to read buffer data from cache (%lu).\n", (unsigned long)size);
+		size = 0;
+		return false;
+	}
+
+	data = (size)? map_data + map_offset: NULL;
+	map_offset += size;
+
+	return true;
+}
+
+bool CacheData::read_value(void *data, size_t size)
+{
+	void *buffer;
+	size_t buffer_size;
+
+	if(!read_buffer(buffer, buffer_size) || buffer_size != size) {
+		fprintf(stderr, "Failed to read value from cache.\n");
+		return false;
+	}
+
+	memcpy(data, buffer, size);
+
+	return true;
+}
+
 /* Cache */
 
 Cache Cache::global;
 
+Cache::Cache()
+{
+	hits = 0;
+	misses = 0;
+	verify_data = (getenv("CYCLES_CACHE_VERIFY") != NULL);
+}
+
 string Cache::data_filename(CacheData& key)
 {
 	return path_user_get(path_join("cache", key.get_filename()));
@@ -86,29 +284,106 @@ void Cache::insert(CacheData& key, CacheData& value)
 		return;
 	}
 
+	CacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+	header.version = CACHE_VERSION;
+	memcpy(header.key_hash, key.get_hash().c_str(), sizeof(header.key_hash));
+
+	/* header is written again at the end, once the data hash is known */
+	bool ok = (fwrite(&header, sizeof(header), 1, f) == 1);
+
+	MD5Hash md5;
+	const uint8_t padding[CACHE_ALIGN] = {0};
+	size_t offset = sizeof(header);
+
 	foreach(CacheBuffer& buffer, value.buffers) {
-		if(!fwrite(&buffer.size, sizeof(buffer.size), 1, f))
-			fprintf(stderr, "Failed to write to file %s.\n", filename.c_str());
-		if(buffer.size)
-			if(!fwrite(buffer.data, buffer.size, 1, f))
-				fprintf(stderr, "Failed to write to file %s.\n", filename.c_str());
+		size_t data_offset = cache_align(offset + sizeof(buffer.size));
+
+		ok = ok && cache_file_write(f, md5, &buffer.size, sizeof(buffer.size));
+		ok = ok && cache_file_write(f, md5, padding, data_offset - offset - sizeof(buffer.size));
+		ok = ok && cache_file_write(f, md5, buffer.data, buffer.size);
+
+		offset = data_offset + buffer.size;
 	}
-	
+
+	CacheTrailer trailer;
+	memset(&trailer, 0, sizeof(trailer));
+	memcpy(trailer.magic, CACHE_TRAILER, sizeof(CACHE_TRAILER));
+
+	ok = ok && (fwrite(&trailer, sizeof(trailer), 1, f) == 1);
+
+	memcpy(header.data_hash, md5.get_hex().c_str(), sizeof(header.data_hash));
+	header.file_size = offset + sizeof(trailer);
+
+	ok = ok && (fseek(f, 0, SEEK_SET) == 0);
+	ok = ok && (fwrite(&header, sizeof(header), 1, f) == 1);
+
 	fclose(f);
+
+	if(!ok) {
+		fprintf(stderr, "Failed to write to file %s.\n", filename.c_str());
+		boost::filesystem::remove(filename);
+	}
 }
 
 bool Cache::lookup(CacheData& key, CacheData& value)
 {
 	string filename = data_filename(key);
-	FILE *f = fopen(filename.c_str(), "rb");
+	bool found = false;
 
-	if(!f)
-		return false;
-	
 	value.name = key.name;
-	value.f = f;
 
-	return true;
+	if(value.map(filename)) {
+		/* verify the file is for this key and was completely written, only
+		 * touching the first and last page so the data stays lazily loaded */
+		CacheHeader *header = (CacheHeader*)value.map_data;
+
+		if(value.map_size >= sizeof(CacheHeader) + sizeof(CacheTrailer) &&
+		   memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) == 0 &&
+		   header->version == CACHE_VERSION &&
+		   header->file_size == value.map_size &&
+		   memcmp(header->key_hash, key.get_hash().c_str(), sizeof(header->key_hash)) == 0)
+		{
+			CacheTrailer *trailer = (CacheTrailer*)(value.map_data + value.map_size - sizeof(CacheTrailer));
+			found = (memcmp(trailer->magic, CACHE_TRAILER, sizeof(CACHE_TRAILER)) == 0);
+
+			/* optionally verify the data was not damaged or modified */
+			if(found && verify_data) {
+				MD5Hash md5;
+				cache_hash_append(md5, value.map_data + sizeof(CacheHeader),
+				                  value.map_size - sizeof(CacheHeader) - sizeof(CacheTrailer));
+
+				found = (memcmp(header->data_hash, md5.get_hex().c_str(), sizeof(header->data_hash)) == 0);
+			}
+		}
+
+		if(found) {
+			value.map_offset = sizeof(CacheHeader);
+		}
+		else {
+			fprintf(stderr, "Invalid cache file %s, removing.\n", filename.c_str());
+			value.unmap();
+			boost::filesystem::remove(filename);
+		}
+	}
+
+	thread_scoped_lock lock(stats_mutex);
+
+	if(found)
+		hits++;
+	else
+		misses++;
+
+	return found;
+}
+
+void Cache::get_stats(int& hits_, int& misses_)
+{
+	thread_scoped_lock lock(stats_mutex);
+
+	hits_ = hits;
+	misses_ = misses;
 }
 
 void Cache::clear_except(const string& name, const set<string>& except)
@@ -28,10 +28,18 @@
  * invalidate cache entries, at the cost of exta computation. If everything
  * is stored in a global cache, computations can perhaps even be shared between
  * different scenes where it may be hard to detect duplicate work.
+ *
+ * Files start with a header containing the key hash and file size, which are
+ * verified before the data is used. The header also contains a hash of the
+ * data, which is only verified with verify_data set (CYCLES_CACHE_VERIFY in
+ * the environment) since it requires reading the whole file. The file is memory mapped, and
+ * arrays are read without copying by referencing the mapped memory, so the
+ * data must stay alive as long as those arrays are used.
  */
 
 #include "util_set.h"
 #include "util_string.h"
+#include "util_thread.h"
 #include "util_vector.h"
 
 CCL_NAMESPACE_BEGIN
@@ -50,13 +58,24 @@ public:
 	vector<CacheBuffer> buffers;
 	string name;
 	string filename;
+	string hash;
 	bool have_filename;
-	FILE *f;
+
+	/* memory mapped file contents and read position */
+	uint8_t *map_data;
+	size_t map_size;
+	size_t map_offset;
+	void *map_handle;
 
 	CacheData(const string& name = "");
 	~CacheData();
 
 	const string& get_filename();
+	const string& get_hash();
+
+	/* map file contents into memory, and unmap them again */
+	bool map(const string& filepath);
+	void unmap();
 
 	template<typename T> void add(const vector<T>& data)
 	{
@@ -96,68 +115,67 @@ public:
 		buffers.push_back(buffer);
 	}
 
-	template<typename T> void read(array<T>& data)
+	/* arrays reference the mapped memory, without copying, read functions
+	 * return false if the file does not contain the expected data */
+	template<typename T> bool read(array<T>& data)
 	{
+		void *ptr;
 		size_t size;
 
-		if(!fread(&size, sizeof(size), 1, f)) {
-			fprintf(stderr, "Failed to read vector size from cache.\n");
-			return;
-		}
+		data.clear();
 
-		if(!size)
-			return;
+		if(!read_buffer(ptr, size) || size % sizeof(T) != 0)
+			return false;
 
-		data.resize(size/sizeof(T));
+		if(ptr)
+			data.reference((T*)ptr, size/sizeof(T));
 
-		if(!fread(&data[0], size, 1, f)) {
-			fprintf(stderr, "Failed to read vector data from cache (%lu).\n", (unsigned long)size);
-			return;
-		}
+		return true;
 	}
 
-	void read(int& data)
+	bool read(int& data)
 	{
-		size_t size;
-
-		if(!fread(&size, sizeof(size), 1, f))
-			fprintf(stderr, "Failed to read int size from cache.\n");
-		if(!fread(&data, sizeof(data), 1, f))
-			fprintf(stderr, "Failed to read int from cache.\n");
+		return read_value(&data, sizeof(data));
 	}
 
-	void read(float& data)
+	bool read(float& data)
 	{
-		size_t size;
-
-		if(!fread(&size, sizeof(size), 1, f))
-			fprintf(stderr, "Failed to read float size from cache.\n");
-		if(!fread(&data, sizeof(data), 1, f))
-			fprintf(stderr, "Failed to read float from cache.\n");
+		return read_value(&data, sizeof(data));
 	}
 
-	void read(size_t& data)
+	bool read(size_t& data)
 	{
-		size_t size;
-
-		if(!fread(&size, sizeof(size), 1, f))
-			fprintf(stderr, "Failed to read size_t size from cache.\n");
-		if(!fread(&data, sizeof(data), 1, f))
-			fprintf(stderr, "Failed to read size_t from cache.\n");
+		return read_value(&data, sizeof(data));
 	}
+
+protected:
+	bool read_buffer(void *&data, size_t& size);
+	bool read_value(void *data, size_t size);
 };
 
 class Cache {
 public:
 	static Cache global;
 
+	Cache();
+
 	void insert(CacheData& key, CacheData& value);
 	bool lookup(CacheData& key, CacheData& value);
 
 	void clear_except(const string& name, const set<string>& except);
 
+	/* number of lookups that found a valid cache file or not */
+	void get_stats(int& hits, int& misses);
+
+	/* verify the hash of the entire data on lookup, not only the header */
+	bool verify_data;
+
 protected:
 	string data_filename(CacheData& key);
+
+	thread_mutex stats_mutex;
+	int hits;
+	int misses;
 };
 
 CCL_NAMESPACE_END
@@ -23,6 +23,7 @@
 OIIO_NAMESPACE_USING
 
 #include <stdio.h>
+#include <string.h>
 
 #include <boost/version.hpp>
 
@@ -86,6 +87,22 @@ string path_escape(const string& path)
 	return result;
 }
 
+string path_sanitize_filename(const string& name)
+{
+	/* replace path separators and characters not allowed in file names on
+	 * some platforms, so names from the user can't point to other folders */
+	string result = name;
+
+	for(size_t i = 0; i < result.size(); i++) {
+		unsigned char c = result[i];
+
+		if(c < 32 || strchr("/\\:*?\"<>|", c))
+			result[i] = '_';
+	}
+
+	return result;
+}
+
 bool path_exists(const string& path)
 {
 	return boost::filesystem::exists(path);
@@ -37,6 +37,7 @@ string path_dirname(const string& path);
 string path_join(const string& dir, const string& file);
 
 string path_escape(const string& path);
+string path_sanitize_filename(const string& name);
 bool path_exists(const string& path);
 string path_files_md5_hash(const string& dir);
 
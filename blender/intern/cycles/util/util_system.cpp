@@ -29,6 +29,9 @@
 #include <unistd.h>
 #endif
 
+#include <stdio.h>
+#include <stdlib.h>
+
 CCL_NAMESPACE_BEGIN
 
 int system_cpu_thread_count()
@@ -58,23 +61,43 @@ int system_cpu_thread_count()
 }
 
 #if !defined(_WIN32) || defined(FREE_WINDOWS)
-static void __cpuid(int data[4], int selector)
+static void __cpuidex(int data[4], int selector, int subleaf)
 {
 #ifdef __x86_64__
-	asm("cpuid" : "=a" (data[0]), "=b" (data[1]), "=c" (data[2]), "=d" (data[3]) : "a"(selector));
+	asm("cpuid" : "=a" (data[0]), "=b" (data[1]), "=c" (data[2]), "=d" (data[3]) : "a"(selector), "c"(subleaf));
 #else
 #ifdef __i386__
 	asm("pushl %%ebx    \n\t"
 		"cpuid          \n\t"
 		"movl %%ebx, %1 \n\t"
-		"popl %%ebx     \n\t" : "=a" (data[0]), "=r" (data[1]), "=c" (data[2]), "=d" (data[3]) : "a"(selector));
+		"popl %%ebx     \n\t" : "=a" (data[0]), "=r" (data[1]), "=c" (data[2]), "=d" (data[3]) : "a"(selector), "c"(subleaf));
 #else
 	data[0] = data[1] = data[2] = data[3] = 0;
 #endif
 #endif
 }
+
+static void __cpuid(int data[4], int selector)
+{
+	__cpuidex(data, selector, 0);
+}
 #endif
 
+/* extended control register, used to check the OS saves AVX registers on
+ * context switches, without that AVX instructions can't be used safely */
+static unsigned long long system_cpu_xgetbv()
+{
+#if defined(_MSC_VER) && (_MSC_FULL_VER >= 160040219)
+	return _xgetbv(0);
+#elif defined(__x86_64__) || defined(__i386__)
+	unsigned int eax, edx;
+	asm(".byte 0x0f, 0x01, 0xd0" : "=a" (eax), "=d" (edx) : "c" (0));
+	return ((unsigned long long)edx << 32) | eax;
+#else
+	return 0;
+#endif
+}
+
 static void replace_string(string& haystack, const string& needle, const string& other)
 {
 	size_t i;
@@ -129,11 +152,54 @@ struct CPUCapabilities {
 	bool sse42;
 	bool sse4a;
 	bool avx;
+	bool avx2;
+	bool f16c;
+	bool bmi1;
+	bool bmi2;
 	bool xop;
 	bool fma3;
 	bool fma4;
 };
 
+/* for benchmarking kernel variants against each other on the same machine,
+ * CYCLES_CPU_KERNEL can be set to sse2, sse3, avx or avx2 to disable the use
+ * of instruction sets above it, other values are ignored */
+static void system_cpu_debug_capabilities(CPUCapabilities& caps)
+{
+	const char *kernel = getenv("CYCLES_CPU_KERNEL");
+
+	if(!kernel)
+		return;
+
+	string name = kernel;
+
+	if(name != "avx2" && name != "avx" && name != "sse3" && name != "sse2") {
+		fprintf(stderr, "Cycles: unknown CYCLES_CPU_KERNEL \"%s\", using all kernels.\n", kernel);
+		return;
+	}
+
+	if(name == "avx2")
+		return;
+
+	caps.avx2 = false;
+
+	if(name == "avx")
+		return;
+
+	caps.avx = false;
+
+	if(name == "sse3")
+		return;
+
+	caps.sse3 = false;
+	caps.ssse3 = false;
+
+	if(name == "sse2")
+		return;
+
+	caps.sse2 = false;
+}
+
 static CPUCapabilities& system_cpu_capabilities()
 {
 	static CPUCapabilities caps;
@@ -163,10 +229,27 @@ static CPUCapabilities& system_cpu_capabilities()
 			caps.sse41 = (result[2] & ((int)1 << 19)) != 0;
 			caps.sse42 = (result[2] & ((int)1 << 20)) != 0;
 
-			caps.avx = (result[2] & ((int)1 << 28)) != 0;
 			caps.fma3 = (result[2] & ((int)1 << 12)) != 0;
+			caps.f16c = (result[2] & ((int)1 << 29)) != 0;
+
+			/* AVX needs both CPU support and the OS saving the YMM registers */
+			bool os_uses_xsave = (result[2] & ((int)1 << 27)) != 0;
+			bool cpu_avx = (result[2] & ((int)1 << 28)) != 0;
+
+			if(os_uses_xsave && cpu_avx)
+				caps.avx = (system_cpu_xgetbv() & 0x6) == 0x6;
+		}
+
+		if(num >= 7) {
+			/* leaf 7 has subleafs, the features are in subleaf 0 */
+			__cpuidex(result, 0x00000007, 0);
+			caps.bmi1 = (result[1] & ((int)1 << 3)) != 0;
+			caps.avx2 = caps.avx && (result[1] & ((int)1 << 5)) != 0;
+			caps.bmi2 = (result[1] & ((int)1 << 8)) != 0;
 		}
 
+		system_cpu_debug_capabilities(caps);
+
 #if 0
 		if(num_ex >= 0x80000001) {
 			__cpuid(result, 0x80000001);
@@ -195,6 +278,19 @@ bool system_cpu_support_sse3()
 	return caps.sse && caps.sse2 && caps.sse3 && caps.ssse3;
 }
 
+bool system_cpu_support_avx()
+{
+	CPUCapabilities& caps = system_cpu_capabilities();
+	return caps.sse && caps.sse2 && caps.sse3 && caps.ssse3 && caps.sse41 && caps.avx;
+}
+
+bool system_cpu_support_avx2()
+{
+	CPUCapabilities& caps = system_cpu_capabilities();
+	return caps.sse && caps.sse2 && caps.sse3 && caps.ssse3 && caps.sse41 && caps.avx && caps.f16c &&
+	       caps.avx2 && caps.fma3 && caps.bmi1 && caps.bmi2;
+}
+
 #else
 
 bool system_cpu_support_sse2()
@@ -207,6 +303,16 @@ bool system_cpu_support_sse3()
 	return false;
 }
 
+bool system_cpu_support_avx()
+{
+	return false;
+}
+
+bool system_cpu_support_avx2()
+{
+	return false;
+}
+
 #endif
 
 CCL_NAMESPACE_END
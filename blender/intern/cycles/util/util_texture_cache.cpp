@@ -0,0 +1,123 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#include "util_texture_cache.h"
+
+#include <OpenImageIO/texture.h>
+
+OIIO_NAMESPACE_USING
+
+CCL_NAMESPACE_BEGIN
+
+TextureCache::TextureCache(int max_memory_mb)
+{
+	TextureSystem *ts = TextureSystem::create(false);
+
+	ts->attribute("max_memory_MB", (float)max_memory_mb);
+
+	/* read untiled files in tiles too, so they don't have to fit in memory */
+	ts->attribute("autotile", 64);
+	ts->attribute("autoscanline", 1);
+
+	texture_system = ts;
+}
+
+TextureCache::~TextureCache()
+{
+	TextureSystem::destroy((TextureSystem*)texture_system);
+}
+
+bool TextureCache::add_image(int slot, const string& filename)
+{
+	TextureSystem *ts = (TextureSystem*)texture_system;
+	ustring ufilename(filename);
+	int nchannels = 0;
+
+	/* file may have changed since it was last used */
+	ts->invalidate(ufilename);
+
+	if(!ts->get_texture_info(ufilename, 0, ustring("channels"), TypeDesc::INT, &nchannels))
+		return false;
+	if(!(nchannels >= 1 && nchannels <= 4))
+		return false;
+
+	TextureSystem::TextureHandle *handle = ts->get_texture_handle(ufilename);
+
+	if(!handle)
+		return false;
+
+	/* images are added from multiple threads */
+	thread_scoped_lock lock(mutex);
+
+	if(slot >= (int)handles.size()) {
+		handles.resize(slot + 1, NULL);
+		channels.resize(slot + 1, 0);
+		filenames.resize(slot + 1);
+	}
+
+	handles[slot] = handle;
+	channels[slot] = nchannels;
+	filenames[slot] = filename;
+
+	return true;
+}
+
+void TextureCache::remove_image(int slot)
+{
+	thread_scoped_lock lock(mutex);
+
+	if(slot < (int)handles.size() && handles[slot]) {
+		TextureSystem *ts = (TextureSystem*)texture_system;
+		ts->invalidate(ustring(filenames[slot]));
+
+		handles[slot] = NULL;
+		channels[slot] = 0;
+		filenames[slot] = "";
+	}
+}
+
+float4 TextureCache::lookup(int slot, float x, float y, bool periodic) const
+{
+	TextureSystem *ts = (TextureSystem*)texture_system;
+	TextureSystem::TextureHandle *handle = (TextureSystem::TextureHandle*)handles[slot];
+
+	/* there are no derivatives for image lookups from SVM, so the full
+	 * resolution level is used */
+	TextureOpt options;
+	options.nchannels = 4;
+	options.fill = 1.0f;
+	options.interpmode = TextureOpt::InterpBilinear;
+	options.mipmode = TextureOpt::MipModeNoMIP;
+	options.swrap = (periodic)? TextureOpt::WrapPeriodic: TextureOpt::WrapClamp;
+	options.twrap = options.swrap;
+
+	/* images are stored bottom to top in cycles */
+	float result[4];
+
+	if(!ts->texture(handle, NULL, options, x, 1.0f - y, 0.0f, 0.0f, 0.0f, 0.0f, result))
+		return make_float4(1.0f, 0.0f, 1.0f, 1.0f);
+
+	/* expand to RGBA the same way as when loading images into memory */
+	if(channels[slot] == 1)
+		return make_float4(result[0], result[0], result[0], 1.0f);
+	else if(channels[slot] == 2)
+		return make_float4(result[0], result[0], result[0], result[1]);
+
+	return make_float4(result[0], result[1], result[2], result[3]);
+}
+
+CCL_NAMESPACE_END
+
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2011-2013 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License
+ */
+
+#ifndef __UTIL_TEXTURE_CACHE_H__
+#define __UTIL_TEXTURE_CACHE_H__
+
+#include "util_string.h"
+#include "util_thread.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Texture Cache
+ *
+ * Out of core image textures for the CPU device. Images are not loaded into
+ * memory as a whole, instead tiles are read from disk on first lookup into a
+ * cache with a fixed memory budget, evicting the least recently used tiles
+ * when it is full. Tiled and mipmapped files, as written by maketx, are read
+ * most efficiently. This wraps the OpenImageIO texture system, so that the
+ * kernel does not need to include its headers. */
+
+class TextureCache {
+public:
+	TextureCache(int max_memory_mb);
+	~TextureCache();
+
+	/* use image file for the texture slot, returns false if it can't be read */
+	bool add_image(int slot, const string& filename);
+	void remove_image(int slot);
+
+	bool has_image(int slot) const
+	{
+		return (slot < (int)handles.size() && handles[slot] != NULL);
+	}
+
+	/* bilinear lookup, same coordinates and result as texture_image::interp */
+	float4 lookup(int slot, float x, float y, bool periodic = true) const;
+
+protected:
+	void *texture_system;
+
+	vector<void*> handles;
+	vector<int> channels;
+	vector<string> filenames;
+	thread_mutex mutex;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_TEXTURE_CACHE_H__ */
+
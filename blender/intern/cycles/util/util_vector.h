@@ -55,7 +55,8 @@ static inline void free_aligned(void *ptr)
  *   this was actually showing up in profiles quite significantly. it
  *   also does not run any constructors/destructors
  * - if this is used, we are not tempted to use inefficient operations
- * - aligned allocation for SSE data types */
+ * - aligned allocation for SSE data types
+ * - can reference memory owned elsewhere, like a memory mapped file */
 
 template<typename T, size_t alignment = 16>
 class array
@@ -65,10 +66,13 @@ public:
 	{
 		data = NULL;
 		datasize = 0;
+		referenced = false;
 	}
 
 	array(size_t newsize)
 	{
+		referenced = false;
+
 		if(newsize == 0) {
 			data = NULL;
 			datasize = 0;
@@ -86,6 +90,8 @@ public:
 
 	array& operator=(const array& from)
 	{
+		referenced = false;
+
 		if(from.datasize == 0) {
 			data = NULL;
 			datasize = 0;
@@ -103,6 +109,7 @@ public:
 	{
 		datasize = from.size();
 		data = NULL;
+		referenced = false;
 
 		if(datasize > 0) {
 			data = (T*)malloc_aligned(sizeof(T)*datasize, alignment);
@@ -117,7 +124,21 @@ public:
 
 	~array()
 	{
-		free_aligned(data);
+		if(!referenced)
+			free_aligned(data);
+	}
+
+	/* use memory owned elsewhere without copying, it is never freed by the
+	 * array, and copied into newly allocated memory on resize */
+	void reference(T *ptr, size_t newsize)
+	{
+		clear();
+
+		if(newsize) {
+			data = ptr;
+			datasize = newsize;
+			referenced = true;
+		}
 	}
 
 	void resize(size_t newsize)
@@ -128,18 +149,22 @@ public:
 		else if(newsize != datasize) {
 			T *newdata = (T*)malloc_aligned(sizeof(T)*newsize, alignment);
 			memcpy(newdata, data, ((datasize < newsize)? datasize: newsize)*sizeof(T));
-			free_aligned(data);
+			if(!referenced)
+				free_aligned(data);
 
 			data = newdata;
 			datasize = newsize;
+			referenced = false;
 		}
 	}
 
 	void clear()
 	{
-		free_aligned(data);
+		if(!referenced)
+			free_aligned(data);
 		data = NULL;
 		datasize = 0;
+		referenced = false;
 	}
 
 	size_t size() const
@@ -155,6 +180,7 @@ public:
 protected:
 	T *data;
 	size_t datasize;
+	bool referenced;
 };
 
 CCL_NAMESPACE_END
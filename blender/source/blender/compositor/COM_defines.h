@@ -36,6 +36,17 @@ typedef enum DataType {
 	COM_DT_COLOR   = 4
 } DataType;
 
+/**
+ * @brief how the channels of a MemoryBuffer are stored
+ * @ingroup Memory
+ */
+typedef enum MemoryBufferStorage {
+	/** @brief a 32 bit float per channel */
+	COM_MB_FLOAT = 0,
+	/** @brief a 16 bit half float per channel, only used for color buffers */
+	COM_MB_HALF_FLOAT = 1
+} MemoryBufferStorage;
+
 /**
  * @brief Possible quality settings
  * @see CompositorContext.quality
@@ -107,6 +118,25 @@ typedef enum OrderOfChunks {
 
 #define COM_NUMBER_OF_CHANNELS 4
 
+/**
+ * @brief maximum number of pixels passed to SocketReader.executeRow
+ * @see NodeOperation.isRowOperation
+ */
+#define COM_ROW_LENGTH 64
+#define COM_ROW_BUFFER_SIZE (COM_ROW_LENGTH * COM_NUMBER_OF_CHANNELS)
+
+/**
+ * @brief maximum number of inputs of a pixel operation
+ * @see NodeOperation.isPixelOperation
+ */
+#define COM_MAX_PIXEL_INPUTS 4
+
+/**
+ * @brief width and height in chunks of a block of neighbouring chunks executed by the same thread
+ * @see ExecutionGroup.getChunkBlock
+ */
+#define COM_CHUNK_BLOCK_SIZE 2
+
 #define COM_BLUR_BOKEH_PIXELS 512
 
 #endif  /* __COM_DEFINES_H__ */
@@ -30,7 +30,10 @@ void CPUDevice::execute(WorkPackage *work)
 
 	executionGroup->determineChunkRect(&rect, chunkNumber);
 
-	executionGroup->getOutputNodeOperation()->executeRegion(&rect, chunkNumber);
+	if (executionGroup->isRowExecution())
+		executionGroup->getOutputNodeOperation()->executeRowRegion(&rect, chunkNumber);
+	else
+		executionGroup->getOutputNodeOperation()->executeRegion(&rect, chunkNumber);
 
 	executionGroup->finalizeChunkExecution(chunkNumber, NULL);
 }
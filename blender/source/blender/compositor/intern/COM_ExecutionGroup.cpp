@@ -62,6 +62,8 @@ ExecutionGroup::ExecutionGroup()
 	this->m_initialized = false;
 	this->m_openCL = false;
 	this->m_singleThreaded = false;
+	this->m_rowExecution = false;
+	this->m_pixelProgram = NULL;
 	this->m_chunksFinished = 0;
 	BLI_rcti_init(&this->m_viewerBorder, 0, 0, 0, 0);
 	this->m_executionStartTime = 0;
@@ -158,6 +160,7 @@ void ExecutionGroup::initExecution()
 	}
 	unsigned int index;
 	determineNumberOfChunks();
+	BLI_mutex_init(&this->m_chunksFinishedMutex);
 
 	this->m_chunkExecutionStates = NULL;
 	if (this->m_numberOfChunks != 0) {
@@ -170,8 +173,15 @@ void ExecutionGroup::initExecution()
 
 	unsigned int maxNumber = 0;
 
+	/* rows are only used when every operation in the group calculates them natively,
+	 * otherwise the row buffers would only add overhead to per pixel execution */
+	this->m_rowExecution = !this->m_complex && !this->m_singleThreaded;
+
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
+		if (!operation->isRowOperation()) {
+			this->m_rowExecution = false;
+		}
 		if (operation->isReadBufferOperation()) {
 			ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
 			this->m_cachedReadOperations.push_back(readOperation);
@@ -181,6 +191,20 @@ void ExecutionGroup::initExecution()
 	maxNumber++;
 	this->m_cachedMaxReadBufferOffset = maxNumber;
 
+	NodeOperation *output = this->getOutputNodeOperation();
+	if (output->isWriteBufferOperation() && ((WriteBufferOperation *)output)->getMemoryProxy()->isCached()) {
+		/* the result is restored from the ResultCache, nothing needs to be scheduled */
+		for (index = 0; index < this->m_numberOfChunks; index++) {
+			this->m_chunkExecutionStates[index] = COM_ES_EXECUTED;
+		}
+	}
+	else if (this->m_rowExecution) {
+		if (output->isWriteBufferOperation()) {
+			WriteBufferOperation *writeOperation = (WriteBufferOperation *)output;
+			this->m_pixelProgram = PixelProgram::compile(writeOperation->getInput());
+			writeOperation->setPixelProgram(this->m_pixelProgram);
+		}
+	}
 }
 
 void ExecutionGroup::deinitExecution()
@@ -193,8 +217,29 @@ void ExecutionGroup::deinitExecution()
 	this->m_numberOfXChunks = 0;
 	this->m_numberOfYChunks = 0;
 	this->m_cachedReadOperations.clear();
+	if (this->m_pixelProgram) {
+		((WriteBufferOperation *)this->getOutputNodeOperation())->setPixelProgram(NULL);
+		delete this->m_pixelProgram;
+		this->m_pixelProgram = NULL;
+	}
+	this->m_rowExecution = false;
 	this->m_bTree = NULL;
+	BLI_mutex_end(&this->m_chunksFinishedMutex);
 }
+bool ExecutionGroup::isCompletelyExecuted() const
+{
+	unsigned int index;
+	if (this->m_numberOfChunks == 0) {
+		return false;
+	}
+	for (index = 0; index < this->m_numberOfChunks; index++) {
+		if (this->m_chunkExecutionStates[index] != COM_ES_EXECUTED) {
+			return false;
+		}
+	}
+	return true;
+}
+
 void ExecutionGroup::determineResolution(unsigned int resolution[2])
 {
 	NodeOperation *operation = this->getOutputNodeOperation();
@@ -381,7 +426,8 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 			}
 		}
 
-		WorkScheduler::finish();
+		/* continue as soon as any chunk is finished, instead of waiting for all scheduled chunks */
+		WorkScheduler::waitForProgress();
 
 		if (bTree->test_break && bTree->test_break(bTree->tbh)) {
 			breaked = true;
@@ -455,7 +501,17 @@ void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memo
 	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED)
 		this->m_chunkExecutionStates[chunkNumber] = COM_ES_EXECUTED;
 	
-	this->m_chunksFinished++;
+	BLI_mutex_lock(&this->m_chunksFinishedMutex);
+	const unsigned int chunksFinished = ++this->m_chunksFinished;
+	BLI_mutex_unlock(&this->m_chunksFinishedMutex);
+
+	if (chunksFinished == this->m_numberOfChunks && this->m_complex) {
+		/* the complex operation does not read its inputs anymore, free expanded copies of compact buffers */
+		for (unsigned int index = 0; index < this->m_cachedReadOperations.size(); index++) {
+			((ReadBufferOperation *)this->m_cachedReadOperations[index])->releaseFullBuffer();
+		}
+	}
+
 	if (memoryBuffers) {
 		for (unsigned int index = 0; index < this->m_cachedMaxReadBufferOffset; index++) {
 			MemoryBuffer *buffer = memoryBuffers[index];
@@ -470,7 +526,7 @@ void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memo
 	}
 	if (this->m_bTree) {
 		// status report is only performed for top level Execution Groups.
-		float progress = this->m_chunksFinished;
+		float progress = chunksFinished;
 		progress /= this->m_numberOfChunks;
 		this->m_bTree->progress(this->m_bTree->prh, progress);
 
@@ -516,6 +572,15 @@ MemoryBuffer *ExecutionGroup::allocateOutputBuffer(int chunkNumber, rcti *rect)
 }
 
 
+unsigned int ExecutionGroup::getChunkBlock(unsigned int chunkNumber) const
+{
+	const unsigned int yChunk = chunkNumber / this->m_numberOfXChunks;
+	const unsigned int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
+	const unsigned int numberOfXBlocks = (this->m_numberOfXChunks + COM_CHUNK_BLOCK_SIZE - 1) / COM_CHUNK_BLOCK_SIZE;
+
+	return (yChunk / COM_CHUNK_BLOCK_SIZE) * numberOfXBlocks + xChunk / COM_CHUNK_BLOCK_SIZE;
+}
+
 bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area)
 {
 	if (this->m_singleThreaded) {
@@ -27,9 +27,11 @@
 #include "COM_NodeOperation.h"
 #include <vector>
 #include "BLI_rect.h"
+#include "BLI_threads.h"
 #include "COM_MemoryProxy.h"
 #include "COM_Device.h"
 #include "COM_CompositorContext.h"
+#include "COM_PixelProgram.h"
 
 
 /**
@@ -120,6 +122,18 @@ private:
 	 * @brief Is this Execution group SingleThreaded
 	 */
 	bool m_singleThreaded;
+
+	/**
+	 * @brief are all operations of this ExecutionGroup calculated row by row
+	 * @see NodeOperation.isRowOperation
+	 */
+	bool m_rowExecution;
+
+	/**
+	 * @brief pixel operations ending in the output operation compiled to a PixelProgram
+	 * @note only used with row execution, NULL when there are too few pixel operations
+	 */
+	PixelProgram *m_pixelProgram;
 	
 	/**
 	 * @brief what is the maximum number field of all ReadBufferOperation in this ExecutionGroup.
@@ -143,6 +157,11 @@ private:
 	 */
 	unsigned int m_chunksFinished;
 	
+	/**
+	 * @brief chunks are finalized by the device threads, m_chunksFinished is counted under this mutex
+	 */
+	ThreadMutex m_chunksFinishedMutex;
+	
 	/**
 	 * @brief the chunkExecutionStates holds per chunk the execution state. this state can be
 	 *   - COM_ES_NOT_SCHEDULED: not scheduled
@@ -397,12 +416,34 @@ public:
 	 */
 	void determineChunkRect(rcti *rect, const unsigned int chunkNumber) const;
 
+	/**
+	 * @brief index of the block of neighbouring chunks that contains a chunk
+	 * @note the WorkScheduler executes chunks of the same block on the same thread when possible,
+	 * as they mostly read the same areas of their inputs
+	 * @see COM_CHUNK_BLOCK_SIZE
+	 */
+	unsigned int getChunkBlock(unsigned int chunkNumber) const;
+
 	/**
 	 * @brief can this ExecutionGroup be scheduled on an OpenCLDevice
 	 * @see WorkScheduler.schedule
 	 */
 	bool isOpenCL();
 
+	/**
+	 * @brief are all operations of this ExecutionGroup calculated row by row
+	 * @note determined in initExecution
+	 * @see CPUDevice.execute
+	 */
+	bool isRowExecution() const { return this->m_rowExecution; }
+
+	/**
+	 * @brief are all chunks of this ExecutionGroup executed
+	 * @note only valid between initExecution and deinitExecution
+	 * @see ExecutionSystem.storeCachedResults
+	 */
+	bool isCompletelyExecuted() const;
+
 	void setChunksize(int chunksize) { this->m_chunkSize = chunksize; }
 
 	/**
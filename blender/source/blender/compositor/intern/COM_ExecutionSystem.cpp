@@ -38,6 +38,7 @@ extern "C" {
 #include "COM_WriteBufferOperation.h"
 #include "COM_ReadBufferOperation.h"
 #include "COM_ExecutionSystemHelper.h"
+#include "COM_ResultCache.h"
 #include "COM_Debug.h"
 
 #include "BKE_global.h"
@@ -62,6 +63,8 @@ ExecutionSystem::ExecutionSystem(RenderData *rd, bNodeTree *editingtree, bool re
 		this->m_context.setQuality((CompositorQuality)editingtree->edit_quality);
 	}
 	this->m_context.setRendering(rendering);
+	/* during rendering every execution has new input */
+	this->m_useResultCache = !rendering;
 	this->m_context.setHasActiveOpenCLDevices(WorkScheduler::hasGPUDevices() && (editingtree->flag & NTREE_COM_OPENCL));
 
 	ExecutionSystemHelper::addbNodeTree(*this, 0, editingtree, NODE_INSTANCE_KEY_BASE);
@@ -72,6 +75,7 @@ ExecutionSystem::ExecutionSystem(RenderData *rd, bNodeTree *editingtree, bool re
 
 	this->convertToOperations();
 	this->groupOperations(); /* group operations in ExecutionGroups */
+	this->determineBufferStorage();
 	unsigned int index;
 	unsigned int resolution[2];
 
@@ -146,6 +150,10 @@ void ExecutionSystem::execute()
 	}
 	unsigned int index;
 
+	if (this->m_useResultCache) {
+		this->restoreCachedResults();
+	}
+
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
 		operation->setbNodeTree(this->m_context.getbNodeTree());
@@ -175,6 +183,10 @@ void ExecutionSystem::execute()
 	WorkScheduler::finish();
 	WorkScheduler::stop();
 
+	if (this->m_useResultCache) {
+		this->storeCachedResults();
+	}
+
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
 		operation->deinitExecution();
@@ -257,6 +269,41 @@ void ExecutionSystem::addReadWriteBufferOperations(NodeOperation *operation)
 			readoperation->readResolutionFromWriteBuffer();
 			this->addOperation(readoperation);
 		}
+
+		if (operation->getResultHash()) {
+			unsigned int resolution[2] = {writeOperation->getWidth(), writeOperation->getHeight()};
+			writeOperation->setResultHash(ResultCache::combine(operation->getResultHash(), resolution, sizeof(resolution)));
+		}
+	}
+}
+
+void ExecutionSystem::determineBufferStorage()
+{
+	const bool useHalfBuffers = this->m_context.isHalfBufferEnabled();
+	unsigned int index;
+
+	for (index = 0; index < this->m_operations.size(); index++) {
+		NodeOperation *operation = this->m_operations[index];
+		if (!operation->isWriteBufferOperation()) {
+			continue;
+		}
+
+		WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+		MemoryProxy *memoryProxy = writeOperation->getMemoryProxy();
+		InputSocket *inputsocket = writeOperation->getInputSocket(0);
+		if (!inputsocket->isConnected()) {
+			continue;
+		}
+
+		DataType datatype = inputsocket->getConnection()->getFromSocket()->getDataType();
+		MemoryBufferStorage storage = (useHalfBuffers && datatype == COM_DT_COLOR) ? COM_MB_HALF_FLOAT : COM_MB_FLOAT;
+		memoryProxy->setStorage(datatype, storage);
+
+		/* cached results are only reused by buffers with the same layout */
+		if (writeOperation->getResultHash()) {
+			int layout[2] = {datatype, storage};
+			writeOperation->setResultHash(ResultCache::combine(writeOperation->getResultHash(), layout, sizeof(layout)));
+		}
 	}
 }
 
@@ -283,15 +330,48 @@ static void debug_check_node_connections(Node *node)
 #define debug_check_node_connections(node)
 #endif
 
+ResultHash ExecutionSystem::determineResultSeed()
+{
+	const RenderData *rd = this->m_context.getRenderData();
+	int settings[7] = {rd->xsch, rd->ysch, rd->size, rd->cfra,
+	                   this->m_context.getQuality(), this->m_context.isFastCalculation(), this->m_context.getViewId()};
+
+	/* FNV-1a offset basis */
+	return ResultCache::combine(14695981039346656037ULL, settings, sizeof(settings));
+}
+
 void ExecutionSystem::convertToOperations()
 {
 	unsigned int index;
+	vector<ResultHash> nodeHashes(this->m_nodes.size(), 0);
+
+	/* hash before converting, converting relinks the sockets of the nodes to operations */
+	if (this->m_useResultCache) {
+		ResultHash seed = determineResultSeed();
+		map<Node *, ResultHash> hashes;
+
+		ResultCache::begin();
+		for (index = 0; index < this->m_nodes.size(); index++) {
+			nodeHashes[index] = ResultCache::hashNode(this->m_nodes[index], seed, hashes);
+		}
+	}
 
 	for (index = 0; index < this->m_nodes.size(); index++) {
 		Node *node = (Node *)this->m_nodes[index];
+		unsigned int operationsStart = this->m_operations.size();
+
 		DebugInfo::node_to_operations(node);
 		node->convertToOperations(this, &this->m_context);
 
+		/* only results of complex operations are cached, they are surrounded by buffers */
+		for (unsigned int operationIndex = operationsStart; operationIndex < this->m_operations.size(); operationIndex++) {
+			NodeOperation *operation = this->m_operations[operationIndex];
+			if (nodeHashes[index] && operation->isComplex()) {
+				unsigned int number = operationIndex - operationsStart;
+				operation->setResultHash(ResultCache::combine(nodeHashes[index], &number, sizeof(number)));
+			}
+		}
+
 		debug_check_node_connections(node);
 	}
 
@@ -357,6 +437,43 @@ void ExecutionSystem::groupOperations()
 	}
 }
 
+void ExecutionSystem::restoreCachedResults()
+{
+	unsigned int index;
+	for (index = 0; index < this->m_operations.size(); index++) {
+		NodeOperation *operation = this->m_operations[index];
+		if (operation->isWriteBufferOperation() && operation->getResultHash()) {
+			WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+			MemoryBuffer *buffer = ResultCache::lookup(writeOperation->getResultHash());
+			if (buffer) {
+				writeOperation->getMemoryProxy()->setCachedBuffer(buffer);
+			}
+		}
+	}
+}
+
+void ExecutionSystem::storeCachedResults()
+{
+	const bNodeTree *bTree = this->m_context.getbNodeTree();
+	unsigned int index;
+
+	/* chunks are finalized when breaking, their buffers are incomplete */
+	if (bTree->test_break && bTree->test_break(bTree->tbh)) {
+		return;
+	}
+
+	for (index = 0; index < this->m_groups.size(); index++) {
+		ExecutionGroup *group = this->m_groups[index];
+		NodeOperation *operation = group->getOutputNodeOperation();
+		if (operation->isWriteBufferOperation() && operation->getResultHash()) {
+			MemoryProxy *memoryProxy = ((WriteBufferOperation *)operation)->getMemoryProxy();
+			if (!memoryProxy->isCached() && group->isCompletelyExecuted()) {
+				ResultCache::store(operation->getResultHash(), memoryProxy->releaseBuffer());
+			}
+		}
+	}
+}
+
 void ExecutionSystem::addSocketConnection(SocketConnection *connection)
 {
 	this->m_connections.push_back(connection);
@@ -33,6 +33,7 @@ class ExecutionGroup;
 #include "BKE_text.h"
 #include "COM_ExecutionGroup.h"
 #include "COM_NodeOperation.h"
+#include "COM_ResultCache.h"
 
 using namespace std;
 
@@ -141,6 +142,11 @@ private:
 	 */
 	vector<SocketConnection *> m_connections;
 
+	/**
+	 * @brief are results of complex operations reused from and stored in the ResultCache
+	 */
+	bool m_useResultCache;
+
 private: //methods
 	/**
 	 * @brief add ReadBufferOperation and WriteBufferOperation around an operation
@@ -148,6 +154,31 @@ private: //methods
 	 */
 	void addReadWriteBufferOperations(NodeOperation *operation);
 
+	/**
+	 * @brief determine how the MemoryProxy's of the WriteBufferOperation's store their data
+	 *
+	 * Buffers store the channels of their datatype, optionally as half floats. Complex
+	 * operations accessing their input buffers directly get an expanded copy from
+	 * ReadBufferOperation.initializeTileData.
+	 */
+	void determineBufferStorage();
+
+	/**
+	 * @brief hash of the settings of this execution that influence all results
+	 * @see ResultCache
+	 */
+	ResultHash determineResultSeed();
+
+	/**
+	 * @brief use results from the ResultCache for WriteBufferOperation's of complex operations
+	 * @note the ExecutionGroup's calculating these results will not be executed
+	 */
+	void restoreCachedResults();
+
+	/**
+	 * @brief store the completely calculated results of complex operations in the ResultCache
+	 */
+	void storeCachedResults();
 
 	/**
 	 * find all execution group with output nodes
@@ -24,11 +24,30 @@
 #include "MEM_guardedalloc.h"
 //#include "BKE_global.h"
 
-unsigned int MemoryBuffer::determineBufferSize()
+unsigned int MemoryBuffer::determineBufferSize() const
 {
 	return getWidth() * getHeight();
 }
 
+int MemoryBuffer::determineNumberOfChannels(DataType datatype)
+{
+	/* the speed pass uses 4 channels, but it is a color */
+	switch (datatype) {
+		case COM_DT_VALUE:
+			return 1;
+		case COM_DT_VECTOR:
+			return 3;
+		default:
+			return COM_NUMBER_OF_CHANNELS;
+	}
+}
+
+size_t MemoryBuffer::getMemorySize() const
+{
+	const size_t channelSize = (this->m_storage == COM_MB_HALF_FLOAT) ? sizeof(unsigned short) : sizeof(float);
+	return channelSize * this->m_numberOfChannels * this->determineBufferSize();
+}
+
 int MemoryBuffer::getWidth() const
 {
 	return this->m_rect.xmax - this->m_rect.xmin;
@@ -38,36 +57,62 @@ int MemoryBuffer::getHeight() const
 	return this->m_rect.ymax - this->m_rect.ymin;
 }
 
-MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect)
+void MemoryBuffer::allocateData(rcti *rect, DataType datatype, MemoryBufferStorage storage)
 {
+	BLI_assert(storage == COM_MB_FLOAT || datatype == COM_DT_COLOR);
+
 	BLI_rcti_init(&this->m_rect, rect->xmin, rect->xmax, rect->ymin, rect->ymax);
+	this->m_datatype = datatype;
+	this->m_numberOfChannels = determineNumberOfChannels(datatype);
+	this->m_storage = storage;
+	this->m_chunkWidth = this->m_rect.xmax - this->m_rect.xmin;
+	this->m_buffer = NULL;
+	this->m_halfBuffer = NULL;
+
+	if (storage == COM_MB_HALF_FLOAT) {
+		this->m_halfBuffer = (unsigned short *)MEM_mallocN(getMemorySize(), "COM_MemoryBuffer");
+	}
+	else {
+		this->m_buffer = (float *)MEM_mallocN(getMemorySize(), "COM_MemoryBuffer");
+	}
+}
+
+MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect,
+                           DataType datatype, MemoryBufferStorage storage)
+{
+	allocateData(rect, datatype, storage);
 	this->m_memoryProxy = memoryProxy;
 	this->m_chunkNumber = chunkNumber;
-	this->m_buffer = (float *)MEM_mallocN(sizeof(float) * determineBufferSize() * COM_NUMBER_OF_CHANNELS, "COM_MemoryBuffer");
 	this->m_state = COM_MB_ALLOCATED;
-	this->m_datatype = COM_DT_COLOR;
-	this->m_chunkWidth = this->m_rect.xmax - this->m_rect.xmin;
 }
 
-MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect)
+MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect,
+                           DataType datatype, MemoryBufferStorage storage)
 {
-	BLI_rcti_init(&this->m_rect, rect->xmin, rect->xmax, rect->ymin, rect->ymax);
+	allocateData(rect, datatype, storage);
 	this->m_memoryProxy = memoryProxy;
 	this->m_chunkNumber = -1;
-	this->m_buffer = (float *)MEM_mallocN(sizeof(float) * determineBufferSize() * COM_NUMBER_OF_CHANNELS, "COM_MemoryBuffer");
 	this->m_state = COM_MB_TEMPORARILY;
-	this->m_datatype = COM_DT_COLOR;
-	this->m_chunkWidth = this->m_rect.xmax - this->m_rect.xmin;
 }
 MemoryBuffer *MemoryBuffer::duplicate()
 {
-	MemoryBuffer *result = new MemoryBuffer(this->m_memoryProxy, &this->m_rect);
-	memcpy(result->m_buffer, this->m_buffer, this->determineBufferSize() * COM_NUMBER_OF_CHANNELS * sizeof(float));
+	MemoryBuffer *result = new MemoryBuffer(this->m_memoryProxy, &this->m_rect, this->m_datatype, this->m_storage);
+	if (this->m_buffer) {
+		memcpy(result->m_buffer, this->m_buffer, this->getMemorySize());
+	}
+	else {
+		memcpy(result->m_halfBuffer, this->m_halfBuffer, this->getMemorySize());
+	}
 	return result;
 }
 void MemoryBuffer::clear()
 {
-	memset(this->m_buffer, 0, this->determineBufferSize() * COM_NUMBER_OF_CHANNELS * sizeof(float));
+	if (this->m_buffer) {
+		memset(this->m_buffer, 0, this->getMemorySize());
+	}
+	else {
+		memset(this->m_halfBuffer, 0, this->getMemorySize());
+	}
 }
 
 float *MemoryBuffer::convertToValueBuffer()
@@ -76,12 +121,11 @@ float *MemoryBuffer::convertToValueBuffer()
 	unsigned int i;
 
 	float *result = (float *)MEM_mallocN(sizeof(float) * size, __func__);
+	float color[4];
 
-	const float *fp_src = this->m_buffer;
-	float       *fp_dst = result;
-
-	for (i = 0; i < size; i++, fp_dst++, fp_src += COM_NUMBER_OF_CHANNELS) {
-		*fp_dst = *fp_src;
+	for (i = 0; i < size; i++) {
+		loadPixel(color, i);
+		result[i] = color[0];
 	}
 
 	return result;
@@ -89,16 +133,17 @@ float *MemoryBuffer::convertToValueBuffer()
 
 float MemoryBuffer::getMaximumValue()
 {
-	float result = this->m_buffer[0];
 	const unsigned int size = this->determineBufferSize();
 	unsigned int i;
+	float color[4];
 
-	const float *fp_src = this->m_buffer;
+	loadPixel(color, 0);
+	float result = color[0];
 
-	for (i = 0; i < size; i++, fp_src += COM_NUMBER_OF_CHANNELS) {
-		float value = *fp_src;
-		if (value > result) {
-			result = value;
+	for (i = 1; i < size; i++) {
+		loadPixel(color, i);
+		if (color[0] > result) {
+			result = color[0];
 		}
 	}
 
@@ -131,6 +176,10 @@ MemoryBuffer::~MemoryBuffer()
 		MEM_freeN(this->m_buffer);
 		this->m_buffer = NULL;
 	}
+	if (this->m_halfBuffer) {
+		MEM_freeN(this->m_halfBuffer);
+		this->m_halfBuffer = NULL;
+	}
 }
 
 void MemoryBuffer::copyContentFrom(MemoryBuffer *otherBuffer)
@@ -146,12 +195,47 @@ void MemoryBuffer::copyContentFrom(MemoryBuffer *otherBuffer)
 	unsigned int maxY = min(this->m_rect.ymax, otherBuffer->m_rect.ymax);
 	int offset;
 	int otherOffset;
+	/* buffers with the same layout are copied per row, others are converted per pixel */
+	const bool sameLayout = (this->m_storage == otherBuffer->m_storage &&
+	                         this->m_numberOfChannels == otherBuffer->m_numberOfChannels);
+	const size_t channelSize = (this->m_storage == COM_MB_HALF_FLOAT) ? sizeof(unsigned short) : sizeof(float);
+	float color[4];
 
 
 	for (otherY = minY; otherY < maxY; otherY++) {
-		otherOffset = ((otherY - otherBuffer->m_rect.ymin) * otherBuffer->m_chunkWidth + minX - otherBuffer->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		offset = ((otherY - this->m_rect.ymin) * this->m_chunkWidth + minX - this->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		memcpy(&this->m_buffer[offset], &otherBuffer->m_buffer[otherOffset], (maxX - minX) * COM_NUMBER_OF_CHANNELS * sizeof(float));
+		otherOffset = (otherY - otherBuffer->m_rect.ymin) * otherBuffer->m_chunkWidth + minX - otherBuffer->m_rect.xmin;
+		offset = (otherY - this->m_rect.ymin) * this->m_chunkWidth + minX - this->m_rect.xmin;
+		if (!sameLayout) {
+			for (unsigned int x = 0; x < maxX - minX; x++) {
+				otherBuffer->loadPixel(color, otherOffset + x);
+				this->storePixel(offset + x, color);
+			}
+		}
+		else if (this->m_buffer) {
+			memcpy(&this->m_buffer[offset * this->m_numberOfChannels], &otherBuffer->m_buffer[otherOffset * this->m_numberOfChannels],
+			       (maxX - minX) * this->m_numberOfChannels * channelSize);
+		}
+		else {
+			memcpy(&this->m_halfBuffer[offset * this->m_numberOfChannels], &otherBuffer->m_halfBuffer[otherOffset * this->m_numberOfChannels],
+			       (maxX - minX) * this->m_numberOfChannels * channelSize);
+		}
+	}
+}
+
+void MemoryBuffer::writeRow(const float *row, int x, int y, int length)
+{
+	BLI_assert(x >= this->m_rect.xmin && x + length <= this->m_rect.xmax &&
+	           y >= this->m_rect.ymin && y < this->m_rect.ymax);
+
+	const int index = this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin;
+
+	if (this->isFullBuffer()) {
+		memcpy(&this->m_buffer[index * COM_NUMBER_OF_CHANNELS], row, sizeof(float) * COM_NUMBER_OF_CHANNELS * length);
+	}
+	else {
+		for (int i = 0; i < length; i++) {
+			storePixel(index + i, row + i * COM_NUMBER_OF_CHANNELS);
+		}
 	}
 }
 
@@ -160,8 +244,8 @@ void MemoryBuffer::writePixel(int x, int y, const float color[4])
 	if (x >= this->m_rect.xmin && x < this->m_rect.xmax &&
 	    y >= this->m_rect.ymin && y < this->m_rect.ymax)
 	{
-		const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		copy_v4_v4(&this->m_buffer[offset], color);
+		const int index = this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin;
+		storePixel(index, color);
 	}
 }
 
@@ -170,8 +254,16 @@ void MemoryBuffer::addPixel(int x, int y, const float color[4])
 	if (x >= this->m_rect.xmin && x < this->m_rect.xmax &&
 	    y >= this->m_rect.ymin && y < this->m_rect.ymax)
 	{
-		const int offset = (this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin) * COM_NUMBER_OF_CHANNELS;
-		add_v4_v4(&this->m_buffer[offset], color);
+		const int index = this->m_chunkWidth * (y - this->m_rect.ymin) + x - this->m_rect.xmin;
+		if (this->isFullBuffer()) {
+			add_v4_v4(&this->m_buffer[index * COM_NUMBER_OF_CHANNELS], color);
+		}
+		else {
+			float result[4];
+			loadPixel(result, index);
+			add_v4_v4(result, color);
+			storePixel(index, result);
+		}
 	}
 }
 
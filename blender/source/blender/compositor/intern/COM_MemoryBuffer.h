@@ -69,6 +69,15 @@ private:
 	 */
 	DataType m_datatype;
 	
+	/**
+	 * @brief number of channels stored per pixel, determined by the datatype
+	 */
+	int m_numberOfChannels;
+	
+	/**
+	 * @brief are the channels stored as floats or half floats
+	 */
+	MemoryBufferStorage m_storage;
 	
 	/**
 	 * @brief region of this buffer inside relative to the MemoryProxy
@@ -93,19 +102,28 @@ private:
 	
 	/**
 	 * @brief the actual float buffer/data
+	 * @note NULL when the storage is COM_MB_HALF_FLOAT
 	 */
 	float *m_buffer;
+	
+	/**
+	 * @brief the actual half float buffer/data
+	 * @note NULL when the storage is COM_MB_FLOAT
+	 */
+	unsigned short *m_halfBuffer;
 
 public:
 	/**
 	 * @brief construct new MemoryBuffer for a chunk
 	 */
-	MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect);
+	MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, rcti *rect,
+	             DataType datatype = COM_DT_COLOR, MemoryBufferStorage storage = COM_MB_FLOAT);
 	
 	/**
 	 * @brief construct new temporarily MemoryBuffer for an area
 	 */
-	MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect);
+	MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect,
+	             DataType datatype = COM_DT_COLOR, MemoryBufferStorage storage = COM_MB_FLOAT);
 	
 	/**
 	 * @brief destructor
@@ -120,8 +138,39 @@ public:
 	/**
 	 * @brief get the data of this MemoryBuffer
 	 * @note buffer should already be available in memory
+	 * @note only full buffers can be accessed directly, see isFullBuffer
 	 */
-	float *getBuffer() { return this->m_buffer; }
+	float *getBuffer()
+	{
+		BLI_assert(this->isFullBuffer());
+		return this->m_buffer;
+	}
+	
+	/**
+	 * @brief does this buffer store COM_NUMBER_OF_CHANNELS floats per pixel
+	 *
+	 * Operations accessing the data directly expect this layout. Buffers with less channels or
+	 * half floats can only be accessed using the read and write methods, that convert the pixels,
+	 * or through a full copy made with copyContentFrom.
+	 */
+	inline bool isFullBuffer() const
+	{
+		return this->m_storage == COM_MB_FLOAT && this->m_numberOfChannels == COM_NUMBER_OF_CHANNELS;
+	}
+	
+	DataType getDataType() const { return this->m_datatype; }
+	MemoryBufferStorage getStorage() const { return this->m_storage; }
+	int getNumberOfChannels() const { return this->m_numberOfChannels; }
+	
+	/**
+	 * @brief get the number of channels stored per pixel for a datatype
+	 */
+	static int determineNumberOfChannels(DataType datatype);
+	
+	/**
+	 * @brief get the size of the data in bytes
+	 */
+	size_t getMemorySize() const;
 	
 	/**
 	 * @brief after execution the state will be set to available by calling this method
@@ -175,8 +224,7 @@ public:
 		}
 		else {
 			wrap_pixel(x, y, extend_x, extend_y);
-			const int offset = (this->m_chunkWidth * y + x) * COM_NUMBER_OF_CHANNELS;
-			copy_v4_v4(result, &this->m_buffer[offset]);
+			loadPixel(result, this->m_chunkWidth * y + x);
 		}
 	}
 
@@ -185,10 +233,10 @@ public:
 	                        MemoryBufferExtend extend_y = COM_MB_CLIP)
 	{
 		wrap_pixel(x, y, extend_x, extend_y);
-		const int offset = (this->m_chunkWidth * y + x) * COM_NUMBER_OF_CHANNELS;
+		const int index = this->m_chunkWidth * y + x;
 
-		BLI_assert(offset >= 0);
-		BLI_assert(offset < this->determineBufferSize() * COM_NUMBER_OF_CHANNELS);
+		BLI_assert(index >= 0);
+		BLI_assert(index < this->determineBufferSize());
 		BLI_assert(!(extend_x == COM_MB_CLIP && (x < m_rect.xmin || x >= m_rect.xmax)) &&
 		           !(extend_y == COM_MB_CLIP && (y < m_rect.ymin || y >= m_rect.ymax)));
 
@@ -198,9 +246,43 @@ public:
 		           (int)(this->determineBufferSize() * COM_NUMBER_OF_CHANNELS));
 #endif
 
-		copy_v4_v4(result, &this->m_buffer[offset]);
+		loadPixel(result, index);
 	}
 	
+	/**
+	 * @brief read length pixels starting at x, y, pixels outside of the rect are zero like in read
+	 */
+	inline void readRow(float *result, int x, int y, int length)
+	{
+		int start = max(x, this->m_rect.xmin);
+		int end = min(x + length, this->m_rect.xmax);
+
+		if (y < this->m_rect.ymin || y >= this->m_rect.ymax || start >= end) {
+			memset(result, 0, sizeof(float) * COM_NUMBER_OF_CHANNELS * length);
+			return;
+		}
+
+		const int index = this->m_chunkWidth * (y - this->m_rect.ymin) + (start - this->m_rect.xmin);
+
+		memset(result, 0, sizeof(float) * COM_NUMBER_OF_CHANNELS * (start - x));
+		if (this->isFullBuffer()) {
+			memcpy(result + (start - x) * COM_NUMBER_OF_CHANNELS, &this->m_buffer[index * COM_NUMBER_OF_CHANNELS],
+			       sizeof(float) * COM_NUMBER_OF_CHANNELS * (end - start));
+		}
+		else {
+			for (int i = 0; i < end - start; i++) {
+				loadPixel(result + (start - x + i) * COM_NUMBER_OF_CHANNELS, index + i);
+			}
+		}
+		memset(result + (end - x) * COM_NUMBER_OF_CHANNELS, 0, sizeof(float) * COM_NUMBER_OF_CHANNELS * (x + length - end));
+	}
+
+	/**
+	 * @brief write length pixels starting at x, y
+	 * @note the pixels must be inside the rect of this MemoryBuffer
+	 */
+	void writeRow(const float *row, int x, int y, int length);
+
 	void writePixel(int x, int y, const float color[4]);
 	void addPixel(int x, int y, const float color[4]);
 	inline void readBilinear(float result[4], float x, float y,
@@ -287,7 +369,116 @@ public:
 	float getMaximumValue();
 	float getMaximumValue(rcti *rect);
 private:
-	unsigned int determineBufferSize();
+	unsigned int determineBufferSize() const;
+	void allocateData(rcti *rect, DataType datatype, MemoryBufferStorage storage);
+
+	/**
+	 * @brief read the pixel at index, channels that are not stored are zero
+	 */
+	inline void loadPixel(float result[4], unsigned int index) const
+	{
+		const unsigned int offset = index * this->m_numberOfChannels;
+
+		if (this->isFullBuffer()) {
+			copy_v4_v4(result, &this->m_buffer[offset]);
+			return;
+		}
+
+		zero_v4(result);
+		for (int channel = 0; channel < this->m_numberOfChannels; channel++) {
+			result[channel] = (this->m_buffer) ? this->m_buffer[offset + channel] : halfToFloat(this->m_halfBuffer[offset + channel]);
+		}
+	}
+
+	/**
+	 * @brief write the pixel at index, channels that are not stored are ignored
+	 */
+	inline void storePixel(unsigned int index, const float color[4])
+	{
+		const unsigned int offset = index * this->m_numberOfChannels;
+
+		if (this->isFullBuffer()) {
+			copy_v4_v4(&this->m_buffer[offset], color);
+			return;
+		}
+
+		for (int channel = 0; channel < this->m_numberOfChannels; channel++) {
+			if (this->m_buffer) {
+				this->m_buffer[offset + channel] = color[channel];
+			}
+			else {
+				this->m_halfBuffer[offset + channel] = floatToHalf(color[channel]);
+			}
+		}
+	}
+
+	static inline float halfToFloat(unsigned short half)
+	{
+		union { unsigned int i; float f; } result;
+		unsigned int sign = ((unsigned int)(half & 0x8000)) << 16;
+		unsigned int exponent = (half >> 10) & 0x1f;
+		unsigned int mantissa = half & 0x3ff;
+
+		if (exponent == 0) {
+			if (mantissa == 0) {
+				result.i = sign;
+			}
+			else {
+				/* denormalized, normalize for the float exponent */
+				exponent = 127 - 15 + 1;
+				while (!(mantissa & 0x400)) {
+					mantissa <<= 1;
+					exponent--;
+				}
+				result.i = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+			}
+		}
+		else if (exponent == 0x1f) {
+			/* infinity and NaN */
+			result.i = sign | 0x7f800000 | (mantissa << 13);
+		}
+		else {
+			result.i = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+		}
+		return result.f;
+	}
+
+	static inline unsigned short floatToHalf(float value)
+	{
+		union { float f; unsigned int i; } input;
+		input.f = value;
+		const unsigned int sign = (input.i >> 16) & 0x8000;
+		const int exponent = (int)((input.i >> 23) & 0xff) - 127 + 15;
+		unsigned int mantissa = input.i & 0x7fffff;
+
+		if (exponent <= 0) {
+			/* too small for a normalized half, store denormalized or zero */
+			if (exponent < -10) {
+				return sign;
+			}
+			mantissa |= 0x800000;
+			const int shift = 14 - exponent;
+			unsigned int half = mantissa >> shift;
+			if ((mantissa >> (shift - 1)) & 1) {
+				half++;
+			}
+			return sign | half;
+		}
+		else if (exponent >= 0x1f) {
+			/* too large values become infinity, NaN stays NaN */
+			if (((input.i >> 23) & 0xff) == 0xff && mantissa) {
+				return sign | 0x7e00;
+			}
+			return sign | 0x7c00;
+		}
+
+		/* rounding may carry into the exponent, this still results in the nearest half */
+		unsigned int half = sign | (exponent << 10) | (mantissa >> 13);
+		if (mantissa & 0x1000) {
+			half++;
+		}
+		return half;
+	}
 
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("COM:MemoryBuffer")
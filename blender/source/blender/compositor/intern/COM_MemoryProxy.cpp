@@ -27,6 +27,10 @@ MemoryProxy::MemoryProxy()
 {
 	this->m_writeBufferOperation = NULL;
 	this->m_executor = NULL;
+	this->m_buffer = NULL;
+	this->m_cached = false;
+	this->m_datatype = COM_DT_COLOR;
+	this->m_storage = COM_MB_FLOAT;
 }
 
 void MemoryProxy::allocate(unsigned int width, unsigned int height)
@@ -37,14 +41,28 @@ void MemoryProxy::allocate(unsigned int width, unsigned int height)
 	result.ymin = 0;
 	result.ymax = height;
 
-	this->m_buffer = new MemoryBuffer(this, 1, &result);
+	this->m_buffer = new MemoryBuffer(this, 1, &result, this->m_datatype, this->m_storage);
+}
+
+void MemoryProxy::setCachedBuffer(MemoryBuffer *buffer)
+{
+	this->m_buffer = buffer;
+	this->m_cached = true;
+}
+
+MemoryBuffer *MemoryProxy::releaseBuffer()
+{
+	MemoryBuffer *buffer = this->m_buffer;
+	this->m_buffer = NULL;
+	return buffer;
 }
 
 void MemoryProxy::free()
 {
-	if (this->m_buffer) {
+	if (this->m_buffer && !this->m_cached) {
 		delete this->m_buffer;
-		this->m_buffer = NULL;
 	}
+	this->m_buffer = NULL;
+	this->m_cached = false;
 }
 
@@ -50,7 +50,12 @@ private:
 	/**
 	 * @brief datatype of this MemoryProxy
 	 */
-	/* DataType m_datatype; */ /* UNUSED */
+	DataType m_datatype;
+
+	/**
+	 * @brief storage of the channels of the allocated memory
+	 */
+	MemoryBufferStorage m_storage;
 	
 	/**
 	 * @brief channel information of this buffer
@@ -62,6 +67,11 @@ private:
 	 */
 	MemoryBuffer *m_buffer;
 
+	/**
+	 * @brief is the buffer owned by the ResultCache
+	 */
+	bool m_cached;
+
 public:
 	MemoryProxy();
 	
@@ -88,6 +98,21 @@ public:
 	 */
 	WriteBufferOperation *getWriteBufferOperation() { return this->m_writeBufferOperation; }
 
+	/**
+	 * @brief set the layout of the memory that is allocated
+	 * @note by default memory is allocated as COM_NUMBER_OF_CHANNELS floats per pixel,
+	 * that is needed by operations accessing the data directly
+	 * @see ExecutionSystem.determineBufferStorage
+	 */
+	void setStorage(DataType datatype, MemoryBufferStorage storage)
+	{
+		this->m_datatype = datatype;
+		this->m_storage = storage;
+	}
+
+	DataType getDataType() const { return this->m_datatype; }
+	MemoryBufferStorage getStorage() const { return this->m_storage; }
+
 	/**
 	 * @brief allocate memory of size width x height
 	 */
@@ -103,6 +128,23 @@ public:
 	 */
 	inline MemoryBuffer *getBuffer() { return this->m_buffer; }
 
+	/**
+	 * @brief use a result from the ResultCache instead of allocating memory
+	 * @note the buffer is not freed by this MemoryProxy
+	 */
+	void setCachedBuffer(MemoryBuffer *buffer);
+
+	/**
+	 * @brief is the buffer a result from the ResultCache
+	 */
+	bool isCached() const { return this->m_cached; }
+
+	/**
+	 * @brief give up ownership of the allocated memory
+	 * @return the buffer, the caller is responsible for freeing it
+	 */
+	MemoryBuffer *releaseBuffer();
+
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("COM:MemoryProxy")
 #endif
@@ -36,6 +36,9 @@ NodeOperation::NodeOperation() : NodeBase()
 	this->m_height = 0;
 	this->m_isResolutionSet = false;
 	this->m_openCL = false;
+	this->m_rowOperation = false;
+	this->m_pixelOperation = false;
+	this->m_resultHash = 0;
 	this->m_btree = NULL;
 }
 
@@ -107,6 +110,27 @@ NodeOperation *NodeOperation::getInputOperation(unsigned int inputSocketIndex)
 	return this->getInputSocket(inputSocketIndex)->getOperation();
 }
 
+void NodeOperation::executeRow(float *output, int x, int y, int length)
+{
+	if (!this->m_pixelOperation) {
+		SocketReader::executeRow(output, x, y, length);
+		return;
+	}
+
+	float buffers[COM_MAX_PIXEL_INPUTS][COM_ROW_BUFFER_SIZE];
+	float *inputs[COM_MAX_PIXEL_INPUTS];
+	unsigned int index;
+
+	BLI_assert(this->getNumberOfInputSockets() <= COM_MAX_PIXEL_INPUTS);
+
+	for (index = 0; index < this->getNumberOfInputSockets(); index++) {
+		inputs[index] = buffers[index];
+		this->getInputSocketReader(index)->readRow(inputs[index], x, y, length);
+	}
+
+	processRow(output, inputs, length);
+}
+
 void NodeOperation::getConnectedInputSockets(vector<InputSocket *> *sockets)
 {
 	vector<InputSocket *> &inputsockets = this->getInputSockets();
@@ -29,6 +29,7 @@ class OpenCLDevice;
 #include "COM_MemoryBuffer.h"
 #include "COM_MemoryProxy.h"
 #include "COM_SocketReader.h"
+#include "COM_ResultCache.h"
 #include "OCL_opencl.h"
 #include "list"
 #include "BLI_threads.h"
@@ -65,6 +66,25 @@ private:
 	 */
 	bool m_openCL;
 
+	/**
+	 * @brief does this operation implement executeRow.
+	 * @note only applicable if complex is False
+	 * @see ExecutionGroup.isRowExecution
+	 */
+	bool m_rowOperation;
+
+	/**
+	 * @brief is the output of this operation only a function of its inputs at the same pixel.
+	 * @note these operations implement processRow and can be fused into a PixelProgram
+	 */
+	bool m_pixelOperation;
+
+	/**
+	 * @brief hash of the result of this operation
+	 * @note 0 when the result can not be stored in the ResultCache
+	 */
+	ResultHash m_resultHash;
+
 	/**
 	 * @brief mutex reference for very special node initializations
 	 * @note only use when you really know what you are doing.
@@ -140,6 +160,16 @@ public:
 	 */
 	virtual void executeRegion(rcti *rect, unsigned int chunkNumber) {}
 
+	/**
+	 * @brief when a chunk of an ExecutionGroup where all operations support rows is executed by a CPUDevice,
+	 * this method is called instead of executeRegion
+	 * @ingroup execution
+	 * @param rect the rectangle of the chunk (location and size)
+	 * @param chunkNumber the chunkNumber to be calculated
+	 * @see ExecutionGroup.isRowExecution
+	 */
+	virtual void executeRowRegion(rcti *rect, unsigned int chunkNumber) { executeRegion(rect, chunkNumber); }
+
 	/**
 	 * @brief when a chunk is executed by an OpenCLDevice, this method is called
 	 * @ingroup execution
@@ -245,6 +275,36 @@ public:
 	 * @see ExecutionGroup.addOperation
 	 */
 	bool isOpenCL() { return this->m_openCL; }
+
+	/**
+	 * @brief does this NodeOperation calculate rows of pixels at once
+	 * @see SocketReader.executeRow
+	 * @see ExecutionGroup.isRowExecution
+	 */
+	bool isRowOperation() const { return this->m_rowOperation; }
+
+	/**
+	 * @brief is the output of this NodeOperation only a function of its inputs at the same pixel
+	 * @see processRow
+	 * @see PixelProgram
+	 */
+	bool isPixelOperation() const { return this->m_pixelOperation; }
+
+	/**
+	 * @brief calculate a row of pixels from rows of the input values
+	 * @note only implemented by pixel operations
+	 * @param output is a float array of length * COM_NUMBER_OF_CHANNELS to store the result
+	 * @param inputs a row of length pixels for every input socket
+	 * @param length number of pixels to calculate, at most COM_ROW_LENGTH
+	 */
+	virtual void processRow(float *output, float **inputs, int length) {}
+
+	/**
+	 * @brief hash of the result of this NodeOperation
+	 * @see ResultCache
+	 */
+	void setResultHash(ResultHash hash) { this->m_resultHash = hash; }
+	ResultHash getResultHash() const { return this->m_resultHash; }
 	
 	virtual bool isViewerOperation() { return false; }
 	virtual bool isPreviewOperation() { return false; }
@@ -285,6 +345,24 @@ protected:
 	 */
 	void setOpenCL(bool openCL) { this->m_openCL = openCL; }
 
+	/**
+	 * @brief set if this NodeOperation implements executeRow
+	 */
+	void setRowOperation(bool rowOperation) { this->m_rowOperation = rowOperation; }
+
+	/**
+	 * @brief set if this NodeOperation is a pixel operation, which implements processRow
+	 */
+	void setPixelOperation(bool pixelOperation) {
+		this->m_pixelOperation = pixelOperation;
+		this->m_rowOperation = pixelOperation;
+	}
+
+	/**
+	 * @brief reads rows of all inputs and calls processRow for pixel operations
+	 */
+	void executeRow(float *output, int x, int y, int length);
+
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("COM:NodeOperation")
 #endif
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2011, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "COM_PixelProgram.h"
+#include "COM_NodeOperation.h"
+#include "COM_InputSocket.h"
+
+#include "MEM_guardedalloc.h"
+
+PixelProgram::PixelProgram()
+{
+	this->m_numberOfRegisters = 0;
+	this->m_numberOfProcessInstructions = 0;
+}
+
+PixelProgram *PixelProgram::compile(NodeOperation *operation)
+{
+	if (!operation->isPixelOperation()) {
+		return NULL;
+	}
+
+	PixelProgram *program = new PixelProgram();
+	program->countUses(operation);
+	program->compileOperation(operation, true);
+
+	program->m_registers.clear();
+	program->m_uses.clear();
+	program->m_freeRegisters.clear();
+
+	/* a single pixel operation already runs without overhead in the row path */
+	if (program->m_numberOfProcessInstructions < 2) {
+		delete program;
+		return NULL;
+	}
+
+	return program;
+}
+
+void PixelProgram::countUses(NodeOperation *operation)
+{
+	this->m_uses[operation]++;
+
+	/* inputs of operations are only counted the first time the operation is reached */
+	if (this->m_uses[operation] > 1 || !operation->isPixelOperation()) {
+		return;
+	}
+
+	for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+		countUses(operation->getInputSocket(index)->getOperation());
+	}
+}
+
+int PixelProgram::allocateRegister()
+{
+	if (!this->m_freeRegisters.empty()) {
+		int reg = this->m_freeRegisters.back();
+		this->m_freeRegisters.pop_back();
+		return reg;
+	}
+
+	return this->m_numberOfRegisters++;
+}
+
+void PixelProgram::releaseRegister(NodeOperation *operation)
+{
+	/* constants are calculated once per chunk and never reused */
+	if (operation->isSetOperation()) {
+		return;
+	}
+
+	if (--this->m_uses[operation] == 0) {
+		this->m_freeRegisters.push_back(this->m_registers[operation]);
+	}
+}
+
+int PixelProgram::compileOperation(NodeOperation *operation, bool isOutput)
+{
+	map<NodeOperation *, int>::iterator found = this->m_registers.find(operation);
+
+	if (found != this->m_registers.end()) {
+		return found->second;
+	}
+
+	PixelInstruction instruction;
+	instruction.operation = operation;
+	instruction.numberOfInputs = 0;
+
+	if (operation->isPixelOperation()) {
+		instruction.opcode = COM_PO_PROCESS;
+		instruction.numberOfInputs = operation->getNumberOfInputSockets();
+
+		BLI_assert(instruction.numberOfInputs <= COM_MAX_PIXEL_INPUTS);
+
+		for (int index = 0; index < instruction.numberOfInputs; index++) {
+			instruction.inputs[index] = compileOperation(operation->getInputSocket(index)->getOperation(), false);
+		}
+
+		this->m_numberOfProcessInstructions++;
+	}
+	else if (operation->isSetOperation()) {
+		instruction.opcode = COM_PO_CONSTANT;
+	}
+	else {
+		instruction.opcode = COM_PO_READ;
+	}
+
+	/* the output is allocated before the inputs are released, operations
+	 * may read an input channel after writing the same channel of the output */
+	instruction.output = (isOutput) ? COM_PO_OUTPUT : allocateRegister();
+
+	for (int index = 0; index < instruction.numberOfInputs; index++) {
+		releaseRegister(operation->getInputSocket(index)->getOperation());
+	}
+
+	this->m_registers[operation] = instruction.output;
+	this->m_instructions.push_back(instruction);
+
+	return instruction.output;
+}
+
+float *PixelProgram::allocateRegisters()
+{
+	float *registers = (float *)MEM_mallocN(sizeof(float) * COM_ROW_BUFFER_SIZE * max(this->m_numberOfRegisters, 1), __func__);
+
+	for (unsigned int index = 0; index < this->m_instructions.size(); index++) {
+		PixelInstruction &instruction = this->m_instructions[index];
+
+		if (instruction.opcode == COM_PO_CONSTANT) {
+			instruction.operation->readRow(registers + instruction.output * COM_ROW_BUFFER_SIZE, 0, 0, COM_ROW_LENGTH);
+		}
+	}
+
+	return registers;
+}
+
+void PixelProgram::freeRegisters(float *registers)
+{
+	MEM_freeN(registers);
+}
+
+void PixelProgram::executeRow(float *registers, float *output, int x, int y, int length)
+{
+	float *inputs[COM_MAX_PIXEL_INPUTS];
+
+	for (unsigned int index = 0; index < this->m_instructions.size(); index++) {
+		PixelInstruction &instruction = this->m_instructions[index];
+		float *result = (instruction.output == COM_PO_OUTPUT) ? output : registers + instruction.output * COM_ROW_BUFFER_SIZE;
+
+		switch (instruction.opcode) {
+			case COM_PO_READ:
+				instruction.operation->readRow(result, x, y, length);
+				break;
+			case COM_PO_CONSTANT:
+				break;
+			case COM_PO_PROCESS:
+				for (int input = 0; input < instruction.numberOfInputs; input++) {
+					inputs[input] = registers + instruction.inputs[input] * COM_ROW_BUFFER_SIZE;
+				}
+				instruction.operation->processRow(result, inputs, length);
+				break;
+		}
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2011, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_PixelProgram_h_
+#define _COM_PixelProgram_h_
+
+#include <map>
+#include <vector>
+
+#include "COM_defines.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#include "MEM_guardedalloc.h"
+#endif
+
+using std::map;
+using std::vector;
+
+class NodeOperation;
+
+/**
+ * @brief kind of instruction in a PixelProgram
+ * @ingroup Execution
+ */
+typedef enum PixelOpcode {
+	/** @brief read a row from an operation that is not a pixel operation */
+	COM_PO_READ = 0,
+	/** @brief read a row from a set operation, once per chunk */
+	COM_PO_CONSTANT = 1,
+	/** @brief process rows of registers with a pixel operation */
+	COM_PO_PROCESS = 2
+} PixelOpcode;
+
+/**
+ * @brief register index of the program output, the row that is written to the output buffer
+ */
+#define COM_PO_OUTPUT -1
+
+typedef struct PixelInstruction {
+	PixelOpcode opcode;
+	NodeOperation *operation;
+	int output;
+	int inputs[COM_MAX_PIXEL_INPUTS];
+	int numberOfInputs;
+} PixelInstruction;
+
+/**
+ * @brief a chain of pixel operations flattened into a list of instructions
+ *
+ * Instead of every operation reading its inputs through the tree of operations, the tree is
+ * compiled once into instructions that run in order. Each instruction writes a row to a register,
+ * operations used by multiple others are only calculated once, and registers are reused as soon
+ * as all users have been processed.
+ *
+ * @see NodeOperation.isPixelOperation
+ * @see ExecutionGroup.initExecution
+ * @ingroup Execution
+ */
+class PixelProgram {
+private:
+	vector<PixelInstruction> m_instructions;
+	int m_numberOfRegisters;
+	int m_numberOfProcessInstructions;
+
+	/* compilation state */
+	map<NodeOperation *, int> m_registers;
+	map<NodeOperation *, int> m_uses;
+	vector<int> m_freeRegisters;
+
+	PixelProgram();
+
+	void countUses(NodeOperation *operation);
+	int compileOperation(NodeOperation *operation, bool isOutput);
+	int allocateRegister();
+	void releaseRegister(NodeOperation *operation);
+
+public:
+	/**
+	 * @brief compile the pixel operations ending in operation
+	 * @return the program or NULL if there are too few pixel operations to benefit
+	 */
+	static PixelProgram *compile(NodeOperation *operation);
+
+	/**
+	 * @brief allocate registers for one thread and calculate the constant registers
+	 */
+	float *allocateRegisters();
+	void freeRegisters(float *registers);
+
+	/**
+	 * @brief run the program for length pixels starting at x, y
+	 * @param registers allocated by allocateRegisters
+	 * @param output is a float array of length * COM_NUMBER_OF_CHANNELS to store the result
+	 */
+	void executeRow(float *registers, float *output, int x, int y, int length);
+
+	unsigned int getNumberOfInstructions() const { return this->m_instructions.size(); }
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("COM:PixelProgram")
+#endif
+};
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ * Copyright 2011, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <list>
+
+#include "COM_ResultCache.h"
+#include "COM_Node.h"
+#include "COM_InputSocket.h"
+#include "COM_OutputSocket.h"
+#include "COM_SocketConnection.h"
+#include "COM_MemoryBuffer.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "DNA_color_types.h"
+#include "DNA_node_types.h"
+#include "DNA_userdef_types.h"
+#include "BKE_global.h"
+#include "BKE_node.h"
+}
+
+using std::list;
+
+typedef struct ResultCacheEntry {
+	ResultHash hash;
+	MemoryBuffer *buffer;
+	size_t size;
+} ResultCacheEntry;
+
+/* most recently used entries are at the front */
+static list<ResultCacheEntry> s_entries;
+static map<ResultHash, list<ResultCacheEntry>::iterator> s_lookup;
+static size_t s_size = 0;
+
+static map<bNode *, unsigned int> s_generations;
+static unsigned int s_lastGeneration = 0;
+static Main *s_main = NULL;
+
+void ResultCache::begin()
+{
+	if (s_main != G.main) {
+		clear();
+		s_main = G.main;
+	}
+}
+
+ResultHash ResultCache::combine(ResultHash hash, const void *data, size_t size)
+{
+	/* FNV-1a */
+	const unsigned char *bytes = (const unsigned char *)data;
+	for (size_t index = 0; index < size; index++) {
+		hash ^= bytes[index];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+unsigned int ResultCache::getGeneration(bNode *node)
+{
+	/* nodes of localized trees are tagged, but are new copies every execution */
+	bNode *original = (node->original) ? node->original : node;
+	map<bNode *, unsigned int>::iterator found = s_generations.find(original);
+
+	if (found == s_generations.end() || node->need_exec) {
+		s_generations[original] = ++s_lastGeneration;
+		return s_lastGeneration;
+	}
+
+	return found->second;
+}
+
+bool ResultCache::isCacheable(bNode *node)
+{
+	/* ID data like masks, textures, movie clips and images can change without the
+	 * node being tagged. render layers are tagged when their scene is rendered */
+	return (node->id == NULL || node->type == CMP_NODE_R_LAYERS);
+}
+
+ResultHash ResultCache::hashCurveMapping(ResultHash hash, const CurveMapping *cumap)
+{
+	/* only the settings and points, the tables are derived from them and the
+	 * other flags are for drawing or set while evaluating */
+	int clip = (cumap->flag & CUMA_DO_CLIP);
+
+	hash = combine(hash, &clip, sizeof(clip));
+	hash = combine(hash, &cumap->preset, sizeof(cumap->preset));
+	hash = combine(hash, &cumap->clipr, sizeof(cumap->clipr));
+	hash = combine(hash, cumap->black, sizeof(cumap->black));
+	hash = combine(hash, cumap->white, sizeof(cumap->white));
+
+	for (int index = 0; index < CM_TOT; index++) {
+		const CurveMap *cuma = &cumap->cm[index];
+
+		hash = combine(hash, &cuma->totpoint, sizeof(cuma->totpoint));
+		hash = combine(hash, &cuma->flag, sizeof(cuma->flag));
+		hash = combine(hash, cuma->ext_in, sizeof(cuma->ext_in));
+		hash = combine(hash, cuma->ext_out, sizeof(cuma->ext_out));
+
+		for (int point = 0; point < cuma->totpoint; point++) {
+			hash = combine(hash, &cuma->curve[point].x, sizeof(float));
+			hash = combine(hash, &cuma->curve[point].y, sizeof(float));
+			hash = combine(hash, &cuma->curve[point].flag, sizeof(short));
+		}
+	}
+
+	return hash;
+}
+
+ResultHash ResultCache::hashStorage(ResultHash hash, bNode *node)
+{
+	switch (node->type) {
+		case CMP_NODE_CURVE_VEC:
+		case CMP_NODE_CURVE_RGB:
+		case CMP_NODE_TIME:
+		case CMP_NODE_HUECORRECT:
+			return hashCurveMapping(hash, (CurveMapping *)node->storage);
+		case CMP_NODE_BLUR:
+		case CMP_NODE_VECBLUR:
+		{
+			/* the blur operations write the input size and relative sizes */
+			NodeBlurData data = *(NodeBlurData *)node->storage;
+			data.image_in_width = 0;
+			data.image_in_height = 0;
+			if (data.relative) {
+				data.sizex = 0;
+				data.sizey = 0;
+			}
+			return combine(hash, &data, sizeof(data));
+		}
+		default:
+			/* storage of the other cacheable nodes only holds settings, no pointers */
+			return combine(hash, node->storage, MEM_allocN_len(node->storage));
+	}
+}
+
+ResultHash ResultCache::hashNode(Node *node, ResultHash seed, map<Node *, ResultHash> &hashes)
+{
+	map<Node *, ResultHash>::iterator found = hashes.find(node);
+	if (found != hashes.end()) {
+		return found->second;
+	}
+
+	ResultHash hash = seed;
+	bNode *bnode = node->getbNode();
+
+	if (bnode) {
+		if (!isCacheable(bnode)) {
+			hashes[node] = 0;
+			return 0;
+		}
+
+		unsigned int generation = getGeneration(bnode);
+
+		hash = combine(hash, &generation, sizeof(generation));
+		hash = combine(hash, &bnode->type, sizeof(bnode->type));
+		hash = combine(hash, &bnode->id, sizeof(bnode->id));
+		hash = combine(hash, &bnode->custom1, sizeof(bnode->custom1));
+		hash = combine(hash, &bnode->custom2, sizeof(bnode->custom2));
+		hash = combine(hash, &bnode->custom3, sizeof(bnode->custom3));
+		hash = combine(hash, &bnode->custom4, sizeof(bnode->custom4));
+		if (bnode->storage) {
+			hash = hashStorage(hash, bnode);
+		}
+	}
+
+	for (unsigned int index = 0; index < node->getNumberOfInputSockets(); index++) {
+		InputSocket *socket = node->getInputSocket(index);
+
+		if (socket->isConnected()) {
+			SocketConnection *connection = socket->getConnection();
+			Node *fromNode = (Node *)connection->getFromNode();
+			OutputSocket *fromSocket = connection->getFromSocket();
+			ResultHash fromHash = hashNode(fromNode, seed, hashes);
+			unsigned int fromIndex = 0;
+
+			/* results depending on uncacheable nodes are not cached either */
+			if (fromHash == 0) {
+				hashes[node] = 0;
+				return 0;
+			}
+
+			while (fromIndex < fromNode->getNumberOfOutputSockets() && fromNode->getOutputSocket(fromIndex) != fromSocket) {
+				fromIndex++;
+			}
+
+			hash = combine(hash, &fromHash, sizeof(fromHash));
+			hash = combine(hash, &fromIndex, sizeof(fromIndex));
+		}
+		else {
+			bNodeSocket *bsocket = socket->getbNodeSocket();
+			if (bsocket && bsocket->default_value) {
+				hash = combine(hash, bsocket->default_value, MEM_allocN_len(bsocket->default_value));
+			}
+		}
+	}
+
+	hashes[node] = hash;
+	return hash;
+}
+
+MemoryBuffer *ResultCache::lookup(ResultHash hash)
+{
+	map<ResultHash, list<ResultCacheEntry>::iterator>::iterator found = s_lookup.find(hash);
+
+	if (found == s_lookup.end()) {
+		return NULL;
+	}
+
+	s_entries.splice(s_entries.begin(), s_entries, found->second);
+	return found->second->buffer;
+}
+
+void ResultCache::store(ResultHash hash, MemoryBuffer *buffer)
+{
+	const size_t limit = ((size_t)U.memcachelimit) * 1024 * 1024;
+	const size_t size = buffer->getMemorySize();
+
+	if (size > limit || s_lookup.find(hash) != s_lookup.end()) {
+		delete buffer;
+		return;
+	}
+
+	while (s_size + size > limit) {
+		ResultCacheEntry &entry = s_entries.back();
+		s_lookup.erase(entry.hash);
+		s_size -= entry.size;
+		delete entry.buffer;
+		s_entries.pop_back();
+	}
+
+	ResultCacheEntry entry;
+	entry.hash = hash;
+	entry.buffer = buffer;
+	entry.size = size;
+
+	s_entries.push_front(entry);
+	s_lookup[hash] = s_entries.begin();
+	s_size += size;
+}
+
+void ResultCache::clear()
+{
+	while (!s_entries.empty()) {
+		delete s_entries.back().buffer;
+		s_entries.pop_back();
+	}
+	s_lookup.clear();
+	s_size = 0;
+	s_generations.clear();
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2011, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_ResultCache_h_
+#define _COM_ResultCache_h_
+
+#include <map>
+#include <stddef.h>
+
+#include "BLI_sys_types.h"
+
+using std::map;
+
+class Node;
+class MemoryBuffer;
+struct bNode;
+struct CurveMapping;
+
+/**
+ * @brief hash identifying the result of an operation
+ * @note 0 is used for operations that can not be cached
+ */
+typedef uint64_t ResultHash;
+
+/**
+ * @brief cache of results of complex operations across executions
+ *
+ * During editing every change rebuilds the ExecutionSystem and recalculates all operations.
+ * The results of complex operations are stored here after an execution, keyed by a hash of the
+ * settings of the node, the hashes of all nodes upstream and the settings of the execution.
+ * When the next execution finds a result, the ExecutionGroup calculating it is not executed.
+ *
+ * Changes outside the node tree (renders, image reloads, animation) are detected using the
+ * update tags of the nodes: every tagged node gets a new generation, that is part of its hash.
+ *
+ * Results are evicted least recently used first when the memory cache limit is exceeded.
+ * @ingroup Memory
+ */
+class ResultCache {
+public:
+	/**
+	 * @brief start a new execution
+	 * @note clears the cache when another file is loaded
+	 */
+	static void begin();
+
+	/**
+	 * @brief calculate the hash of a node and all nodes upstream
+	 * @param hashes stores the hashes of nodes that are already calculated
+	 * @return 0 when the result of the node can't be cached
+	 */
+	static ResultHash hashNode(Node *node, ResultHash seed, map<Node *, ResultHash> &hashes);
+
+	/**
+	 * @brief combine a hash with the given data
+	 */
+	static ResultHash combine(ResultHash hash, const void *data, size_t size);
+
+	/**
+	 * @brief find a cached result
+	 * @return the MemoryBuffer (owned by the cache) or NULL when not found
+	 */
+	static MemoryBuffer *lookup(ResultHash hash);
+
+	/**
+	 * @brief store a result in the cache
+	 * @note the cache takes ownership of the buffer
+	 */
+	static void store(ResultHash hash, MemoryBuffer *buffer);
+
+	/**
+	 * @brief free all cached results
+	 */
+	static void clear();
+
+private:
+	static unsigned int getGeneration(bNode *node);
+	static bool isCacheable(bNode *node);
+	static ResultHash hashStorage(ResultHash hash, bNode *node);
+	static ResultHash hashCurveMapping(ResultHash hash, const CurveMapping *cumap);
+};
+
+#endif
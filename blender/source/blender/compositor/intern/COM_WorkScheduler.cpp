@@ -21,6 +21,7 @@
  */
 
 #include <list>
+#include <deque>
 #include <stdio.h>
 
 #include "COM_compositor.h"
@@ -38,6 +39,8 @@
 
 #include "BKE_global.h"
 
+#include "atomic_ops.h"
+
 #if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
 #  ifndef DEBUG  /* test this so we dont get warnings in debug builds */
 #    warning COM_CURRENT_THREADING_MODEL COM_TM_NOTHREAD is activated. Use only for debugging.
@@ -56,8 +59,24 @@ static vector<CPUDevice *> g_cpudevices;
 /// @brief list of all thread for every CPUDevice in cpudevices a thread exists
 static ListBase g_cputhreads;
 static bool g_cpuInitialized = false;
-/// @brief all scheduled work for the cpu
-static ThreadQueue *g_cpuqueue;
+/// @brief scheduled work of a CPUDevice, devices without work steal from the back of other queues
+typedef struct CPUWorkQueue {
+	SpinLock lock;
+	deque<WorkPackage *> packages;
+} CPUWorkQueue;
+/// @brief all scheduled work for the cpu, a queue for every CPUDevice in cpudevices
+static vector<CPUWorkQueue *> g_cpuqueues;
+/// @brief used to wait for new work and for finished work, only locked when a thread waits
+static ThreadMutex g_workMutex;
+static ThreadCondition g_workCondition;
+static ThreadCondition g_finishCondition;
+/// @brief counters are changed atomically, so scheduling and finishing work doesn't need the lock
+static uint32_t g_numberOfWaitingDevices;
+static uint32_t g_numberOfUnfinishedPackages;
+static uint32_t g_numberOfFinishedPackages;
+static uint32_t g_schedulerWaiting;
+static unsigned int g_numberOfSeenPackages;
+static bool g_stopping;
 static ThreadQueue *g_gpuqueue;
 #ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
@@ -141,15 +160,102 @@ int COM_isHighlightedbNode(bNode *bnode)
 } // end extern "C"
 
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+static WorkPackage *cpu_queue_pop(unsigned int index)
+{
+	CPUWorkQueue *queue = g_cpuqueues[index];
+	WorkPackage *work = NULL;
+
+	/* the front holds the work that was scheduled first, following the ChunkOrder */
+	BLI_spin_lock(&queue->lock);
+	if (!queue->packages.empty()) {
+		work = queue->packages.front();
+		queue->packages.pop_front();
+	}
+	BLI_spin_unlock(&queue->lock);
+
+	return work;
+}
+
+static WorkPackage *cpu_queue_steal(unsigned int index)
+{
+	const unsigned int numberOfQueues = g_cpuqueues.size();
+	WorkPackage *work = NULL;
+
+	/* steal the least urgent work, starting at the next device to spread the stealing */
+	for (unsigned int offset = 1; offset < numberOfQueues && work == NULL; offset++) {
+		CPUWorkQueue *queue = g_cpuqueues[(index + offset) % numberOfQueues];
+
+		BLI_spin_lock(&queue->lock);
+		if (!queue->packages.empty()) {
+			work = queue->packages.back();
+			queue->packages.pop_back();
+		}
+		BLI_spin_unlock(&queue->lock);
+	}
+
+	return work;
+}
+
+static WorkPackage *cpu_queue_next(unsigned int index)
+{
+	WorkPackage *work = cpu_queue_pop(index);
+	return (work) ? work : cpu_queue_steal(index);
+}
+
+/* adding zero reads with a full memory barrier. a thread changes a counter
+ * and then reads if anyone waits, a waiting thread flags that and then reads
+ * the counter, so at least one of them sees the change of the other */
+static uint32_t atomic_read(uint32_t *value)
+{
+	return atomic_add_uint32(value, 0);
+}
+
+static void work_finished()
+{
+	atomic_add_uint32(&g_numberOfFinishedPackages, 1);
+	atomic_sub_uint32(&g_numberOfUnfinishedPackages, 1);
+
+	/* only the scheduling thread waits for finished work */
+	if (atomic_read(&g_schedulerWaiting)) {
+		BLI_mutex_lock(&g_workMutex);
+		BLI_condition_notify_one(&g_finishCondition);
+		BLI_mutex_unlock(&g_workMutex);
+	}
+}
+
 void *WorkScheduler::thread_execute_cpu(void *data)
 {
 	Device *device = (Device *)data;
 	WorkPackage *work;
-	
-	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
+	unsigned int index = 0;
+
+	while (g_cpudevices[index] != device) {
+		index++;
+	}
+
+	while (true) {
+		work = cpu_queue_next(index);
+
+		if (work == NULL) {
+			/* count as waiting before checking the queues again, so work scheduled
+			 * in between is either found here or wakes this device */
+			BLI_mutex_lock(&g_workMutex);
+			atomic_add_uint32(&g_numberOfWaitingDevices, 1);
+			while (!g_stopping && (work = cpu_queue_next(index)) == NULL) {
+				BLI_condition_wait(&g_workCondition, &g_workMutex);
+			}
+			atomic_sub_uint32(&g_numberOfWaitingDevices, 1);
+			BLI_mutex_unlock(&g_workMutex);
+
+			if (work == NULL) {
+				break;
+			}
+		}
+
 		HIGHLIGHT(work);
 		device->execute(work);
 		delete work;
+		work_finished();
 	}
 	
 	return NULL;
@@ -164,6 +270,7 @@ void *WorkScheduler::thread_execute_gpu(void *data)
 		HIGHLIGHT(work);
 		device->execute(work);
 		delete work;
+		work_finished();
 	}
 	
 	return NULL;
@@ -180,16 +287,26 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
 	device.execute(package);
 	delete package;
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+	atomic_add_uint32(&g_numberOfUnfinishedPackages, 1);
+
 #ifdef COM_OPENCL_ENABLED
 	if (group->isOpenCL() && g_openclActive) {
 		BLI_thread_queue_push(g_gpuqueue, package);
+		return;
 	}
-	else {
-		BLI_thread_queue_push(g_cpuqueue, package);
-	}
-#else
-	BLI_thread_queue_push(cpuqueue, package);
 #endif
+
+	/* neighbouring chunks go to the same device */
+	CPUWorkQueue *queue = g_cpuqueues[group->getChunkBlock(chunkNumber) % g_cpuqueues.size()];
+	BLI_spin_lock(&queue->lock);
+	queue->packages.push_back(package);
+	BLI_spin_unlock(&queue->lock);
+
+	if (atomic_read(&g_numberOfWaitingDevices) > 0) {
+		BLI_mutex_lock(&g_workMutex);
+		BLI_condition_notify_one(&g_workCondition);
+		BLI_mutex_unlock(&g_workMutex);
+	}
 #endif
 }
 
@@ -197,7 +314,20 @@ void WorkScheduler::start(CompositorContext &context)
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 	unsigned int index;
-	g_cpuqueue = BLI_thread_queue_init();
+	BLI_mutex_init(&g_workMutex);
+	BLI_condition_init(&g_workCondition);
+	BLI_condition_init(&g_finishCondition);
+	g_numberOfWaitingDevices = 0;
+	g_numberOfUnfinishedPackages = 0;
+	g_numberOfFinishedPackages = 0;
+	g_schedulerWaiting = 0;
+	g_numberOfSeenPackages = 0;
+	g_stopping = false;
+	for (index = 0; index < g_cpudevices.size(); index++) {
+		CPUWorkQueue *queue = new CPUWorkQueue();
+		BLI_spin_init(&queue->lock);
+		g_cpuqueues.push_back(queue);
+	}
 	BLI_init_threads(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
 	for (index = 0; index < g_cpudevices.size(); index++) {
 		Device *device = g_cpudevices[index];
@@ -222,26 +352,48 @@ void WorkScheduler::start(CompositorContext &context)
 void WorkScheduler::finish()
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-#ifdef COM_OPENCL_ENABLED
-	if (g_openclActive) {
-		BLI_thread_queue_wait_finish(g_gpuqueue);
-		BLI_thread_queue_wait_finish(g_cpuqueue);
-	}
-	else {
-		BLI_thread_queue_wait_finish(g_cpuqueue);
+	BLI_mutex_lock(&g_workMutex);
+	atomic_add_uint32(&g_schedulerWaiting, 1);
+	while (atomic_read(&g_numberOfUnfinishedPackages) > 0) {
+		BLI_condition_wait(&g_finishCondition, &g_workMutex);
 	}
-#else
-	BLI_thread_queue_wait_finish(cpuqueue);
+	atomic_sub_uint32(&g_schedulerWaiting, 1);
+	g_numberOfSeenPackages = atomic_read(&g_numberOfFinishedPackages);
+	BLI_mutex_unlock(&g_workMutex);
 #endif
+}
+void WorkScheduler::waitForProgress()
+{
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+	BLI_mutex_lock(&g_workMutex);
+	atomic_add_uint32(&g_schedulerWaiting, 1);
+	while (atomic_read(&g_numberOfUnfinishedPackages) > 0 &&
+	       atomic_read(&g_numberOfFinishedPackages) == g_numberOfSeenPackages)
+	{
+		BLI_condition_wait(&g_finishCondition, &g_workMutex);
+	}
+	atomic_sub_uint32(&g_schedulerWaiting, 1);
+	g_numberOfSeenPackages = atomic_read(&g_numberOfFinishedPackages);
+	BLI_mutex_unlock(&g_workMutex);
 #endif
 }
 void WorkScheduler::stop()
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-	BLI_thread_queue_nowait(g_cpuqueue);
+	BLI_mutex_lock(&g_workMutex);
+	g_stopping = true;
+	BLI_condition_notify_all(&g_workCondition);
+	BLI_mutex_unlock(&g_workMutex);
 	BLI_end_threads(&g_cputhreads);
-	BLI_thread_queue_free(g_cpuqueue);
-	g_cpuqueue = NULL;
+	while (g_cpuqueues.size() > 0) {
+		CPUWorkQueue *queue = g_cpuqueues.back();
+		g_cpuqueues.pop_back();
+		BLI_spin_end(&queue->lock);
+		delete queue;
+	}
+	BLI_condition_end(&g_workCondition);
+	BLI_condition_end(&g_finishCondition);
+	BLI_mutex_end(&g_workMutex);
 #ifdef COM_OPENCL_ENABLED
 	if (g_openclActive) {
 		BLI_thread_queue_nowait(g_gpuqueue);
@@ -44,7 +44,8 @@ class WorkScheduler {
 
 	/**
 	 * @brief main thread loop for cpudevices
-	 * inside this loop new work is queried and being executed
+	 * inside this loop new work is taken from the queue of the device,
+	 * or stolen from the queue of another device, and executed
 	 */
 	static void *thread_execute_cpu(void *data);
 
@@ -105,6 +106,13 @@ public:
 	 */
 	static void finish();
 
+	/**
+	 * @brief wait until a WorkPackage has finished since the last call, or all work is completed.
+	 * @note only to be called from the thread scheduling the work
+	 * @see ExecutionGroup.execute
+	 */
+	static void waitForProgress();
+
 	/**
 	 * @brief Are there OpenCL capable GPU devices initialized?
 	 * the result of this method is stored in the CompositorContext
@@ -31,6 +31,7 @@ extern "C" {
 #include "COM_compositor.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_WorkScheduler.h"
+#include "COM_ResultCache.h"
 #include "OCL_opencl.h"
 #include "COM_MovieDistortionOperation.h"
 
@@ -40,6 +41,7 @@ static char is_compositorMutex_init = FALSE;
 static void intern_freeCompositorCaches()
 {
 	deintializeDistortionCache();
+	ResultCache::clear();
 }
 
 void COM_execute(RenderData *rd, bNodeTree *editingtree, int rendering,
@@ -27,16 +27,8 @@ AlphaOverKeyOperation::AlphaOverKeyOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void AlphaOverKeyOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void AlphaOverKeyOperation::processPixel(float output[4], float value[4], float inputColor1[4], float inputOverColor[4])
 {
-	float inputColor1[4];
-	float inputOverColor[4];
-	float value[4];
-	
-	this->m_inputValueOperation->read(value, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputOverColor, x, y, sampler);
-	
 	if (inputOverColor[3] <= 0.0f) {
 		copy_v4_v4(output, inputColor1);
 	}
@@ -39,7 +39,8 @@ public:
 	/**
 	 * the inner loop of this program
 	 */
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float value[4], float inputColor1[4], float inputOverColor[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 
 };
 #endif
@@ -29,6 +29,7 @@ BrightnessOperation::BrightnessOperation() : NodeOperation()
 	this->addInputSocket(COM_DT_VALUE);
 	this->addOutputSocket(COM_DT_COLOR);
 	this->m_inputProgram = NULL;
+	this->setPixelOperation(true);
 }
 void BrightnessOperation::initExecution()
 {
@@ -40,12 +41,27 @@ void BrightnessOperation::initExecution()
 void BrightnessOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue[4];
-	float a, b;
 	float inputBrightness[4];
 	float inputContrast[4];
+
 	this->m_inputProgram->read(inputValue, x, y, sampler);
 	this->m_inputBrightnessProgram->read(inputBrightness, x, y, sampler);
 	this->m_inputContrastProgram->read(inputContrast, x, y, sampler);
+
+	processPixel(output, inputValue, inputBrightness, inputContrast);
+}
+
+void BrightnessOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset, inputs[1] + offset, inputs[2] + offset);
+	}
+}
+
+void BrightnessOperation::processPixel(float output[4], float inputValue[4], float inputBrightness[4], float inputContrast[4])
+{
+	float a, b;
 	float brightness = inputBrightness[0];
 	float contrast = inputContrast[0];
 	brightness /= 100.0f;
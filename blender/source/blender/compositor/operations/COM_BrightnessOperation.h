@@ -41,6 +41,12 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
+
+	/**
+	 * calculate a single pixel from the input values
+	 */
+	void processPixel(float output[4], float inputValue[4], float inputBrightness[4], float inputContrast[4]);
 	
 	/**
 	 * Initialize the execution
@@ -27,6 +27,7 @@ ChangeHSVOperation::ChangeHSVOperation() : NodeOperation()
 	this->addInputSocket(COM_DT_COLOR);
 	this->addOutputSocket(COM_DT_COLOR);
 	this->m_inputOperation = NULL;
+	this->setPixelOperation(true);
 }
 
 void ChangeHSVOperation::initExecution()
@@ -42,9 +43,22 @@ void ChangeHSVOperation::deinitExecution()
 void ChangeHSVOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputColor1[4];
-	
+
 	this->m_inputOperation->read(inputColor1, x, y, sampler);
-	
+
+	processPixel(output, inputColor1);
+}
+
+void ChangeHSVOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset);
+	}
+}
+
+void ChangeHSVOperation::processPixel(float output[4], float inputColor1[4])
+{
 	output[0] = inputColor1[0] + (this->m_hue - 0.5f);
 	if      (output[0] > 1.0f) output[0] -= 1.0f;
 	else if (output[0] < 0.0f) output[0] += 1.0f;
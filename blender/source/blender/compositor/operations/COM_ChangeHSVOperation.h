@@ -50,6 +50,12 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
+
+	/**
+	 * calculate a single pixel from the input values
+	 */
+	void processPixel(float output[4], float inputColor1[4]);
 
 	void setHue(float hue) { this->m_hue = hue; }
 	void setSaturation(float saturation) { this->m_saturation = saturation; }
@@ -46,6 +46,7 @@ ColorBalanceLGGOperation::ColorBalanceLGGOperation() : NodeOperation()
 	this->m_inputValueOperation = NULL;
 	this->m_inputColorOperation = NULL;
 	this->setResolutionInputSocketIndex(1);
+	this->setPixelOperation(true);
 }
 
 void ColorBalanceLGGOperation::initExecution()
@@ -56,12 +57,25 @@ void ColorBalanceLGGOperation::initExecution()
 
 void ColorBalanceLGGOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
-	float inputColor[4];
 	float value[4];
-	
+	float inputColor[4];
+
 	this->m_inputValueOperation->read(value, x, y, sampler);
 	this->m_inputColorOperation->read(inputColor, x, y, sampler);
-	
+
+	processPixel(output, value, inputColor);
+}
+
+void ColorBalanceLGGOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset, inputs[1] + offset);
+	}
+}
+
+void ColorBalanceLGGOperation::processPixel(float output[4], float value[4], float inputColor[4])
+{
 	float fac = value[0];
 	fac = min(1.0f, fac);
 	const float mfac = 1.0f - fac;
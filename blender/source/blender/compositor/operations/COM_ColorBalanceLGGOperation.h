@@ -51,6 +51,12 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
+
+	/**
+	 * calculate a single pixel from the input values
+	 */
+	void processPixel(float output[4], float value[4], float inputColor[4]);
 	
 	/**
 	 * Initialize the execution
@@ -33,6 +33,7 @@ ColorCorrectionOperation::ColorCorrectionOperation() : NodeOperation()
 	this->m_redChannelEnabled = true;
 	this->m_greenChannelEnabled = true;
 	this->m_blueChannelEnabled = true;
+	this->setPixelOperation(true);
 }
 void ColorCorrectionOperation::initExecution()
 {
@@ -44,9 +45,23 @@ void ColorCorrectionOperation::executePixel(float output[4], float x, float y, P
 {
 	float inputImageColor[4];
 	float inputMask[4];
+
 	this->m_inputImage->read(inputImageColor, x, y, sampler);
 	this->m_inputMask->read(inputMask, x, y, sampler);
-	
+
+	processPixel(output, inputImageColor, inputMask);
+}
+
+void ColorCorrectionOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset, inputs[1] + offset);
+	}
+}
+
+void ColorCorrectionOperation::processPixel(float output[4], float inputImageColor[4], float inputMask[4])
+{
 	float level = (inputImageColor[0] + inputImageColor[1] + inputImageColor[2]) / 3.0f;
 	float contrast = this->m_data->master.contrast;
 	float saturation = this->m_data->master.saturation;
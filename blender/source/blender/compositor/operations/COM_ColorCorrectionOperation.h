@@ -45,6 +45,12 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
+
+	/**
+	 * calculate a single pixel from the input values
+	 */
+	void processPixel(float output[4], float inputImageColor[4], float inputMask[4]);
 	
 	/**
 	 * Initialize the execution
@@ -45,6 +45,7 @@ ColorCurveOperation::ColorCurveOperation() : CurveBaseOperation()
 	this->m_inputWhiteProgram = NULL;
 
 	this->setResolutionInputSocketIndex(1);
+	this->setPixelOperation(true);
 }
 void ColorCurveOperation::initExecution()
 {
@@ -60,26 +61,38 @@ void ColorCurveOperation::initExecution()
 
 void ColorCurveOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
-	CurveMapping *cumap = this->m_curveMapping;
-	
 	float fac[4];
 	float image[4];
-
-	/* local versions of cumap->black, cumap->white, cumap->bwmul */
 	float black[4];
 	float white[4];
-	float bwmul[3];
 
+	this->m_inputFacProgram->read(fac, x, y, sampler);
+	this->m_inputImageProgram->read(image, x, y, sampler);
 	this->m_inputBlackProgram->read(black, x, y, sampler);
 	this->m_inputWhiteProgram->read(white, x, y, sampler);
 
+	processPixel(output, fac, image, black, white);
+}
+
+void ColorCurveOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset, inputs[1] + offset, inputs[2] + offset, inputs[3] + offset);
+	}
+}
+
+void ColorCurveOperation::processPixel(float output[4], float fac[4], float image[4], float black[4], float white[4])
+{
+	CurveMapping *cumap = this->m_curveMapping;
+
+	/* local version of cumap->bwmul */
+	float bwmul[3];
+
 	/* get our own local bwmul value,
 	 * since we can't be threadsafe and use cumap->bwmul & friends */
 	curvemapping_set_black_white_ex(black, white, bwmul);
 
-	this->m_inputFacProgram->read(fac, x, y, sampler);
-	this->m_inputImageProgram->read(image, x, y, sampler);
-
 	if (*fac >= 1.0f) {
 		curvemapping_evaluate_premulRGBF_ex(cumap, output, image,
 		                                    black, bwmul);
@@ -118,6 +131,7 @@ ConstantLevelColorCurveOperation::ConstantLevelColorCurveOperation() : CurveBase
 	this->m_inputImageProgram = NULL;
 
 	this->setResolutionInputSocketIndex(1);
+	this->setPixelOperation(true);
 }
 void ConstantLevelColorCurveOperation::initExecution()
 {
@@ -138,6 +152,19 @@ void ConstantLevelColorCurveOperation::executePixel(float output[4], float x, fl
 	this->m_inputFacProgram->read(fac, x, y, sampler);
 	this->m_inputImageProgram->read(image, x, y, sampler);
 
+	processPixel(output, fac, image);
+}
+
+void ConstantLevelColorCurveOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset, inputs[1] + offset);
+	}
+}
+
+void ConstantLevelColorCurveOperation::processPixel(float output[4], float fac[4], float image[4])
+{
 	if (*fac >= 1.0f) {
 		curvemapping_evaluate_premulRGBF(this->m_curveMapping, output, image);
 	}
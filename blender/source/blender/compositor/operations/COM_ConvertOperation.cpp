@@ -45,12 +45,28 @@ ConvertValueToColorOperation::ConvertValueToColorOperation() : ConvertBaseOperat
 {
 	this->addInputSocket(COM_DT_VALUE);
 	this->addOutputSocket(COM_DT_COLOR);
+	this->setPixelOperation(true);
 }
 
 void ConvertValueToColorOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue[4];
+
 	this->m_inputOperation->read(inputValue, x, y, sampler);
+
+	processPixel(output, inputValue);
+}
+
+void ConvertValueToColorOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset);
+	}
+}
+
+void ConvertValueToColorOperation::processPixel(float output[4], float inputValue[4])
+{
 	output[0] = output[1] = output[2] = inputValue[0];
 	output[3] = 1.0f;
 }
@@ -62,12 +78,28 @@ ConvertColorToValueOperation::ConvertColorToValueOperation() : ConvertBaseOperat
 {
 	this->addInputSocket(COM_DT_COLOR);
 	this->addOutputSocket(COM_DT_VALUE);
+	this->setPixelOperation(true);
 }
 
 void ConvertColorToValueOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputColor[4];
+
 	this->m_inputOperation->read(inputColor, x, y, sampler);
+
+	processPixel(output, inputColor);
+}
+
+void ConvertColorToValueOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset);
+	}
+}
+
+void ConvertColorToValueOperation::processPixel(float output[4], float inputColor[4])
+{
 	output[0] = (inputColor[0] + inputColor[1] + inputColor[2]) / 3.0f;
 }
 
@@ -78,12 +110,28 @@ ConvertColorToBWOperation::ConvertColorToBWOperation() : ConvertBaseOperation()
 {
 	this->addInputSocket(COM_DT_COLOR);
 	this->addOutputSocket(COM_DT_VALUE);
+	this->setPixelOperation(true);
 }
 
 void ConvertColorToBWOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputColor[4];
+
 	this->m_inputOperation->read(inputColor, x, y, sampler);
+
+	processPixel(output, inputColor);
+}
+
+void ConvertColorToBWOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset);
+	}
+}
+
+void ConvertColorToBWOperation::processPixel(float output[4], float inputColor[4])
+{
 	output[0] = rgb_to_bw(inputColor);
 }
 
@@ -94,6 +142,7 @@ ConvertColorToVectorOperation::ConvertColorToVectorOperation() : ConvertBaseOper
 {
 	this->addInputSocket(COM_DT_COLOR);
 	this->addOutputSocket(COM_DT_VECTOR);
+	this->setPixelOperation(true);
 }
 
 void ConvertColorToVectorOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
@@ -101,6 +150,11 @@ void ConvertColorToVectorOperation::executePixel(float output[4], float x, float
 	this->m_inputOperation->read(output, x, y, sampler);
 }
 
+void ConvertColorToVectorOperation::processRow(float *output, float **inputs, int length)
+{
+	memcpy(output, inputs[0], sizeof(float) * COM_NUMBER_OF_CHANNELS * length);
+}
+
 
 /* ******** Value to Vector ******** */
 
@@ -108,12 +162,28 @@ ConvertValueToVectorOperation::ConvertValueToVectorOperation() : ConvertBaseOper
 {
 	this->addInputSocket(COM_DT_VALUE);
 	this->addOutputSocket(COM_DT_VECTOR);
+	this->setPixelOperation(true);
 }
 
 void ConvertValueToVectorOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float input[4];
+
 	this->m_inputOperation->read(input, x, y, sampler);
+
+	processPixel(output, input);
+}
+
+void ConvertValueToVectorOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset);
+	}
+}
+
+void ConvertValueToVectorOperation::processPixel(float output[4], float input[4])
+{
 	output[0] = input[0];
 	output[1] = input[0];
 	output[2] = input[0];
@@ -127,6 +197,7 @@ ConvertVectorToColorOperation::ConvertVectorToColorOperation() : ConvertBaseOper
 {
 	this->addInputSocket(COM_DT_VECTOR);
 	this->addOutputSocket(COM_DT_COLOR);
+	this->setPixelOperation(true);
 }
 
 void ConvertVectorToColorOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
@@ -135,6 +206,15 @@ void ConvertVectorToColorOperation::executePixel(float output[4], float x, float
 	output[3] = 1.0f;
 }
 
+void ConvertVectorToColorOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		copy_v3_v3(output + offset, inputs[0] + offset);
+		output[offset + 3] = 1.0f;
+	}
+}
+
 
 /* ******** Vector to Value ******** */
 
@@ -142,12 +222,28 @@ ConvertVectorToValueOperation::ConvertVectorToValueOperation() : ConvertBaseOper
 {
 	this->addInputSocket(COM_DT_VECTOR);
 	this->addOutputSocket(COM_DT_VALUE);
+	this->setPixelOperation(true);
 }
 
 void ConvertVectorToValueOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float input[4];
+
 	this->m_inputOperation->read(input, x, y, sampler);
+
+	processPixel(output, input);
+}
+
+void ConvertVectorToValueOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset);
+	}
+}
+
+void ConvertVectorToValueOperation::processPixel(float output[4], float input[4])
+{
 	output[0] = (input[0] + input[1] + input[2]) / 3.0f;
 }
 
@@ -43,6 +43,8 @@ public:
 	ConvertValueToColorOperation();
 	
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
+	void processPixel(float output[4], float inputValue[4]);
 };
 
 
@@ -51,6 +53,8 @@ public:
 	ConvertColorToValueOperation();
 	
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
+	void processPixel(float output[4], float inputColor[4]);
 };
 
 
@@ -59,6 +63,8 @@ public:
 	ConvertColorToBWOperation();
 	
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
+	void processPixel(float output[4], float inputColor[4]);
 };
 
 
@@ -67,6 +73,7 @@ public:
 	ConvertColorToVectorOperation();
 	
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
 };
 
 
@@ -75,6 +82,8 @@ public:
 	ConvertValueToVectorOperation();
 	
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
+	void processPixel(float output[4], float input[4]);
 };
 
 
@@ -83,6 +92,7 @@ public:
 	ConvertVectorToColorOperation();
 	
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
 };
 
 
@@ -91,6 +101,8 @@ public:
 	ConvertVectorToValueOperation();
 	
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
+	void processPixel(float output[4], float input[4]);
 };
 
 
@@ -30,6 +30,7 @@ GammaOperation::GammaOperation() : NodeOperation()
 	this->addOutputSocket(COM_DT_COLOR);
 	this->m_inputProgram = NULL;
 	this->m_inputGammaProgram = NULL;
+	this->setPixelOperation(true);
 }
 void GammaOperation::initExecution()
 {
@@ -41,9 +42,23 @@ void GammaOperation::executePixel(float output[4], float x, float y, PixelSample
 {
 	float inputValue[4];
 	float inputGamma[4];
-	
+
 	this->m_inputProgram->read(inputValue, x, y, sampler);
 	this->m_inputGammaProgram->read(inputGamma, x, y, sampler);
+
+	processPixel(output, inputValue, inputGamma);
+}
+
+void GammaOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset, inputs[1] + offset);
+	}
+}
+
+void GammaOperation::processPixel(float output[4], float inputValue[4], float inputGamma[4])
+{
 	const float gamma = inputGamma[0];
 	/* check for negative to avoid nan's */
 	output[0] = inputValue[0] > 0.0f ? powf(inputValue[0], gamma) : inputValue[0];
@@ -32,6 +32,7 @@ InvertOperation::InvertOperation() : NodeOperation()
 	this->m_color = true;
 	this->m_alpha = false;
 	setResolutionInputSocketIndex(1);
+	this->setPixelOperation(true);
 }
 void InvertOperation::initExecution()
 {
@@ -43,9 +44,23 @@ void InvertOperation::executePixel(float output[4], float x, float y, PixelSampl
 {
 	float inputValue[4];
 	float inputColor[4];
+
 	this->m_inputValueProgram->read(inputValue, x, y, sampler);
 	this->m_inputColorProgram->read(inputColor, x, y, sampler);
-	
+
+	processPixel(output, inputValue, inputColor);
+}
+
+void InvertOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		processPixel(output + offset, inputs[0] + offset, inputs[1] + offset);
+	}
+}
+
+void InvertOperation::processPixel(float output[4], float inputValue[4], float inputColor[4])
+{
 	const float value = inputValue[0];
 	const float invertedValue = 1.0f - value;
 	
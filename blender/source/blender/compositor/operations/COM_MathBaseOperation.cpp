@@ -33,6 +33,7 @@ MathBaseOperation::MathBaseOperation() : NodeOperation()
 	this->m_inputValue1Operation = NULL;
 	this->m_inputValue2Operation = NULL;
 	this->m_useClamp = false;
+	this->setPixelOperation(true);
 }
 
 void MathBaseOperation::initExecution()
@@ -65,6 +66,17 @@ void MathBaseOperation::determineResolution(unsigned int resolution[2], unsigned
 	NodeOperation::determineResolution(resolution, preferredResolution);
 }
 
+void MathBaseOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+{
+	float inputValue1[4];
+	float inputValue2[4];
+
+	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
+	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
+
+	processPixel(output, inputValue1, inputValue2);
+}
+
 void MathBaseOperation::clampIfNeeded(float *color)
 {
 	if (this->m_useClamp) {
@@ -72,53 +84,29 @@ void MathBaseOperation::clampIfNeeded(float *color)
 	}
 }
 
-void MathAddOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathAddOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = inputValue1[0] + inputValue2[0];
 
 	clampIfNeeded(output);
 }
 
-void MathSubtractOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathSubtractOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = inputValue1[0] - inputValue2[0];
 
 	clampIfNeeded(output);
 }
 
-void MathMultiplyOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathMultiplyOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = inputValue1[0] * inputValue2[0];
 
 	clampIfNeeded(output);
 }
 
-void MathDivideOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathDivideOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	if (inputValue2[0] == 0) /* We don't want to divide by zero. */
 		output[0] = 0.0;
 	else
@@ -127,53 +115,29 @@ void MathDivideOperation::executePixel(float output[4], float x, float y, PixelS
 	clampIfNeeded(output);
 }
 
-void MathSineOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathSineOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = sin(inputValue1[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathCosineOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathCosineOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = cos(inputValue1[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathTangentOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathTangentOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = tan(inputValue1[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathArcSineOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathArcSineOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	if (inputValue1[0] <= 1 && inputValue1[0] >= -1)
 		output[0] = asin(inputValue1[0]);
 	else
@@ -182,14 +146,8 @@ void MathArcSineOperation::executePixel(float output[4], float x, float y, Pixel
 	clampIfNeeded(output);
 }
 
-void MathArcCosineOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathArcCosineOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	if (inputValue1[0] <= 1 && inputValue1[0] >= -1)
 		output[0] = acos(inputValue1[0]);
 	else
@@ -198,27 +156,15 @@ void MathArcCosineOperation::executePixel(float output[4], float x, float y, Pix
 	clampIfNeeded(output);
 }
 
-void MathArcTangentOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathArcTangentOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = atan(inputValue1[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathPowerOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathPowerOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	if (inputValue1[0] >= 0) {
 		output[0] = pow(inputValue1[0], inputValue2[0]);
 	}
@@ -236,14 +182,8 @@ void MathPowerOperation::executePixel(float output[4], float x, float y, PixelSa
 	clampIfNeeded(output);
 }
 
-void MathLogarithmOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathLogarithmOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	if (inputValue1[0] > 0  && inputValue2[0] > 0)
 		output[0] = log(inputValue1[0]) / log(inputValue2[0]);
 	else
@@ -252,79 +192,43 @@ void MathLogarithmOperation::executePixel(float output[4], float x, float y, Pix
 	clampIfNeeded(output);
 }
 
-void MathMinimumOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathMinimumOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = min(inputValue1[0], inputValue2[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathMaximumOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathMaximumOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = max(inputValue1[0], inputValue2[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathRoundOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathRoundOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = round(inputValue1[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathLessThanOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathLessThanOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = inputValue1[0] < inputValue2[0] ? 1.0f : 0.0f;
 
 	clampIfNeeded(output);
 }
 
-void MathGreaterThanOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathGreaterThanOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	output[0] = inputValue1[0] > inputValue2[0] ? 1.0f : 0.0f;
 
 	clampIfNeeded(output);
 }
 
-void MathModuloOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MathModuloOperation::processPixel(float output[4], float inputValue1[4], float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->read(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->read(inputValue2, x, y, sampler);
-	
 	if (inputValue2[0] == 0)
 		output[0] = 0.0;
 	else
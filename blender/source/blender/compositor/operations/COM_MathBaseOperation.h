@@ -46,11 +46,28 @@ protected:
 	MathBaseOperation();
 
 	void clampIfNeeded(float color[4]);
+
+	/**
+	 * calculate rows of the inputs with processPixel of the given subclass,
+	 * called without virtual dispatch so it can be inlined in the loop
+	 */
+	template<typename T> inline void processInputRows(T *operation, float *output, float **inputs, int length)
+	{
+		for (int i = 0; i < length; i++) {
+			const int offset = i * COM_NUMBER_OF_CHANNELS;
+			operation->T::processPixel(output + offset, inputs[0] + offset, inputs[1] + offset);
+		}
+	}
 public:
 	/**
 	 * the inner loop of this program
 	 */
-	void executePixel(float output[4], float x, float y, PixelSampler sampler) = 0;
+	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+
+	/**
+	 * calculate a single pixel from the input values, implemented by each math function
+	 */
+	virtual void processPixel(float output[4], float inputValue1[4], float inputValue2[4]) = 0;
 	
 	/**
 	 * Initialize the execution
@@ -73,94 +90,112 @@ public:
 class MathAddOperation : public MathBaseOperation {
 public:
 	MathAddOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathSubtractOperation : public MathBaseOperation {
 public:
 	MathSubtractOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathMultiplyOperation : public MathBaseOperation {
 public:
 	MathMultiplyOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathDivideOperation : public MathBaseOperation {
 public:
 	MathDivideOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathSineOperation : public MathBaseOperation {
 public:
 	MathSineOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathCosineOperation : public MathBaseOperation {
 public:
 	MathCosineOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathTangentOperation : public MathBaseOperation {
 public:
 	MathTangentOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MathArcSineOperation : public MathBaseOperation {
 public:
 	MathArcSineOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathArcCosineOperation : public MathBaseOperation {
 public:
 	MathArcCosineOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathArcTangentOperation : public MathBaseOperation {
 public:
 	MathArcTangentOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathPowerOperation : public MathBaseOperation {
 public:
 	MathPowerOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathLogarithmOperation : public MathBaseOperation {
 public:
 	MathLogarithmOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathMinimumOperation : public MathBaseOperation {
 public:
 	MathMinimumOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathMaximumOperation : public MathBaseOperation {
 public:
 	MathMaximumOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathRoundOperation : public MathBaseOperation {
 public:
 	MathRoundOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathLessThanOperation : public MathBaseOperation {
 public:
 	MathLessThanOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 class MathGreaterThanOperation : public MathBaseOperation {
 public:
 	MathGreaterThanOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MathModuloOperation : public MathBaseOperation {
 public:
 	MathModuloOperation() : MathBaseOperation() {}
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue1[4], float inputValue2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 #endif
@@ -39,6 +39,7 @@ MixBaseOperation::MixBaseOperation() : NodeOperation()
 	this->m_inputColor2Operation = NULL;
 	this->setUseValueAlphaMultiply(false);
 	this->setUseClamp(false);
+	this->setPixelOperation(true);
 }
 
 void MixBaseOperation::initExecution()
@@ -48,16 +49,8 @@ void MixBaseOperation::initExecution()
 	this->m_inputColor2Operation = this->getInputSocketReader(2);
 }
 
-void MixBaseOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixBaseOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-	
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-	
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -100,14 +93,7 @@ void MixBaseOperation::deinitExecution()
 	this->m_inputColor2Operation = NULL;
 }
 
-/* ******** Mix Add Operation ******** */
-
-MixAddOperation::MixAddOperation() : MixBaseOperation()
-{
-	/* pass */
-}
-
-void MixAddOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixBaseOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputColor1[4];
 	float inputColor2[4];
@@ -117,6 +103,18 @@ void MixAddOperation::executePixel(float output[4], float x, float y, PixelSampl
 	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
 	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
 
+	processPixel(output, inputValue, inputColor1, inputColor2);
+}
+
+/* ******** Mix Add Operation ******** */
+
+MixAddOperation::MixAddOperation() : MixBaseOperation()
+{
+	/* pass */
+}
+
+void MixAddOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
+{
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -136,16 +134,10 @@ MixBlendOperation::MixBlendOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixBlendOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixBlendOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
 	float value;
 
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
 	value = inputValue[0];
 	
 	if (this->useValueAlphaMultiply()) {
@@ -167,16 +159,10 @@ MixBurnOperation::MixBurnOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixBurnOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixBurnOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
 	float tmp;
 
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
 
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
@@ -235,16 +221,8 @@ MixColorOperation::MixColorOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixColorOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixColorOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -277,16 +255,8 @@ MixDarkenOperation::MixDarkenOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixDarkenOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixDarkenOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -315,16 +285,8 @@ MixDifferenceOperation::MixDifferenceOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixDifferenceOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixDifferenceOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -345,16 +307,8 @@ MixDivideOperation::MixDivideOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixDivideOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixDivideOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -386,16 +340,10 @@ MixDodgeOperation::MixDodgeOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixDodgeOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixDodgeOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
 	float tmp;
 
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
 
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
@@ -459,16 +407,10 @@ MixGlareOperation::MixGlareOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixGlareOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixGlareOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
 	float value;
 
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
 	value = inputValue[0];
 	float mf = 2.f - 2.f * fabsf(value - 0.5f);
 
@@ -491,16 +433,8 @@ MixHueOperation::MixHueOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixHueOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixHueOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -533,16 +467,8 @@ MixLightenOperation::MixLightenOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixLightenOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixLightenOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -569,16 +495,8 @@ MixLinearLightOperation::MixLinearLightOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixLinearLightOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixLinearLightOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -608,16 +526,8 @@ MixMultiplyOperation::MixMultiplyOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixMultiplyOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixMultiplyOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -638,16 +548,8 @@ MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixOverlayOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixOverlayOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -685,16 +587,8 @@ MixSaturationOperation::MixSaturationOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixSaturationOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixSaturationOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -724,16 +618,8 @@ MixScreenOperation::MixScreenOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixScreenOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixScreenOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -755,16 +641,8 @@ MixSoftLightOperation::MixSoftLightOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixSoftLightOperation::executePixel(float output[4], float x, float y, PixelSampler sampler) \
+void MixSoftLightOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -792,16 +670,8 @@ MixSubtractOperation::MixSubtractOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixSubtractOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixSubtractOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue,   x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1,   x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2,   x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -821,16 +691,8 @@ MixValueOperation::MixValueOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixValueOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
+void MixValueOperation::processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->read(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->read(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->read(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -50,6 +50,18 @@ protected:
 			CLAMP(color[3], 0.0f, 1.0f);
 		}
 	}
+
+	/**
+	 * mix rows of the inputs with processPixel of the given subclass,
+	 * called without virtual dispatch so it can be inlined in the loop
+	 */
+	template<typename T> inline void processInputRows(T *operation, float *output, float **inputs, int length)
+	{
+		for (int i = 0; i < length; i++) {
+			const int offset = i * COM_NUMBER_OF_CHANNELS;
+			operation->T::processPixel(output + offset, inputs[0] + offset, inputs[1] + offset, inputs[2] + offset);
+		}
+	}
 	
 public:
 	/**
@@ -61,6 +73,12 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
+
+	/**
+	 * mix a single pixel from the input values, implemented by each mix type
+	 */
+	virtual void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
 	
 	/**
 	 * Initialize the execution
@@ -83,115 +101,134 @@ public:
 class MixAddOperation : public MixBaseOperation {
 public:
 	MixAddOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixBlendOperation : public MixBaseOperation {
 public:
 	MixBlendOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixBurnOperation : public MixBaseOperation {
 public:
 	MixBurnOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixColorOperation : public MixBaseOperation {
 public:
 	MixColorOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixDarkenOperation : public MixBaseOperation {
 public:
 	MixDarkenOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixDifferenceOperation : public MixBaseOperation {
 public:
 	MixDifferenceOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixDivideOperation : public MixBaseOperation {
 public:
 	MixDivideOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixDodgeOperation : public MixBaseOperation {
 public:
 	MixDodgeOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixGlareOperation : public MixBaseOperation {
 public:
 	MixGlareOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixHueOperation : public MixBaseOperation {
 public:
 	MixHueOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixLightenOperation : public MixBaseOperation {
 public:
 	MixLightenOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixLinearLightOperation : public MixBaseOperation {
 public:
 	MixLinearLightOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixMultiplyOperation : public MixBaseOperation {
 public:
 	MixMultiplyOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixOverlayOperation : public MixBaseOperation {
 public:
 	MixOverlayOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixSaturationOperation : public MixBaseOperation {
 public:
 	MixSaturationOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixScreenOperation : public MixBaseOperation {
 public:
 	MixScreenOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixSoftLightOperation : public MixBaseOperation {
 public:
 	MixSoftLightOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixSubtractOperation : public MixBaseOperation {
 public:
 	MixSubtractOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 class MixValueOperation : public MixBaseOperation {
 public:
 	MixValueOperation();
-	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processPixel(float output[4], float inputValue[4], float inputColor1[4], float inputColor2[4]);
+	void processRow(float *output, float **inputs, int length) { processInputRows(this, output, inputs, length); }
 };
 
 #endif
@@ -30,11 +30,44 @@ ReadBufferOperation::ReadBufferOperation() : NodeOperation()
 	this->m_single_value = false;
 	this->m_offset = 0;
 	this->m_buffer = NULL;
+	this->m_fullBuffer = NULL;
+	this->setRowOperation(true);
+}
+
+void ReadBufferOperation::initExecution()
+{
+	initMutex();
+}
+
+void ReadBufferOperation::deinitExecution()
+{
+	releaseFullBuffer();
+	deinitMutex();
 }
 
 void *ReadBufferOperation::initializeTileData(rcti *rect)
 {
-	return m_buffer;
+	if (this->m_buffer == NULL || this->m_buffer->isFullBuffer()) {
+		return this->m_buffer;
+	}
+
+	/* complex operations access the data directly, expand compact buffers when the first tile needs them */
+	lockMutex();
+	if (this->m_fullBuffer == NULL) {
+		this->m_fullBuffer = new MemoryBuffer(this->m_memoryProxy, this->m_buffer->getRect());
+		this->m_fullBuffer->copyContentFrom(this->m_buffer);
+	}
+	unlockMutex();
+
+	return this->m_fullBuffer;
+}
+
+void ReadBufferOperation::releaseFullBuffer()
+{
+	if (this->m_fullBuffer) {
+		delete this->m_fullBuffer;
+		this->m_fullBuffer = NULL;
+	}
 }
 
 void ReadBufferOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
@@ -92,6 +125,19 @@ void ReadBufferOperation::executePixel(float output[4], float x, float y, float
 	}
 }
 
+void ReadBufferOperation::executeRow(float *output, int x, int y, int length)
+{
+	if (m_single_value) {
+		/* write buffer has a single value stored at (0,0) */
+		for (int i = 0; i < length; i++) {
+			m_buffer->read(output + i * COM_NUMBER_OF_CHANNELS, 0, 0);
+		}
+	}
+	else {
+		m_buffer->readRow(output, x, y, length);
+	}
+}
+
 bool ReadBufferOperation::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
 {
 	if (this == readOperation) {
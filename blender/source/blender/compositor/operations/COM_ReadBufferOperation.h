@@ -32,6 +32,7 @@ private:
 	bool m_single_value; /* single value stored in buffer, copied from associated write operation */
 	unsigned int m_offset;
 	MemoryBuffer *m_buffer;
+	MemoryBuffer *m_fullBuffer; /* full layout copy of a compact m_buffer, for complex operations */
 public:
 	ReadBufferOperation();
 	int isBufferOperation() { return true; }
@@ -39,11 +40,14 @@ public:
 	MemoryProxy *getMemoryProxy() { return this->m_memoryProxy; }
 	void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 	
+	void initExecution();
+	void deinitExecution();
 	void *initializeTileData(rcti *rect);
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
 	void executePixelExtend(float output[4], float x, float y, PixelSampler sampler,
 	                        MemoryBufferExtend extend_x, MemoryBufferExtend extend_y);
 	void executePixel(float output[4], float x, float y, float dx, float dy, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int length);
 	const bool isReadBufferOperation() const { return true; }
 	void setOffset(unsigned int offset) { this->m_offset = offset; }
 	unsigned int getOffset() const { return this->m_offset; }
@@ -51,6 +55,11 @@ public:
 	MemoryBuffer *getInputMemoryBuffer(MemoryBuffer **memoryBuffers) { return memoryBuffers[this->m_offset]; }
 	void readResolutionFromWriteBuffer();
 	void updateMemoryBuffer();
+	
+	/**
+	 * @brief free the full copy of a compact buffer, after the complex operation reading it finished
+	 */
+	void releaseFullBuffer();
 };
 
 #endif
@@ -30,6 +30,7 @@ SetAlphaOperation::SetAlphaOperation() : NodeOperation()
 	
 	this->m_inputColor = NULL;
 	this->m_inputAlpha = NULL;
+	this->setPixelOperation(true);
 }
 
 void SetAlphaOperation::initExecution()
@@ -48,6 +49,15 @@ void SetAlphaOperation::executePixel(float output[4], float x, float y, PixelSam
 	output[3] = alphaInput[0];
 }
 
+void SetAlphaOperation::processRow(float *output, float **inputs, int length)
+{
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUMBER_OF_CHANNELS;
+		copy_v3_v3(output + offset, inputs[0] + offset);
+		output[offset + 3] = inputs[1][offset];
+	}
+}
+
 void SetAlphaOperation::deinitExecution()
 {
 	this->m_inputColor = NULL;
@@ -44,6 +44,7 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixel(float output[4], float x, float y, PixelSampler sampler);
+	void processRow(float *output, float **inputs, int length);
 	
 	void initExecution();
 	void deinitExecution();
@@ -25,6 +25,7 @@
 SetColorOperation::SetColorOperation() : NodeOperation()
 {
 	this->addOutputSocket(COM_DT_COLOR);
+	this->setRowOperation(true);
 }
 
 void SetColorOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
@@ -32,6 +33,13 @@ void SetColorOperation::executePixel(float output[4], float x, float y, PixelSam
 	copy_v4_v4(output, this->m_color);
 }
 
+void SetColorOperation::executeRow(float *output, int x, int y, int length)
+{
+	for (int i = 0; i < length; i++) {
+		copy_v4_v4(output + i * COM_NUMBER_OF_CHANNELS, this->m_color);
+	}
+}
+
 void SetColorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
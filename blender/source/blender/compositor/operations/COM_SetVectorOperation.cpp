@@ -26,6 +26,7 @@
 SetVectorOperation::SetVectorOperation() : NodeOperation()
 {
 	this->addOutputSocket(COM_DT_VECTOR);
+	this->setRowOperation(true);
 }
 
 void SetVectorOperation::executePixel(float output[4], float x, float y, PixelSampler sampler)
@@ -36,6 +37,17 @@ void SetVectorOperation::executePixel(float output[4], float x, float y, PixelSa
 	output[3] = this->m_w;
 }
 
+void SetVectorOperation::executeRow(float *output, int x, int y, int length)
+{
+	for (int i = 0; i < length; i++) {
+		float *vector = output + i * COM_NUMBER_OF_CHANNELS;
+		vector[0] = this->m_x;
+		vector[1] = this->m_y;
+		vector[2] = this->m_z;
+		vector[3] = this->m_w;
+	}
+}
+
 void SetVectorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
@@ -26,6 +26,8 @@
 WrapOperation::WrapOperation() : ReadBufferOperation()
 {
 	this->m_wrappingType = CMP_NODE_WRAP_NONE;
+	/* reads are wrapped per pixel */
+	this->setRowOperation(false);
 }
 
 inline float WrapOperation::getWrappedOriginalXPos(float x)
@@ -31,6 +31,8 @@ WriteBufferOperation::WriteBufferOperation() : NodeOperation()
 	this->m_memoryProxy = new MemoryProxy();
 	this->m_memoryProxy->setWriteBufferOperation(this);
 	this->m_memoryProxy->setExecutor(NULL);
+	this->m_pixelProgram = NULL;
+	this->setRowOperation(true);
 }
 WriteBufferOperation::~WriteBufferOperation()
 {
@@ -48,7 +50,9 @@ void WriteBufferOperation::executePixel(float output[4], float x, float y, Pixel
 void WriteBufferOperation::initExecution()
 {
 	this->m_input = this->getInputOperation(0);
-	this->m_memoryProxy->allocate(this->m_width, this->m_height);
+	if (!this->m_memoryProxy->isCached()) {
+		this->m_memoryProxy->allocate(this->m_width, this->m_height);
+	}
 }
 
 void WriteBufferOperation::deinitExecution()
@@ -60,7 +64,9 @@ void WriteBufferOperation::deinitExecution()
 void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 {
 	MemoryBuffer *memoryBuffer = this->m_memoryProxy->getBuffer();
-	float *buffer = memoryBuffer->getBuffer();
+	/* compact buffers are written per pixel, converting the channels */
+	float *buffer = (memoryBuffer->isFullBuffer()) ? memoryBuffer->getBuffer() : NULL;
+	float color[4];
 	if (this->m_input->isComplex()) {
 		void *data = this->m_input->initializeTileData(rect);
 		int x1 = rect->xmin;
@@ -73,7 +79,13 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 		for (y = y1; y < y2 && (!breaked); y++) {
 			int offset4 = (y * memoryBuffer->getWidth() + x1) * COM_NUMBER_OF_CHANNELS;
 			for (x = x1; x < x2; x++) {
-				this->m_input->read(&(buffer[offset4]), x, y, data);
+				if (buffer) {
+					this->m_input->read(&(buffer[offset4]), x, y, data);
+				}
+				else {
+					this->m_input->read(color, x, y, data);
+					memoryBuffer->writePixel(x, y, color);
+				}
 				offset4 += COM_NUMBER_OF_CHANNELS;
 			}
 			if (isBreaked()) {
@@ -98,7 +110,13 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 		for (y = y1; y < y2 && (!breaked); y++) {
 			int offset4 = (y * memoryBuffer->getWidth() + x1) * COM_NUMBER_OF_CHANNELS;
 			for (x = x1; x < x2; x++) {
-				this->m_input->read(&(buffer[offset4]), x, y, COM_PS_NEAREST);
+				if (buffer) {
+					this->m_input->read(&(buffer[offset4]), x, y, COM_PS_NEAREST);
+				}
+				else {
+					this->m_input->read(color, x, y, COM_PS_NEAREST);
+					memoryBuffer->writePixel(x, y, color);
+				}
 				offset4 += COM_NUMBER_OF_CHANNELS;
 			}
 			if (isBreaked()) {
@@ -109,6 +127,46 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int tileNumber)
 	memoryBuffer->setCreatedState();
 }
 
+void WriteBufferOperation::executeRowRegion(rcti *rect, unsigned int tileNumber)
+{
+	MemoryBuffer *memoryBuffer = this->m_memoryProxy->getBuffer();
+	/* compact buffers are written through a row, converting the channels */
+	float *buffer = (memoryBuffer->isFullBuffer()) ? memoryBuffer->getBuffer() : NULL;
+	float row[COM_ROW_BUFFER_SIZE];
+	int x1 = rect->xmin;
+	int y1 = rect->ymin;
+	int x2 = rect->xmax;
+	int y2 = rect->ymax;
+	int x;
+	int y;
+	bool breaked = false;
+	PixelProgram *program = this->m_pixelProgram;
+	float *registers = (program) ? program->allocateRegisters() : NULL;
+	for (y = y1; y < y2 && (!breaked); y++) {
+		for (x = x1; x < x2; x += COM_ROW_LENGTH) {
+			int offset4 = (y * memoryBuffer->getWidth() + x) * COM_NUMBER_OF_CHANNELS;
+			int length = min(x2 - x, COM_ROW_LENGTH);
+			float *output = (buffer) ? &(buffer[offset4]) : row;
+			if (program) {
+				program->executeRow(registers, output, x, y, length);
+			}
+			else {
+				this->m_input->readRow(output, x, y, length);
+			}
+			if (!buffer) {
+				memoryBuffer->writeRow(row, x, y, length);
+			}
+		}
+		if (isBreaked()) {
+			breaked = true;
+		}
+	}
+	if (registers) {
+		program->freeRegisters(registers);
+	}
+	memoryBuffer->setCreatedState();
+}
+
 void WriteBufferOperation::executeOpenCLRegion(OpenCLDevice *device, rcti *rect, unsigned int chunkNumber,
                                                MemoryBuffer **inputMemoryBuffers, MemoryBuffer *outputBuffer)
 {
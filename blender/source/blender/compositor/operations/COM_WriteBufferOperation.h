@@ -26,6 +26,7 @@
 #include "COM_NodeOperation.h"
 #include "COM_MemoryProxy.h"
 #include "COM_SocketReader.h"
+#include "COM_PixelProgram.h"
 /**
  * @brief Operation to write to a tile
  * @ingroup Operation
@@ -34,6 +35,7 @@ class WriteBufferOperation : public NodeOperation {
 	MemoryProxy *m_memoryProxy;
 	bool m_single_value; /* single value stored in buffer */
 	NodeOperation *m_input;
+	PixelProgram *m_pixelProgram; /* fused input operations, owned by the ExecutionGroup */
 public:
 	WriteBufferOperation();
 	~WriteBufferOperation();
@@ -44,6 +46,7 @@ public:
 	bool isSingleValue() const { return m_single_value; }
 	
 	void executeRegion(rcti *rect, unsigned int tileNumber);
+	void executeRowRegion(rcti *rect, unsigned int tileNumber);
 	void initExecution();
 	void deinitExecution();
 	void executeOpenCLRegion(OpenCLDevice *device, rcti *rect, unsigned int chunkNumber, MemoryBuffer **memoryBuffers, MemoryBuffer *outputBuffer);
@@ -52,6 +55,7 @@ public:
 	inline NodeOperation *getInput() {
 		return m_input;
 	}
+	void setPixelProgram(PixelProgram *program) { this->m_pixelProgram = program; }
 
 };
 #endif